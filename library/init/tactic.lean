@@ -91,6 +91,14 @@ opaque definition change (e : expr) : tactic := builtin
 
 opaque definition assert_hypothesis (id : expr) (e : expr) : tactic := builtin
 
+inductive tactic_list : Type :=
+| nil  : tactic_list
+| cons : tactic → tactic_list → tactic_list
+
+-- portfolio_tac is just a marker for the builtin 'portfolio' notation: portfolio [t_1, ..., t_n]
+-- The tactics are executed in parallel, and the first one that succeeds is used.
+opaque definition portfolio_tac (ts : tactic_list) : tactic := builtin
+
 infixl `;`:15 := and_then
 notation `[` h `|` r:(foldl `|` (e r, or_else r e) h) `]` := r
 
@@ -21,6 +21,7 @@ Author: Leonardo de Moura
 #include "library/coercion.h"
 #include "library/reducible.h"
 #include "library/normalize.h"
+#include "library/vm.h"
 #include "library/print.h"
 #include "library/class.h"
 #include "library/flycheck.h"
@@ -351,12 +352,16 @@ public:
 environment eval_cmd(parser & p) {
     bool whnf   = false;
     bool all_transparent = false;
+    bool vm     = false;
     if (p.curr_is_token(get_whnf_tk())) {
         p.next();
         whnf = true;
     } else if (p.curr_is_token(get_all_transparent_tk())) {
         p.next();
         all_transparent = true;
+    } else if (p.curr_is_token(get_vm_tk())) {
+        p.next();
+        vm = true;
     }
     expr e; level_param_names ls;
     std::tie(e, ls) = parse_local_expr(p);
@@ -368,6 +373,8 @@ environment eval_cmd(parser & p) {
         type_checker tc(p.env(), name_generator(),
                         std::unique_ptr<converter>(new all_transparent_converter(p.env())));
         r = normalize(tc, ls, e);
+    } else if (vm) {
+        r = vm_eval(p.env(), e);
     } else {
         r = normalize(p.env(), ls, e);
     }
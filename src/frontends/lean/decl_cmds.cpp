@@ -27,6 +27,7 @@ Author: Leonardo de Moura
 #include "library/abbreviation.h"
 #include "library/unfold_macros.h"
 #include "library/definitional/equations.h"
+#include "library/definitional/checked_decls.h"
 #include "frontends/lean/parser.h"
 #include "frontends/lean/util.h"
 #include "frontends/lean/tokens.h"
@@ -945,13 +946,13 @@ class definition_cmd_fn {
                     c_type  = expand_abbreviations(m_env, unfold_untrusted_macros(m_env, c_type));
                     c_value = expand_abbreviations(m_env, unfold_untrusted_macros(m_env, c_value));
                     if (m_kind == Theorem) {
-                        cd = check(m_env, mk_theorem(m_real_name, c_ls, c_type, c_value));
+                        cd = check_aux_decl(m_env, mk_theorem(m_real_name, c_ls, c_type, c_value));
                         if (!m_p.keep_new_thms()) {
                             // discard theorem
                             cd = check(m_env, mk_axiom(m_real_name, c_ls, c_type));
                         }
                     } else {
-                        cd = check(m_env, mk_definition(m_env, m_real_name, c_ls, c_type, c_value, m_is_opaque));
+                        cd = check_aux_decl(m_env, mk_definition(m_env, m_real_name, c_ls, c_type, c_value, m_is_opaque));
                     }
                     if (!m_is_private)
                         m_p.add_decl_index(m_real_name, m_pos, m_p.get_cmd_token(), c_type);
@@ -1039,16 +1040,16 @@ class definition_cmd_fn {
             aux_values[i]  = expand_abbreviations(m_env, unfold_untrusted_macros(m_env, aux_values[i]));
         }
         if (is_definition()) {
-            m_env = module::add(m_env, check(m_env, mk_definition(m_env, m_real_name, new_ls,
-                                                                  m_type, m_value, m_is_opaque)));
+            m_env = module::add(m_env, check_aux_decl(m_env, mk_definition(m_env, m_real_name, new_ls,
+                                                                           m_type, m_value, m_is_opaque)));
             for (unsigned i = 0; i < aux_values.size(); i++)
-                m_env = module::add(m_env, check(m_env, mk_definition(m_env, m_real_aux_names[i], new_ls,
-                                                                      m_aux_types[i], aux_values[i], m_is_opaque)));
+                m_env = module::add(m_env, check_aux_decl(m_env, mk_definition(m_env, m_real_aux_names[i], new_ls,
+                                                                               m_aux_types[i], aux_values[i], m_is_opaque)));
         } else {
-            m_env = module::add(m_env, check(m_env, mk_theorem(m_real_name, new_ls, m_type, m_value)));
+            m_env = module::add(m_env, check_aux_decl(m_env, mk_theorem(m_real_name, new_ls, m_type, m_value)));
             for (unsigned i = 0; i < aux_values.size(); i++)
-                m_env = module::add(m_env, check(m_env, mk_theorem(m_real_aux_names[i], new_ls,
-                                                                   m_aux_types[i], aux_values[i])));
+                m_env = module::add(m_env, check_aux_decl(m_env, mk_theorem(m_real_aux_names[i], new_ls,
+                                                                            m_aux_types[i], aux_values[i])));
         }
     }
 
@@ -1070,9 +1071,11 @@ class definition_cmd_fn {
                 m_ls = append(m_ls, new_ls);
                 m_type = expand_abbreviations(m_env, unfold_untrusted_macros(m_env, m_type));
                 expr type_as_is = m_p.save_pos(mk_as_is(m_type), type_pos);
-                if (!m_p.collecting_info() && m_kind == Theorem && m_p.num_threads() > 1) {
+                if (m_kind == Theorem && m_p.num_threads() > 1) {
                     // Add as axiom, and create a task to prove the theorem.
                     // Remark: we don't postpone the "proof" of Examples.
+                    // Remark: the info_manager is thread safe, then the task may also collect information
+                    // for the lean server.
                     m_p.add_delayed_theorem(m_env, m_real_name, m_ls, type_as_is, m_value);
                     m_env = module::add(m_env, check(m_env, mk_axiom(m_real_name, m_ls, m_type)));
                 } else {
@@ -1080,7 +1083,7 @@ class definition_cmd_fn {
                     m_type  = expand_abbreviations(m_env, unfold_untrusted_macros(m_env, m_type));
                     m_value = expand_abbreviations(m_env, unfold_untrusted_macros(m_env, m_value));
                     new_ls = append(m_ls, new_ls);
-                    auto cd = check(m_env, mk_theorem(m_real_name, new_ls, m_type, m_value));
+                    auto cd = check_aux_decl(m_env, mk_theorem(m_real_name, new_ls, m_type, m_value));
                     if (m_kind == Theorem) {
                         // Remark: we don't keep examples
                         if (!m_p.keep_new_thms()) {
@@ -1096,8 +1099,8 @@ class definition_cmd_fn {
                 new_ls = append(m_ls, new_ls);
                 m_type  = expand_abbreviations(m_env, unfold_untrusted_macros(m_env, m_type));
                 m_value = expand_abbreviations(m_env, unfold_untrusted_macros(m_env, m_value));
-                m_env = module::add(m_env, check(m_env, mk_definition(m_env, m_real_name, new_ls,
-                                                                      m_type, m_value, m_is_opaque)));
+                m_env = module::add(m_env, check_aux_decl(m_env, mk_definition(m_env, m_real_name, new_ls,
+                                                                               m_type, m_value, m_is_opaque)));
                 m_p.cache_definition(m_real_name, pre_type, pre_value, new_ls, m_type, m_value);
             }
         }
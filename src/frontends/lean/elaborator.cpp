@@ -36,6 +36,7 @@ Author: Leonardo de Moura
 #include "library/util.h"
 #include "library/choice_iterator.h"
 #include "library/pp_options.h"
+#include "library/vm.h"
 #include "library/tactic/expr_to_tactic.h"
 #include "library/tactic/class_instance_synth.h"
 #include "library/error_handling/error_handling.h"
@@ -117,8 +118,17 @@ elaborator::elaborator(elaborator_context & ctx, name_generator const & ngen, bo
     m_use_tactic_hints  = true;
     m_no_info           = false;
     m_in_equation_lhs   = false;
-    m_tc[0]             = mk_type_checker(ctx.m_env, m_ngen.mk_child(), false);
-    m_tc[1]             = mk_type_checker(ctx.m_env, m_ngen.mk_child(), true);
+    if (ctx.m_use_vm) {
+        for (unsigned i = 0; i < 2; i++) {
+            bool relax = i == 1;
+            std::unique_ptr<converter> conv(new unfold_semireducible_converter(ctx.m_env, relax, true));
+            m_tc[i] = type_checker_ptr(new type_checker(ctx.m_env, m_ngen.mk_child(),
+                                                        mk_vm_converter(ctx.m_env, std::move(conv))));
+        }
+    } else {
+        m_tc[0]         = mk_type_checker(ctx.m_env, m_ngen.mk_child(), false);
+        m_tc[1]         = mk_type_checker(ctx.m_env, m_ngen.mk_child(), true);
+    }
     m_nice_mvar_names   = nice_mvar_names;
 }
 
@@ -23,6 +23,10 @@ Author: Leonardo de Moura
 #define LEAN_DEFAULT_ELABORATOR_FAIL_MISSING_FIELD false
 #endif
 
+#ifndef LEAN_DEFAULT_ELABORATOR_USE_VM
+#define LEAN_DEFAULT_ELABORATOR_USE_VM false
+#endif
+
 namespace lean {
 // ==========================================
 // elaborator configuration options
@@ -30,6 +34,7 @@ static name * g_elaborator_local_instances    = nullptr;
 static name * g_elaborator_ignore_instances   = nullptr;
 static name * g_elaborator_flycheck_goals     = nullptr;
 static name * g_elaborator_fail_missing_field = nullptr;
+static name * g_elaborator_use_vm             = nullptr;
 
 name const & get_elaborator_ignore_instances_name() {
     return *g_elaborator_ignore_instances;
@@ -51,6 +56,10 @@ bool get_elaborator_fail_missing_field(options const & opts) {
     return opts.get_bool(*g_elaborator_fail_missing_field, LEAN_DEFAULT_ELABORATOR_FAIL_MISSING_FIELD);
 }
 
+bool get_elaborator_use_vm(options const & opts) {
+    return opts.get_bool(*g_elaborator_use_vm, LEAN_DEFAULT_ELABORATOR_USE_VM);
+}
+
 // ==========================================
 
 elaborator_context::elaborator_context(environment const & env, io_state const & ios, local_decls<level> const & lls,
@@ -60,6 +69,7 @@ elaborator_context::elaborator_context(environment const & env, io_state const &
     m_ignore_instances    = get_elaborator_ignore_instances(ios.get_options());
     m_flycheck_goals      = get_elaborator_flycheck_goals(ios.get_options());
     m_fail_missing_field  = get_elaborator_fail_missing_field(ios.get_options());
+    m_use_vm              = get_elaborator_use_vm(ios.get_options());
 }
 
 void initialize_elaborator_context() {
@@ -67,6 +77,7 @@ void initialize_elaborator_context() {
     g_elaborator_ignore_instances   = new name{"elaborator", "ignore_instances"};
     g_elaborator_flycheck_goals     = new name{"elaborator", "flycheck_goals"};
     g_elaborator_fail_missing_field = new name{"elaborator", "fail_if_missing_field"};
+    g_elaborator_use_vm             = new name{"elaborator", "use_vm"};
     register_bool_option(*g_elaborator_local_instances, LEAN_DEFAULT_ELABORATOR_LOCAL_INSTANCES,
                          "(lean elaborator) use local declarates as class instances");
     register_bool_option(*g_elaborator_ignore_instances, LEAN_DEFAULT_ELABORATOR_IGNORE_INSTANCES,
@@ -77,11 +88,15 @@ void initialize_elaborator_context() {
     register_bool_option(*g_elaborator_fail_missing_field, LEAN_DEFAULT_ELABORATOR_FAIL_MISSING_FIELD,
                          "(lean elaborator) if true, then elaborator generates an error for missing fields instead "
                          "of adding placeholders");
+    register_bool_option(*g_elaborator_use_vm, LEAN_DEFAULT_ELABORATOR_USE_VM,
+                         "(lean elaborator) if true, then elaborator uses the bytecode evaluator to decide whether "
+                         "closed terms are definitionally equal");
 }
 void finalize_elaborator_context() {
     delete g_elaborator_local_instances;
     delete g_elaborator_ignore_instances;
     delete g_elaborator_flycheck_goals;
     delete g_elaborator_fail_missing_field;
+    delete g_elaborator_use_vm;
 }
 }
@@ -117,16 +117,27 @@ environment find_cmd(parser & p) {
     unsigned max_steps = get_find_max_steps(p.get_options());
     bool cheap         = !get_find_expensive(p.get_options());
     bool found = false;
-    env.for_each_declaration([&](declaration const & d) {
-            if (std::all_of(pos_names.begin(), pos_names.end(),
-                            [&](std::string const & pos) { return is_part_of(pos, d.get_name()); }) &&
-                std::all_of(neg_names.begin(), neg_names.end(),
-                            [&](std::string const & neg) { return !is_part_of(neg, d.get_name()); }) &&
-                match_pattern(*tc.get(), e, d, max_steps, cheap)) {
-                found = true;
-                p.regular_stream() << " " << get_decl_short_name(d.get_name(), env) << " : " << d.get_type() << endl;
-            }
-        });
+    decl_search_index & index = p.get_search_index();
+    index.update(env);
+    buffer<unsigned> candidates;
+    if (cheap) {
+        // constants are not unfolded, then only declarations whose conclusion has the same head may match
+        index.find_conclusion(e, candidates);
+    } else {
+        index.find_all(candidates);
+    }
+    index.filter(env, candidates);
+    for (unsigned i : candidates) {
+        declaration const & d = index.get_decl(i);
+        if (std::all_of(pos_names.begin(), pos_names.end(),
+                        [&](std::string const & pos) { return is_part_of(pos, d.get_name()); }) &&
+            std::all_of(neg_names.begin(), neg_names.end(),
+                        [&](std::string const & neg) { return !is_part_of(neg, d.get_name()); }) &&
+            match_pattern(*tc.get(), e, d, max_steps, cheap)) {
+            found = true;
+            p.regular_stream() << " " << get_decl_short_name(d.get_name(), env) << " : " << d.get_type() << endl;
+        }
+    }
     if (!found)
         p.regular_stream() << "no matches\n";
     return env;
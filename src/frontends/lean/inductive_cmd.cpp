@@ -28,6 +28,7 @@ Author: Leonardo de Moura
 #include "library/definitional/cases_on.h"
 #include "library/definitional/brec_on.h"
 #include "library/definitional/no_confusion.h"
+#include "library/definitional/checked_decls.h"
 #include "frontends/lean/decl_cmds.h"
 #include "frontends/lean/util.h"
 #include "frontends/lean/parser.h"
@@ -725,12 +726,51 @@ struct inductive_cmd_fn {
         }
     }
 
+    /**
+        \brief Create the auxiliary declarations (rec_on, cases_on, no_confusion, below, brec_on, ...) for the
+        given inductive datatypes.
+
+        When the parser is using more than one thread, the independent constructions are speculatively
+        executed in parallel before each of the two sequential loops (see \c precheck_aux_decls).
+        The sequential loops only type check the declarations that were not checked by the parallel ones.
+        Thus, the resulting environment and error messages do not depend on the number of threads.
+    */
     environment mk_aux_decls(environment env, buffer<inductive_decl> const & decls) {
         bool has_unit = has_unit_decls(env);
         bool has_eq   = has_eq_decls(env);
         bool has_heq  = has_heq_decls(env);
         bool has_prod = has_prod_decls(env);
         bool has_lift = has_lift_decls(env);
+        bool has_no_confusion = has_unit && has_eq && ((env.prop_proof_irrel() && has_heq) || (!env.prop_proof_irrel() && has_lift));
+        bool impredicative    = env.impredicative();
+        unsigned num_threads  = m_p.num_threads();
+        // reuse the set of checked declarations provided by the lean server (if available)
+        checked_decls local_checked;
+        checked_decls & checked = get_checked_decls() ? *get_checked_decls() : local_checked;
+        scoped_checked_decls scope(checked);
+        if (num_threads > 1) {
+            // rec_on/induction_on, cases_on/no_confusion, below and ibelow are independent of each other
+            buffer<aux_decl_fn> fns;
+            for (inductive_decl const & d : decls) {
+                name n = inductive_decl_name(d);
+                fns.push_back([=](environment const & env) {
+                        environment new_env = mk_rec_on(env, n);
+                        return impredicative ? mk_induction_on(new_env, n) : new_env;
+                    });
+                if (has_unit) {
+                    fns.push_back([=](environment const & env) {
+                            environment new_env = mk_cases_on(env, n);
+                            return has_no_confusion ? mk_no_confusion(new_env, n) : new_env;
+                        });
+                    if (has_prod) {
+                        fns.push_back([=](environment const & env) { return mk_below(env, n); });
+                        if (impredicative)
+                            fns.push_back([=](environment const & env) { return mk_ibelow(env, n); });
+                    }
+                }
+            }
+            precheck_aux_decls(env, fns, num_threads, checked);
+        }
         for (inductive_decl const & d : decls) {
             name const & n = inductive_decl_name(d);
             pos_info pos   = *m_decl_pos_map.find(n);
@@ -743,7 +783,7 @@ struct inductive_cmd_fn {
             if (has_unit) {
                 env = mk_cases_on(env, n);
                 save_def_info(name(n, "cases_on"), pos);
-                if (has_eq && ((env.prop_proof_irrel() && has_heq) || (!env.prop_proof_irrel() && has_lift))) {
+                if (has_no_confusion) {
                     env = mk_no_confusion(env, n);
                     save_if_defined(name{n, "no_confusion_type"}, pos);
                     save_if_defined(name(n, "no_confusion"), pos);
@@ -758,6 +798,17 @@ struct inductive_cmd_fn {
                 }
             }
         }
+        if (num_threads > 1 && has_unit && has_prod) {
+            // brec_on and binduction_on depend on below and ibelow for all datatypes being declared
+            buffer<aux_decl_fn> fns;
+            for (inductive_decl const & d : decls) {
+                name n = inductive_decl_name(d);
+                fns.push_back([=](environment const & env) { return mk_brec_on(env, n); });
+                if (impredicative)
+                    fns.push_back([=](environment const & env) { return mk_binduction_on(env, n); });
+            }
+            precheck_aux_decls(env, fns, num_threads, checked);
+        }
         for (inductive_decl const & d : decls) {
             name const & n = inductive_decl_name(d);
             pos_info pos   = *m_decl_pos_map.find(n);
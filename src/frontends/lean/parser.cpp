@@ -134,6 +134,10 @@ parser::~parser() {
         if (!m_theorem_queue.done()) {
             m_theorem_queue.interrupt();
             m_theorem_queue.join();
+            // The snapshots created after the first delayed theorem contain axioms that
+            // will not be replaced. We remove them, and the server restarts from an earlier one.
+            if (m_snapshot_vector && m_delayed_thms_snapshot && *m_delayed_thms_snapshot < m_snapshot_vector->size())
+                m_snapshot_vector->resize(*m_delayed_thms_snapshot);
         }
     } catch (...) {}
 }
@@ -712,14 +716,12 @@ auto parser::elaborate_definition(name const & n, expr const & t, expr const & v
     return r;
 }
 
-auto parser::elaborate_definition_at(environment const & env, local_level_decls const & lls,
-                                     name const & n, expr const & t, expr const & v, bool is_opaque)
+auto parser::elaborate_definition_at(environment const & env, io_state const & ios, local_level_decls const & lls,
+                                     parser_pos_provider const & pp, name const & n,
+                                     expr const & t, expr const & v, bool is_opaque) const
 -> std::tuple<expr, expr, level_param_names> {
-    parser_pos_provider pp = get_pos_provider();
-    elaborator_context eenv = mk_elaborator_context(env, lls, pp);
-    auto r = ::lean::elaborate(eenv, n, t, v, is_opaque);
-    m_pre_info_manager.clear();
-    return r;
+    elaborator_context eenv(env, ios, lls, &pp, m_info_manager, true);
+    return ::lean::elaborate(eenv, n, t, v, is_opaque);
 }
 
 [[ noreturn ]] void throw_invalid_open_binder(pos_info const & pos) {
@@ -1364,6 +1366,27 @@ expr parser::parse_tactic_expr_list() {
     return r;
 }
 
+/** \brief Parse <tt>[t_1, ..., t_n]</tt> after the \c portfolio identifier.
+    \remark \c portfolio is not a keyword, it is only handled in tactic blocks. */
+expr parser::parse_portfolio_tactic(pos_info const & pos) {
+    check_token_next(get_lbracket_tk(), "invalid portfolio tactic, '[' expected");
+    buffer<expr> ts;
+    while (true) {
+        ts.push_back(parse_tactic());
+        if (!curr_is_token(get_comma_tk()))
+            break;
+        next();
+    }
+    check_token_next(get_rbracket_tk(), "invalid portfolio tactic, ',' or ']' expected");
+    unsigned i = ts.size();
+    expr r = save_pos(mk_constant(get_tactic_tactic_list_nil_name()), pos);
+    while (i > 0) {
+        i--;
+        r = mk_app({save_pos(mk_constant(get_tactic_tactic_list_cons_name()), pos), ts[i], r}, pos);
+    }
+    return mk_app(save_pos(mk_constant(get_tactic_portfolio_tac_name()), pos), r, pos);
+}
+
 expr parser::parse_tactic_opt_expr_list() {
     if (curr_is_token(get_lbracket_tk())) {
         return parse_tactic_expr_list();
@@ -1397,6 +1420,9 @@ expr parser::parse_tactic_nud() {
                 type = binding_body(type);
             }
             return r;
+        } else if (id == get_portfolio_tk()) {
+            next();
+            return parse_portfolio_tactic(id_pos);
         } else {
             return parse_expr();
         }
@@ -1638,14 +1664,37 @@ bool parser::parse_commands() {
         while (has_open_scopes(m_env))
             m_env = pop_scope_core(m_env);
     }
+    join_delayed_theorems();
     commit_info(m_scanner.get_line()+1, 0);
-    for (certified_declaration const & thm : m_theorem_queue.join()) {
-        if (keep_new_thms())
-            m_env.replace(thm);
-    }
     return !m_found_errors;
 }
 
+/** \brief Replace with \c thm the axiom of the same name in \c env, if there is one. */
+static environment replace_delayed_theorem(environment const & env, certified_declaration const & thm) {
+    auto d = env.find(thm.get_declaration().get_name());
+    if (d && d->is_axiom())
+        return env.replace(thm);
+    return env;
+}
+
+void parser::join_delayed_theorems() {
+    std::vector<certified_declaration> const & thms = m_theorem_queue.join();
+    if (keep_new_thms()) {
+        for (certified_declaration const & thm : thms)
+            m_env = m_env.replace(thm);
+        // The axioms are also replaced in the snapshots, otherwise the server would restart from
+        // environments where the delayed theorems are still axioms.
+        if (m_snapshot_vector && m_delayed_thms_snapshot) {
+            for (unsigned i = *m_delayed_thms_snapshot; i < m_snapshot_vector->size(); i++) {
+                environment & env = (*m_snapshot_vector)[i].m_env;
+                for (certified_declaration const & thm : thms)
+                    env = replace_delayed_theorem(env, thm);
+            }
+        }
+    }
+    m_delayed_thms_snapshot = optional<unsigned>();
+}
+
 bool parser::curr_is_command_like() const {
     switch (curr()) {
     case scanner::token_kind::CommandKeyword:
@@ -1663,6 +1712,8 @@ bool parser::curr_is_command_like() const {
 
 void parser::add_delayed_theorem(environment const & env, name const & n, level_param_names const & ls,
                                  expr const & t, expr const & v) {
+    if (m_snapshot_vector && !m_delayed_thms_snapshot)
+        m_delayed_thms_snapshot = m_snapshot_vector->size();
     m_theorem_queue.add(env, n, ls, get_local_level_decls(), t, v);
 }
 
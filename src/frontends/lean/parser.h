@@ -23,6 +23,7 @@ Author: Leonardo de Moura
 #include "library/kernel_bindings.h"
 #include "library/definition_cache.h"
 #include "library/declaration_index.h"
+#include "library/decl_search_index.h"
 #include "frontends/lean/scanner.h"
 #include "frontends/lean/elaborator_context.h"
 #include "frontends/lean/local_decls.h"
@@ -119,6 +120,8 @@ class parser {
     optional<bool>          m_has_tactic_decls;
     // We process theorems in parallel
     theorem_queue           m_theorem_queue;
+    // index of the first snapshot that may contain delayed theorems as axioms
+    optional<unsigned>      m_delayed_thms_snapshot;
 
     // info support
     snapshot_vector *       m_snapshot_vector;
@@ -129,6 +132,8 @@ class parser {
     definition_cache *     m_cache;
     // index support
     declaration_index *    m_index;
+    // index for the find_decl command
+    decl_search_index      m_search_index;
 
     keep_theorem_mode      m_keep_theorem_mode;
 
@@ -204,6 +209,7 @@ class parser {
     void pop_local_scope();
 
     void save_snapshot();
+    void join_delayed_theorems();
     void save_overload(expr const & e);
     void save_overload_notation(list<expr> const & as, pos_info const & p);
     void save_type_info(expr const & e);
@@ -220,6 +226,7 @@ class parser {
     expr parse_tactic_led(expr left);
     expr parse_tactic_nud();
     expr parse_tactic_expr_list();
+    expr parse_portfolio_tactic(pos_info const & pos);
     expr parse_tactic_opt_expr_list();
 
 public:
@@ -280,6 +287,7 @@ public:
     expr mk_app(std::initializer_list<expr> const & args, pos_info const & p);
 
     unsigned num_threads() const { return m_num_threads; }
+    decl_search_index & get_search_index() { return m_search_index; }
     void add_delayed_theorem(environment const & env, name const & n, level_param_names const & ls, expr const & t, expr const & v);
 
     /** \brief Read the next token. */
@@ -448,9 +456,12 @@ public:
     std::tuple<expr, level_param_names> elaborate(expr const & e) { return elaborate_at(m_env, e); }
     /** \brief Elaborate the definition n : t := v */
     std::tuple<expr, expr, level_param_names> elaborate_definition(name const & n, expr const & t, expr const & v, bool is_opaque);
-    /** \brief Elaborate the definition n : t := v in the given environment*/
-    std::tuple<expr, expr, level_param_names> elaborate_definition_at(environment const & env, local_level_decls const & lls,
-                                                                      name const & n, expr const & t, expr const & v, bool is_opaque);
+    /** \brief Elaborate the definition n : t := v in the given environment, io_state and position information.
+        \remark This method does not modify the parser state, and can be invoked from other threads (see \c theorem_queue). */
+    std::tuple<expr, expr, level_param_names> elaborate_definition_at(environment const & env, io_state const & ios,
+                                                                      local_level_decls const & lls,
+                                                                      parser_pos_provider const & pp, name const & n,
+                                                                      expr const & t, expr const & v, bool is_opaque) const;
 
     expr mk_sorry(pos_info const & p);
     bool used_sorry() const { return m_used_sorry; }
@@ -161,9 +161,10 @@ unsigned server::file::copy_to(std::string & block, unsigned starting_from) {
     return num_lines;
 }
 
-server::worker::worker(environment const & env, io_state const & ios, definition_cache & cache):
+server::worker::worker(environment const & env, io_state const & ios, definition_cache & cache, unsigned num_threads):
     m_empty_snapshot(env, ios.get_options()),
     m_cache(cache),
+    m_num_threads(num_threads),
     m_todo_line_num(0),
     m_todo_options(ios.get_options()),
     m_terminate(false),
@@ -222,11 +223,12 @@ server::worker::worker(environment const & env, io_state const & ios, definition
                     io_state tmp_ios(_ios, out1, out2);
                     tmp_ios.set_options(join(s.m_options, _ios.get_options()));
                     bool use_exceptions  = false;
-                    unsigned num_threads = 1;
-                    parser p(s.m_env, tmp_ios, strm, todo_file->m_fname.c_str(), use_exceptions, num_threads,
+                    parser p(s.m_env, tmp_ios, strm, todo_file->m_fname.c_str(), use_exceptions, m_num_threads,
                              &s, &todo_file->m_snapshots, &todo_file->m_info);
                     p.set_cache(&m_cache);
+                    scoped_checked_decls scope(m_checked);
                     p();
+                    m_checked.retain(p.env());
                 } catch (interrupted &) {
                     worker_interrupted = true;
                 } catch (throwable & ex) {
@@ -284,8 +286,7 @@ void server::worker::set_todo(file_ptr const & f, unsigned line_num, options con
 
 server::server(environment const & env, io_state const & ios, unsigned num_threads):
     m_env(env), m_ios(ios), m_out(ios.get_regular_channel().get_stream()),
-    m_num_threads(num_threads), m_empty_snapshot(m_env, m_ios.get_options()),
-    m_worker(env, ios, m_cache) {
+    m_num_threads(num_threads), m_empty_snapshot(m_env, m_ios.get_options()) {
 #if !defined(LEAN_MULTI_THREAD)
     lean_unreachable();
 #endif
@@ -294,8 +295,23 @@ server::server(environment const & env, io_state const & ios, unsigned num_threa
 server::~server() {
 }
 
+server::worker & server::get_worker(file_ptr const & f) {
+    std::unique_ptr<worker> & w = m_workers[f->get_fname()];
+    if (!w)
+        w.reset(new worker(m_env, m_ios, m_cache, m_num_threads));
+    return *w;
+}
+
+/** \brief Interrupt the worker processing the current file. The other files are not affected. */
 void server::interrupt_worker() {
-    m_worker.request_interrupt();
+    if (m_file)
+        interrupt_worker(m_file->get_fname());
+}
+
+void server::interrupt_worker(std::string const & fname) {
+    auto it = m_workers.find(fname);
+    if (it != m_workers.end())
+        it->second->request_interrupt();
 }
 
 static std::string * g_load = nullptr;
@@ -337,11 +353,11 @@ static std::string & trim(std::string & s) {
 }
 
 void server::process_from(unsigned line_num) {
-    m_worker.set_todo(m_file, line_num, m_ios.get_options());
+    get_worker(m_file).set_todo(m_file, line_num, m_ios.get_options());
 }
 
 void server::load_file(std::string const & fname, bool error_if_nofile) {
-    interrupt_worker();
+    interrupt_worker(fname);
     std::ifstream in(fname);
     if (in.bad() || in.fail()) {
         if (error_if_nofile) {
@@ -361,7 +377,7 @@ void server::load_file(std::string const & fname, bool error_if_nofile) {
 }
 
 void server::visit_file(std::string const & fname) {
-    interrupt_worker();
+    interrupt_worker(fname);
     auto it = m_file_map.find(fname);
     if (it == m_file_map.end()) {
         bool error_if_nofile = false;
@@ -661,17 +677,41 @@ void server::find_pattern(unsigned line_num, std::string const & pattern) {
     std::vector<pair<name, name>> exact_matches;
     std::vector<pair<std::string, name>> selected;
     bitap_fuzzy_search matcher(pattern, max_errors);
-    env.for_each_declaration([&](declaration const & d) {
-            if (is_projection(env, d.get_name()))
-                return;
-            if (auto it = exact_prefix_match(env, pattern, d)) {
-                exact_matches.emplace_back(*it, d.get_name());
-            } else {
-                std::string text = d.get_name().to_string();
-                if (matcher.match(text))
-                    selected.emplace_back(text, d.get_name());
+    m_search_index.update(env);
+    // The declarations that match the prefix exactly are the ones s.t. their name, the last component of their name,
+    // or an atomic alias starts with pattern.
+    buffer<unsigned> candidates;
+    m_search_index.find_prefix(pattern, candidates);
+    for_each_expr_alias(env, [&](name const & a, list<name> const & ds) {
+            if (a.is_atomic() && a.is_string() && std::string(a.get_string()).compare(0, pattern.size(), pattern) == 0) {
+                for (name const & d : ds) {
+                    if (auto i = m_search_index.find(d))
+                        candidates.push_back(*i);
+                }
             }
         });
+    m_search_index.filter(env, candidates);
+    name_set exact;
+    for (unsigned i : candidates) {
+        declaration const & d = m_search_index.get_decl(i);
+        if (is_projection(env, d.get_name()))
+            continue;
+        if (auto it = exact_prefix_match(env, pattern, d)) {
+            exact_matches.emplace_back(*it, d.get_name());
+            exact.insert(d.get_name());
+        }
+    }
+    candidates.clear();
+    m_search_index.find_fuzzy(pattern, max_errors, candidates);
+    m_search_index.filter(env, candidates);
+    for (unsigned i : candidates) {
+        declaration const & d = m_search_index.get_decl(i);
+        if (is_projection(env, d.get_name()) || exact.contains(d.get_name()))
+            continue;
+        std::string const & text = m_search_index.get_name_str(i);
+        if (matcher.match(text))
+            selected.emplace_back(text, d.get_name());
+    }
     unsigned num_results = 0;
     if (!exact_matches.empty()) {
         std::sort(exact_matches.begin(), exact_matches.end(),
@@ -799,26 +839,31 @@ void server::find_goal_matches(unsigned line_num, unsigned col_num, std::string
     if (auto meta = m_file->infom().get_meta_at(line_num, col_num)) {
     if (is_meta(*meta)) {
     if (auto type = m_file->infom().get_type_at(line_num, col_num)) {
-        env.for_each_declaration([&](declaration const & d) {
-                if (!is_projection(env, d.get_name()) &&
-                    std::all_of(pos_names.begin(), pos_names.end(),
-                                [&](std::string const & pos) { return is_part_of(pos, d.get_name()); }) &&
-                    std::all_of(neg_names.begin(), neg_names.end(),
-                                [&](std::string const & neg) { return !is_part_of(neg, d.get_name()); }) &&
-                    match_type(*tc.get(), *meta, *type, d)) {
-                    if (optional<name> alias = is_expr_aliased(env, d.get_name()))
-                        display_decl(*alias, d.get_name(), env, opts);
-                    else
-                        display_decl(d.get_name(), d.get_name(), env, opts);
-                }
-            });
+        m_search_index.update(env);
+        buffer<unsigned> candidates;
+        m_search_index.find_conclusion(*type, candidates);
+        m_search_index.filter(env, candidates);
+        for (unsigned i : candidates) {
+            declaration const & d = m_search_index.get_decl(i);
+            if (!is_projection(env, d.get_name()) &&
+                std::all_of(pos_names.begin(), pos_names.end(),
+                            [&](std::string const & pos) { return is_part_of(pos, d.get_name()); }) &&
+                std::all_of(neg_names.begin(), neg_names.end(),
+                            [&](std::string const & neg) { return !is_part_of(neg, d.get_name()); }) &&
+                match_type(*tc.get(), *meta, *type, d)) {
+                if (optional<name> alias = is_expr_aliased(env, d.get_name()))
+                    display_decl(*alias, d.get_name(), env, opts);
+                else
+                    display_decl(d.get_name(), d.get_name(), env, opts);
+            }
+        }
     }}}
     m_out << "-- ENDFINDG" << std::endl;
 }
 
 void server::wait(optional<unsigned> ms) {
     m_out << "-- BEGINWAIT" << std::endl;
-    if (!m_worker.wait(ms))
+    if (m_file && !get_worker(m_file).wait(ms))
         m_out << "-- INTERRUPTED\n";
     m_out << "-- ENDWAIT" << std::endl;
 }
@@ -826,7 +871,7 @@ void server::wait(optional<unsigned> ms) {
 void server::save_olean(std::string const & fname) {
     m_out << "-- BEGINSAVE" << std::endl;
     check_file();
-    m_worker.wait(optional<unsigned>());
+    get_worker(m_file).wait(optional<unsigned>());
     if (auto it = m_file->infom().get_final_env_opts()) {
         std::ofstream out(fname, std::ofstream::binary);
         environment const & env = it->first;
@@ -886,6 +931,8 @@ bool server::operator()(std::istream & in) {
             } else if (is_command(*g_clear_cache, line)) {
                 interrupt_worker();
                 m_cache.clear();
+                for (auto & p : m_workers)
+                    p.second->clear_checked();
                 if (m_file)
                     process_from(0);
             } else if (is_command(*g_options, line)) {
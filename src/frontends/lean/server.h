@@ -10,6 +10,8 @@ Author: Leonardo de Moura
 #include <unordered_map>
 #include "util/interrupt.h"
 #include "library/definition_cache.h"
+#include "library/decl_search_index.h"
+#include "library/definitional/checked_decls.h"
 #include "frontends/lean/parser.h"
 #include "frontends/lean/info_manager.h"
 
@@ -42,9 +44,19 @@ class server {
     };
     typedef std::shared_ptr<file>                     file_ptr;
     typedef std::unordered_map<std::string, file_ptr> file_map;
+    /** \brief Each file is processed by its own worker. The worker uses
+        \c num_threads threads for elaborating theorems (see \c theorem_queue).
+
+        After an edit, the worker processes every command from the closest snapshot to the end of the file.
+        There is no dependency tracking between commands: notations, options and other environment
+        extensions are always processed again. Only definitions and theorems are reused, and only at the
+        declaration level: their elaboration is skipped by the \c definition_cache, and their type checking by
+        \c m_checked when they did not change and their dependencies did not change. */
     class worker {
         snapshot             m_empty_snapshot;
         definition_cache &   m_cache;
+        checked_decls        m_checked; // declarations type checked by this worker, see \c check_aux_decl
+        unsigned             m_num_threads;
         file_ptr             m_todo_file;
         unsigned             m_todo_line_num;
         options              m_todo_options;
@@ -54,12 +66,14 @@ class server {
         atomic_bool          m_terminate;
         interruptible_thread m_thread;
     public:
-        worker(environment const & env, io_state const & ios, definition_cache & cache);
+        worker(environment const & env, io_state const & ios, definition_cache & cache, unsigned num_threads);
         ~worker();
         void set_todo(file_ptr const & f, unsigned line_num, options const & o);
         void request_interrupt();
+        void clear_checked() { m_checked.clear(); }
         bool wait(optional<unsigned> const & ms);
     };
+    typedef std::unordered_map<std::string, std::unique_ptr<worker>> worker_map;
 
     file_map                  m_file_map;
     file_ptr                  m_file;
@@ -69,7 +83,8 @@ class server {
     unsigned                  m_num_threads;
     snapshot                  m_empty_snapshot;
     definition_cache          m_cache;
-    worker                    m_worker;
+    worker_map                m_workers;
+    decl_search_index         m_search_index; // used to implement FINDP and FINDG
 
     void load_file(std::string const & fname, bool error_if_nofile = true);
     void save_olean(std::string const & fname);
@@ -78,6 +93,7 @@ class server {
     void replace_line(unsigned line_num, std::string const & new_line);
     void insert_line(unsigned line_num, std::string const & new_line);
     void remove_line(unsigned line_num);
+    worker & get_worker(file_ptr const & f);
     void show_info(unsigned line_num, optional<unsigned> const & col_num);
     void process_from(unsigned line_num);
     void set_option(std::string const & line);
@@ -89,6 +105,7 @@ class server {
     unsigned find(unsigned line_num);
     void read_line(std::istream & in, std::string & line);
     void interrupt_worker();
+    void interrupt_worker(std::string const & fname);
     void show_options();
     void show(bool valid);
     void sync(std::vector<std::string> const & lines);
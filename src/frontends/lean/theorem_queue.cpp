@@ -15,11 +15,15 @@ namespace lean {
 theorem_queue::theorem_queue(parser & p, unsigned num_threads):m_parser(p), m_queue(num_threads, []() { enable_expr_caching(false); }) {}
 void theorem_queue::add(environment const & env, name const & n, level_param_names const & ls, local_level_decls const & lls,
                         expr const & t, expr const & v) {
+    // The position information and io_state are copied here because the parser keeps modifying them
+    // while the theorem is elaborated.
+    parser_pos_provider pp = m_parser.get_pos_provider();
+    io_state ios           = m_parser.ios();
     m_queue.add([=]() {
             level_param_names new_ls;
             expr type, value;
             bool is_opaque = true; // theorems are always opaque
-            std::tie(type, value, new_ls) = m_parser.elaborate_definition_at(env, lls, n, t, v, is_opaque);
+            std::tie(type, value, new_ls) = m_parser.elaborate_definition_at(env, ios, lls, pp, n, t, v, is_opaque);
             new_ls = append(ls, new_ls);
             value  = expand_abbreviations(env, unfold_untrusted_macros(env, value));
             auto r = check(env, mk_theorem(n, new_ls, type, value));
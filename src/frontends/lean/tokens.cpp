@@ -76,6 +76,7 @@ static name * g_none         = nullptr;
 static name * g_whnf         = nullptr;
 static name * g_wf           = nullptr;
 static name * g_all_transparent = nullptr;
+static name * g_vm           = nullptr;
 static name * g_in           = nullptr;
 static name * g_at           = nullptr;
 static name * g_assign       = nullptr;
@@ -86,6 +87,7 @@ static name * g_then         = nullptr;
 static name * g_else         = nullptr;
 static name * g_by           = nullptr;
 static name * g_rewrite      = nullptr;
+static name * g_portfolio    = nullptr;
 static name * g_proof        = nullptr;
 static name * g_qed          = nullptr;
 static name * g_begin        = nullptr;
@@ -201,6 +203,7 @@ void initialize_tokens() {
     g_whnf         = new name("[whnf]");
     g_wf           = new name("[wf]");
     g_all_transparent = new name("[all-transparent]");
+    g_vm           = new name("[vm]");
     g_in           = new name("in");
     g_at           = new name("at");
     g_assign       = new name(":=");
@@ -211,6 +214,7 @@ void initialize_tokens() {
     g_else         = new name("else");
     g_by           = new name("by");
     g_rewrite      = new name("rewrite");
+    g_portfolio    = new name("portfolio");
     g_proof        = new name("proof");
     g_qed          = new name("qed");
     g_begin        = new name("begin");
@@ -308,6 +312,7 @@ void finalize_tokens() {
     delete g_else;
     delete g_by;
     delete g_rewrite;
+    delete g_portfolio;
     delete g_proof;
     delete g_qed;
     delete g_begin;
@@ -333,6 +338,7 @@ void finalize_tokens() {
     delete g_whnf;
     delete g_wf;
     delete g_all_transparent;
+    delete g_vm;
     delete g_ellipsis;
     delete g_match;
     delete g_fun;
@@ -453,6 +459,7 @@ name const & get_none_tk() { return *g_none; }
 name const & get_whnf_tk() { return *g_whnf; }
 name const & get_wf_tk() { return *g_wf; }
 name const & get_all_transparent_tk() { return *g_all_transparent; }
+name const & get_vm_tk() { return *g_vm; }
 name const & get_in_tk() { return *g_in; }
 name const & get_at_tk() { return *g_at; }
 name const & get_assign_tk() { return *g_assign; }
@@ -463,6 +470,7 @@ name const & get_then_tk() { return *g_then; }
 name const & get_else_tk() { return *g_else; }
 name const & get_by_tk() { return *g_by; }
 name const & get_rewrite_tk() { return *g_rewrite; }
+name const & get_portfolio_tk() { return *g_portfolio; }
 name const & get_proof_tk() { return *g_proof; }
 name const & get_qed_tk() { return *g_qed; }
 name const & get_begin_tk() { return *g_begin; }
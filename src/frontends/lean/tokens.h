@@ -78,6 +78,7 @@ name const & get_none_tk();
 name const & get_whnf_tk();
 name const & get_wf_tk();
 name const & get_all_transparent_tk();
+name const & get_vm_tk();
 name const & get_in_tk();
 name const & get_at_tk();
 name const & get_assign_tk();
@@ -88,6 +89,7 @@ name const & get_then_tk();
 name const & get_else_tk();
 name const & get_by_tk();
 name const & get_rewrite_tk();
+name const & get_portfolio_tk();
 name const & get_proof_tk();
 name const & get_begin_tk();
 name const & get_qed_tk();
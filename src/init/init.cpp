@@ -6,6 +6,7 @@ Author: Leonardo de Moura
 */
 #include "util/stackinfo.h"
 #include "util/thread.h"
+#include "util/thread_pool.h"
 #include "util/init_module.h"
 #include "util/numerics/init_module.h"
 #include "util/sexpr/init_module.h"
@@ -35,6 +36,8 @@ void initialize() {
     register_modules();
 }
 void finalize() {
+    // threads in the pool may still reference objects owned by the other modules
+    finalize_thread_pool();
     run_thread_finalizers();
     finalize_frontend_lean_module();
     finalize_definitional_module();
@@ -14,7 +14,7 @@ Author: Leonardo de Moura
 namespace lean {
 expr abstract(expr const & e, unsigned s, unsigned n, expr const * subst) {
     lean_assert(std::all_of(subst, subst+n, closed));
-    return replace(e, [=](expr const & e, unsigned offset) -> optional<expr> {
+    return replace_spine(e, [=](expr const & e, unsigned offset) -> optional<expr> {
             if (closed(e)) {
                 unsigned i = n;
                 while (i > 0) {
@@ -33,7 +33,7 @@ expr abstract_locals(expr const & e, unsigned n, expr const * subst) {
     lean_assert(std::all_of(subst, subst+n, [](expr const & e) { return closed(e) && is_local(e); }));
     if (!has_local(e))
         return e;
-    return replace(e, [=](expr const & m, unsigned offset) -> optional<expr> {
+    return replace_spine(e, [=](expr const & m, unsigned offset) -> optional<expr> {
             if (!has_local(m))
                 return some_expr(m); // expression m does not contain local constants
             if (is_local(m)) {
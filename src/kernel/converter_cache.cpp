@@ -0,0 +1,110 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <iterator>
+#include "util/hash.h"
+#include "kernel/converter_cache.h"
+
+namespace lean {
+static atomic<bool> g_converter_cache_enabled(true);
+
+bool enable_converter_cache(bool f) {
+    bool r = g_converter_cache_enabled;
+    g_converter_cache_enabled = f;
+    return r;
+}
+
+bool is_converter_cache_enabled() {
+    return g_converter_cache_enabled;
+}
+
+converter_cache::converter_cache(unsigned capacity):
+    m_shard_capacity(std::max(capacity / LEAN_CONVERTER_CACHE_SHARDS, 1u)) {}
+
+converter_cache::key::key(entry_kind k, unsigned mode, expr const & lhs, expr const & rhs):
+    m_kind(k), m_mode(mode), m_lhs(lhs), m_rhs(rhs),
+    m_hash(hash(hash(lhs.hash(), rhs.hash()), hash(static_cast<unsigned>(k), mode))) {}
+
+optional<expr> converter_cache::find(environment const & env, key const & k) {
+    shard & s = get_shard(k);
+    lock_guard<mutex> lock(s.m_mutex);
+    auto it = s.m_entries.find(k);
+    if (it != s.m_entries.end() && env.get_id().is_descendant(it->second->second.m_env_id)) {
+        s.m_lru.splice(s.m_lru.begin(), s.m_lru, it->second);
+        return some_expr(it->second->second.m_result);
+    }
+    return none_expr();
+}
+
+void converter_cache::insert(environment const & env, key const & k, expr const & r) {
+    shard & s = get_shard(k);
+    lru_list evicted; // evicted entries are deleted outside of the critical section
+    lock_guard<mutex> lock(s.m_mutex);
+    auto it = s.m_entries.find(k);
+    if (it != s.m_entries.end()) {
+        // we keep the entry produced by an ancestor since it can be used by more environments
+        if (!env.get_id().is_descendant(it->second->second.m_env_id))
+            it->second->second = entry(env.get_id(), r);
+        s.m_lru.splice(s.m_lru.begin(), s.m_lru, it->second);
+        return;
+    }
+    if (s.m_entries.size() >= m_shard_capacity) {
+        s.m_entries.erase(s.m_lru.back().first);
+        evicted.splice(evicted.begin(), s.m_lru, std::prev(s.m_lru.end()));
+    }
+    s.m_lru.emplace_front(k, entry(env.get_id(), r));
+    s.m_entries.insert(mk_pair(k, s.m_lru.begin()));
+}
+
+optional<expr> converter_cache::find_whnf(environment const & env, unsigned mode, expr const & e) {
+    return find(env, key(entry_kind::Whnf, mode, e, e));
+}
+
+void converter_cache::add_whnf(environment const & env, unsigned mode, expr const & e, expr const & r) {
+    insert(env, key(entry_kind::Whnf, mode, e, e), r);
+}
+
+/** \brief Definitional equality is symmetric, we use the hash codes to select a canonical order. */
+static bool swap_def_eq_args(expr const & t, expr const & s) {
+    return s.hash() < t.hash();
+}
+
+bool converter_cache::is_def_eq(environment const & env, unsigned mode, expr const & t, expr const & s) {
+    if (swap_def_eq_args(t, s))
+        return static_cast<bool>(find(env, key(entry_kind::DefEq, mode, s, t)));
+    else
+        return static_cast<bool>(find(env, key(entry_kind::DefEq, mode, t, s)));
+}
+
+void converter_cache::add_def_eq(environment const & env, unsigned mode, expr const & t, expr const & s) {
+    if (swap_def_eq_args(t, s))
+        insert(env, key(entry_kind::DefEq, mode, s, t), s);
+    else
+        insert(env, key(entry_kind::DefEq, mode, t, s), t);
+}
+
+unsigned converter_cache::size() {
+    unsigned r = 0;
+    for (shard & s : m_shards) {
+        lock_guard<mutex> lock(s.m_mutex);
+        r += s.m_entries.size();
+    }
+    return r;
+}
+
+void converter_cache::clear() {
+    for (shard & s : m_shards) {
+        lru_list old;
+        {
+            lock_guard<mutex> lock(s.m_mutex);
+            s.m_entries.clear();
+            old.swap(s.m_lru);
+        }
+        // old entries are deleted outside of the critical section
+    }
+}
+}
@@ -0,0 +1,89 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <unordered_map>
+#include <list>
+#include "util/thread.h"
+#include "kernel/environment.h"
+
+#ifndef LEAN_CONVERTER_CACHE_SHARDS
+#define LEAN_CONVERTER_CACHE_SHARDS 16
+#endif
+
+#ifndef LEAN_CONVERTER_CACHE_CAPACITY
+#define LEAN_CONVERTER_CACHE_CAPACITY (1024*256)
+#endif
+
+namespace lean {
+/**
+   \brief Memo table for \c whnf and \c is_def_eq results produced by the kernel converter.
+
+   Different from the caches in \c default_converter, this table survives the type checker objects,
+   and it is shared by all environments that have the same header. Each entry is tagged with the
+   identifier of the environment used to produce it, and it is only used in descendants of this
+   environment. This is sound because declarations are never removed from an environment.
+
+   Only closed terms that do not contain local constants and metavariables are stored,
+   and results that produced constraints are not stored.
+   The \c mode is used to distinguish converters that have different opaque definitions.
+
+   When a shard reaches its capacity, its least recently used entry is evicted.
+*/
+class converter_cache {
+    enum class entry_kind { Whnf, DefEq };
+    struct key {
+        entry_kind m_kind;
+        unsigned   m_mode;
+        expr       m_lhs;
+        expr       m_rhs;
+        unsigned   m_hash;
+        key(entry_kind k, unsigned mode, expr const & lhs, expr const & rhs);
+    };
+    struct key_hash { unsigned operator()(key const & k) const { return k.m_hash; } };
+    struct key_eq {
+        bool operator()(key const & k1, key const & k2) const {
+            return
+                k1.m_hash == k2.m_hash && k1.m_kind == k2.m_kind && k1.m_mode == k2.m_mode &&
+                k1.m_lhs == k2.m_lhs && k1.m_rhs == k2.m_rhs;
+        }
+    };
+    struct entry {
+        environment_id m_env_id; // environment used to produce the result
+        expr           m_result;
+        entry(environment_id const & id, expr const & r):m_env_id(id), m_result(r) {}
+    };
+    typedef std::list<pair<key, entry>> lru_list; // most recently used entries first
+    typedef std::unordered_map<key, lru_list::iterator, key_hash, key_eq> entries;
+    struct shard {
+        mutex    m_mutex;
+        lru_list m_lru;
+        entries  m_entries;
+    };
+    unsigned m_shard_capacity;
+    shard    m_shards[LEAN_CONVERTER_CACHE_SHARDS];
+    shard & get_shard(key const & k) { return m_shards[k.m_hash % LEAN_CONVERTER_CACHE_SHARDS]; }
+    optional<expr> find(environment const & env, key const & k);
+    void insert(environment const & env, key const & k, expr const & r);
+public:
+    converter_cache(unsigned capacity = LEAN_CONVERTER_CACHE_CAPACITY);
+    /** \brief Return the weak head normal form of \c e (if available) for an environment \c env. */
+    optional<expr> find_whnf(environment const & env, unsigned mode, expr const & e);
+    /** \brief Store the weak head normal form \c r of \c e produced using \c env. */
+    void add_whnf(environment const & env, unsigned mode, expr const & e, expr const & r);
+    /** \brief Return true if \c t and \c s are known to be definitionally equal in \c env. */
+    bool is_def_eq(environment const & env, unsigned mode, expr const & t, expr const & s);
+    /** \brief Store the fact that \c t and \c s are definitionally equal in \c env. */
+    void add_def_eq(environment const & env, unsigned mode, expr const & t, expr const & s);
+
+    unsigned size();
+    void clear();
+};
+
+/** \brief Enable/disable the use of \c converter_cache by the kernel converter. Return the previous value. */
+bool enable_converter_cache(bool f);
+bool is_converter_cache_enabled();
+}
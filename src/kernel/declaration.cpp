@@ -4,6 +4,8 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <memory>
+#include "util/thread.h"
 #include "kernel/declaration.h"
 #include "kernel/environment.h"
 #include "kernel/for_each_fn.h"
@@ -15,7 +17,13 @@ struct declaration::cell {
     level_param_names m_params;
     expr              m_type;
     bool              m_theorem;
-    optional<expr>    m_value;        // if none, then declaration is actually a postulate
+    bool              m_definition;
+    optional<expr>    m_value;        // if none, then declaration is actually a postulate, or its value has not been computed yet
+    // The following two fields are only used by lazy definitions/theorems.
+    // The value is computed using m_value_fn when it is accessed for the first time.
+    declaration_value_fn m_value_fn;
+    atomic<bool>      m_value_ready;
+    std::unique_ptr<mutex> m_value_mutex; // protects m_value_fn and m_value
     // The following fields are only meaningful for definitions (which are not theorems)
     unsigned          m_weight;
     unsigned          m_module_idx;   // module idx where it was defined
@@ -30,14 +38,32 @@ struct declaration::cell {
     void dealloc() { delete this; }
 
     cell(name const & n, level_param_names const & params, expr const & t, bool is_axiom):
-        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_axiom),
-        m_weight(0), m_module_idx(0), m_opaque(true), m_use_conv_opt(false) {}
+        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_axiom), m_definition(false),
+        m_value_ready(true), m_weight(0), m_module_idx(0), m_opaque(true), m_use_conv_opt(false) {}
     cell(name const & n, level_param_names const & params, expr const & t, bool is_thm, expr const & v,
          bool opaque, unsigned w, module_idx mod_idx, bool use_conv_opt):
-        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_thm),
-        m_value(v), m_weight(w), m_module_idx(mod_idx), m_opaque(opaque), m_use_conv_opt(use_conv_opt) {}
+        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_thm), m_definition(true),
+        m_value(v), m_value_ready(true), m_weight(w), m_module_idx(mod_idx), m_opaque(opaque), m_use_conv_opt(use_conv_opt) {}
+    cell(name const & n, level_param_names const & params, expr const & t, bool is_thm, declaration_value_fn const & v,
+         bool opaque, unsigned w, module_idx mod_idx, bool use_conv_opt):
+        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_thm), m_definition(true),
+        m_value_fn(v), m_value_ready(false), m_value_mutex(new mutex()), m_weight(w), m_module_idx(mod_idx),
+        m_opaque(opaque), m_use_conv_opt(use_conv_opt) {}
+
+    void force_value();
 };
 
+void declaration::cell::force_value() {
+    // Remark: computing the value may force the value of other lazy declarations,
+    // but not the value of this one since there are no cyclic dependencies.
+    lock_guard<mutex> lock(*m_value_mutex);
+    if (m_value_ready)
+        return;
+    m_value = m_value_fn();
+    m_value_fn = declaration_value_fn(); // release resources used by m_value_fn
+    m_value_ready = true;
+}
+
 static declaration * g_dummy = nullptr;
 
 declaration::declaration():declaration(*g_dummy) {}
@@ -49,7 +75,7 @@ declaration::~declaration() { if (m_ptr) m_ptr->dec_ref(); }
 declaration & declaration::operator=(declaration const & s) { LEAN_COPY_REF(s); }
 declaration & declaration::operator=(declaration && s) { LEAN_MOVE_REF(s); }
 
-bool declaration::is_definition() const    { return static_cast<bool>(m_ptr->m_value); }
+bool declaration::is_definition() const    { return m_ptr->m_definition; }
 bool declaration::is_constant_assumption() const { return !is_definition(); }
 bool declaration::is_axiom() const         { return is_constant_assumption() && m_ptr->m_theorem; }
 bool declaration::is_theorem() const       { return is_definition() && m_ptr->m_theorem; }
@@ -60,7 +86,13 @@ unsigned declaration::get_num_univ_params() const { return length(get_univ_param
 expr const & declaration::get_type() const { return m_ptr->m_type; }
 
 bool declaration::is_opaque() const { return m_ptr->m_opaque; }
-expr const & declaration::get_value() const { lean_assert(is_definition()); return *(m_ptr->m_value); }
+expr const & declaration::get_value() const {
+    lean_assert(is_definition());
+    if (!m_ptr->m_value_ready)
+        m_ptr->force_value();
+    return *(m_ptr->m_value);
+}
+bool declaration::is_value_delayed() const { return !m_ptr->m_value_ready; }
 unsigned declaration::get_weight() const { return m_ptr->m_weight; }
 module_idx declaration::get_module_idx() const { return m_ptr->m_module_idx; }
 bool declaration::use_conv_opt() const { return m_ptr->m_use_conv_opt; }
@@ -85,6 +117,14 @@ declaration mk_definition(environment const & env, name const & n, level_param_n
 declaration mk_theorem(name const & n, level_param_names const & params, expr const & t, expr const & v, module_idx mod_idx) {
     return declaration(new declaration::cell(n, params, t, true, v, true, 0, mod_idx, false));
 }
+declaration mk_lazy_definition(name const & n, level_param_names const & params, expr const & t, declaration_value_fn const & v,
+                               bool opaque, unsigned weight, module_idx mod_idx, bool use_conv_opt) {
+    return declaration(new declaration::cell(n, params, t, false, v, opaque, weight, mod_idx, use_conv_opt));
+}
+declaration mk_lazy_theorem(name const & n, level_param_names const & params, expr const & t, declaration_value_fn const & v,
+                            module_idx mod_idx) {
+    return declaration(new declaration::cell(n, params, t, true, v, true, 0, mod_idx, false));
+}
 declaration mk_axiom(name const & n, level_param_names const & params, expr const & t) {
     return declaration(new declaration::cell(n, params, t, true));
 }
@@ -8,6 +8,7 @@ Author: Leonardo de Moura
 #include <algorithm>
 #include <string>
 #include <limits>
+#include <functional>
 #include "util/rc.h"
 #include "kernel/expr.h"
 
@@ -27,6 +28,10 @@ typedef unsigned module_idx;
 constexpr module_idx g_main_module_idx = 0;
 constexpr module_idx g_null_module_idx = std::numeric_limits<unsigned>::max();
 
+/** \brief Procedure for computing the value of a definition/theorem on demand.
+    \see mk_lazy_definition, mk_lazy_theorem */
+typedef std::function<expr()> declaration_value_fn;
+
 /** \brief Environment definitions, theorems, axioms and variable declarations. */
 class declaration {
     struct cell;
@@ -64,7 +69,12 @@ public:
     unsigned get_num_univ_params() const;
     expr const & get_type() const;
 
+    /** \brief Return the value of a definition/theorem.
+        If the declaration was created using mk_lazy_definition or mk_lazy_theorem,
+        then the value is computed on the first access. */
     expr const & get_value() const;
+    /** \brief Return true if the value of a lazy definition/theorem has not been computed yet. */
+    bool is_value_delayed() const;
     bool is_opaque() const;
     unsigned get_weight() const;
     module_idx get_module_idx() const;
@@ -75,6 +85,11 @@ public:
     friend declaration mk_definition(name const & n, level_param_names const & params, expr const & t, expr const & v, bool opaque,
                                     unsigned weight, module_idx mod_idx, bool use_conv_opt);
     friend declaration mk_theorem(name const & n, level_param_names const & params, expr const & t, expr const & v, module_idx mod_idx);
+    friend declaration mk_lazy_definition(name const & n, level_param_names const & params, expr const & t,
+                                          declaration_value_fn const & v, bool opaque, unsigned weight, module_idx mod_idx,
+                                          bool use_conv_opt);
+    friend declaration mk_lazy_theorem(name const & n, level_param_names const & params, expr const & t,
+                                       declaration_value_fn const & v, module_idx mod_idx);
     friend declaration mk_axiom(name const & n, level_param_names const & params, expr const & t);
     friend declaration mk_constant_assumption(name const & n, level_param_names const & params, expr const & t);
 };
@@ -90,6 +105,15 @@ declaration mk_definition(environment const & env, name const & n, level_param_n
 declaration mk_theorem(name const & n, level_param_names const & params, expr const & t, expr const & v, module_idx mod_idx = 0);
 declaration mk_axiom(name const & n, level_param_names const & params, expr const & t);
 declaration mk_constant_assumption(name const & n, level_param_names const & params, expr const & t);
+/** \brief Create a definition whose value is only computed (using \c v) when it is accessed for the first time.
+    The kernel does not type check lazy declarations, they should only be used for trusted declarations
+    (e.g., declarations imported from .olean files when the trust level is > LEAN_BELIEVER_TRUST_LEVEL). */
+declaration mk_lazy_definition(name const & n, level_param_names const & params, expr const & t, declaration_value_fn const & v,
+                               bool opaque, unsigned weight, module_idx mod_idx, bool use_conv_opt);
+/** \brief Create a theorem whose proof is only computed (using \c v) when it is accessed for the first time.
+    \see mk_lazy_definition */
+declaration mk_lazy_theorem(name const & n, level_param_names const & params, expr const & t, declaration_value_fn const & v,
+                            module_idx mod_idx);
 
 void initialize_declaration();
 void finalize_declaration();
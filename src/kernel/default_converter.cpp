@@ -4,18 +4,63 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <typeinfo>
 #include "util/interrupt.h"
 #include "util/flet.h"
 #include "kernel/default_converter.h"
 #include "kernel/instantiate.h"
 #include "kernel/free_vars.h"
+#include "kernel/find_fn.h"
 #include "kernel/type_checker.h"
 
 namespace lean {
 static expr * g_dont_care = nullptr;
 
+def_eq_memo_stats & def_eq_memo_stats::operator+=(def_eq_memo_stats const & s) {
+    m_num_queries      += s.m_num_queries;
+    m_num_equiv_hits   += s.m_num_equiv_hits;
+    m_num_failure_hits += s.m_num_failure_hits;
+    m_num_cache_hits   += s.m_num_cache_hits;
+    return *this;
+}
+
+static void display_hits(std::ostream & out, char const * msg, uint64 hits, uint64 queries) {
+    out << msg << hits;
+    if (queries > 0)
+        out << " (" << (100.0 * hits) / queries << "%)";
+    out << "\n";
+}
+
+std::ostream & operator<<(std::ostream & out, def_eq_memo_stats const & s) {
+    out << "definitional equality problems: " << s.m_num_queries << "\n";
+    display_hits(out, "  union-find hits:   ", s.m_num_equiv_hits, s.m_num_queries);
+    display_hits(out, "  failure memo hits: ", s.m_num_failure_hits, s.m_num_queries);
+    display_hits(out, "  environment cache: ", s.m_num_cache_hits, s.m_num_queries);
+    return out;
+}
+
+static atomic<bool>        g_def_eq_memo_stats_enabled(false);
+static mutex *             g_def_eq_memo_stats_mutex = nullptr;
+static def_eq_memo_stats * g_def_eq_memo_stats = nullptr;
+
+bool enable_def_eq_memo_stats(bool f) {
+    bool r = g_def_eq_memo_stats_enabled;
+    g_def_eq_memo_stats_enabled = f;
+    return r;
+}
+
+def_eq_memo_stats get_def_eq_memo_stats() {
+    lock_guard<mutex> lock(*g_def_eq_memo_stats_mutex);
+    return *g_def_eq_memo_stats;
+}
+
+void reset_def_eq_memo_stats() {
+    lock_guard<mutex> lock(*g_def_eq_memo_stats_mutex);
+    *g_def_eq_memo_stats = def_eq_memo_stats();
+}
+
 default_converter::default_converter(environment const & env, optional<module_idx> mod_idx, bool memoize):
-    m_env(env), m_module_idx(mod_idx), m_memoize(memoize) {
+    m_env(env), m_module_idx(mod_idx), m_memoize(memoize), m_cache_initialized(false), m_cache(nullptr) {
     m_tc  = nullptr;
     m_jst = nullptr;
 }
@@ -23,10 +68,50 @@ default_converter::default_converter(environment const & env, optional<module_id
 default_converter::default_converter(environment const & env, bool relax_main_opaque, bool memoize):
     default_converter(env, relax_main_opaque ? optional<module_idx>(0) : optional<module_idx>(), memoize) {}
 
+default_converter::~default_converter() {
+    if (m_stats.m_num_queries > 0 && g_def_eq_memo_stats_enabled && g_def_eq_memo_stats_mutex) {
+        lock_guard<mutex> lock(*g_def_eq_memo_stats_mutex);
+        *g_def_eq_memo_stats += m_stats;
+    }
+}
+
 constraint default_converter::mk_eq_cnstr(expr const & lhs, expr const & rhs, justification const & j) {
     return ::lean::mk_eq_cnstr(lhs, rhs, j, static_cast<bool>(m_module_idx));
 }
 
+/**
+   \brief Return true if this converter can share results with the kernel converter.
+
+   \remark Subclasses may change the set of definitions that can be unfolded, so
+   they must opt in by overriding this method.
+*/
+bool default_converter::use_converter_cache() const {
+    return typeid(*this) == typeid(default_converter);
+}
+
+/** \brief Return the converter cache associated with the environment, or nullptr if it cannot be used. */
+converter_cache * default_converter::get_cache() {
+    if (!m_cache_initialized) {
+        m_cache_initialized = true;
+        if (m_memoize && is_converter_cache_enabled() && use_converter_cache())
+            m_cache = &m_env.get_converter_cache();
+    }
+    return m_cache;
+}
+
+/** \brief Return true if the results for \c e do not depend on the type checker state. */
+bool default_converter::is_cacheable(expr const & e) const {
+    return closed(e) && !has_local(e) && !has_metavar(e);
+}
+
+/** \brief Return true if \c e contains a constant that is not declared in the environment.
+    The weak head normal form of such term may change in a descendant environment. */
+bool default_converter::has_undeclared_constant(expr const & e) const {
+    return static_cast<bool>(find(e, [&](expr const & c, unsigned) {
+                return is_constant(c) && !m_env.find(const_name(c));
+            }));
+}
+
 optional<expr> default_converter::expand_macro(expr const & m) {
     lean_assert(is_macro(m));
     return macro_def(m).expand(m, get_extension(*m_tc));
@@ -202,6 +287,17 @@ pair<expr, constraint_seq> default_converter::whnf(expr const & e_prime) {
             return it->second;
     }
 
+    // check environment cache
+    converter_cache * cache = get_cache();
+    bool use_cache = cache && is_cacheable(e);
+    if (use_cache) {
+        if (auto r = cache->find_whnf(m_env, get_cache_mode(), e)) {
+            auto p = to_ecs(*r);
+            m_whnf_cache.insert(mk_pair(e, p));
+            return p;
+        }
+    }
+
     expr t = e;
     constraint_seq cs;
     while (true) {
@@ -212,6 +308,8 @@ pair<expr, constraint_seq> default_converter::whnf(expr const & e_prime) {
             auto r = mk_pair(t1, cs);
             if (m_memoize)
                 m_whnf_cache.insert(mk_pair(e, r));
+            if (use_cache && !cs && !has_undeclared_constant(e))
+                cache->add_whnf(m_env, get_cache_mode(), e, t1);
             return r;
         }
     }
@@ -285,8 +383,10 @@ bool default_converter::is_def_eq(levels const & ls1, levels const & ls2, constr
 
 /** \brief This is an auxiliary method for is_def_eq. It handles the "easy cases". */
 lbool default_converter::quick_is_def_eq(expr const & t, expr const & s, constraint_seq & cs, bool use_hash) {
-    if (m_eqv_manager.is_equiv(t, s, use_hash))
+    if (m_eqv_manager.is_equiv(t, s, use_hash)) {
+        m_stats.m_num_equiv_hits++;
         return l_true;
+    }
     if (is_meta(t) || is_meta(s)) {
         // if t or s is a metavariable (or the application of a metavariable), then add constraint
         cs += constraint_seq(mk_eq_cnstr(t, s, m_jst->get()));
@@ -548,9 +648,30 @@ pair<bool, constraint_seq> default_converter::is_def_eq_core(expr const & t, exp
 }
 
 pair<bool, constraint_seq> default_converter::is_def_eq(expr const & t, expr const & s) {
+    // The environment cache is only used for terms that may require delta-reduction.
+    converter_cache * cache = get_cache();
+    bool use_cache =
+        cache && !is_eqp(t, s) && (is_app(t) || is_constant(t) || is_app(s) || is_constant(s)) &&
+        is_cacheable(t) && is_cacheable(s);
+    m_stats.m_num_queries++;
+    if (use_cache && cache->is_def_eq(m_env, get_cache_mode(), t, s)) {
+        m_stats.m_num_cache_hits++;
+        return to_bcs(true);
+    }
+    // Failures are only memoized for terms without metavariables, since they are not produced using constraints.
+    bool use_failure_memo = m_memoize && !has_metavar(t) && !has_metavar(s);
+    if (use_failure_memo && m_eqv_manager.is_failure(t, s)) {
+        m_stats.m_num_failure_hits++;
+        return to_bcs(false);
+    }
     auto r = is_def_eq_core(t, s);
-    if (r.first && !r.second)
+    if (r.first && !r.second) {
         m_eqv_manager.add_equiv(t, s);
+        if (use_cache)
+            cache->add_def_eq(m_env, get_cache_mode(), t, s);
+    } else if (!r.first && use_failure_memo) {
+        m_eqv_manager.add_failure(t, s);
+    }
     return r;
 }
 
@@ -567,10 +688,14 @@ pair<expr, constraint_seq> default_converter::whnf(expr const & e, type_checker
 }
 
 void initialize_default_converter() {
-    g_dont_care = new expr(Const("dontcare"));
+    g_dont_care               = new expr(Const("dontcare"));
+    g_def_eq_memo_stats_mutex = new mutex();
+    g_def_eq_memo_stats       = new def_eq_memo_stats();
 }
 
 void finalize_default_converter() {
+    delete g_def_eq_memo_stats;
+    delete g_def_eq_memo_stats_mutex;
     delete g_dont_care;
 }
 }
@@ -5,14 +5,36 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <iostream>
 #include "util/lbool.h"
+#include "util/int64.h"
 #include "kernel/justification.h"
 #include "kernel/environment.h"
 #include "kernel/converter.h"
 #include "kernel/expr_maps.h"
 #include "kernel/equiv_manager.h"
+#include "kernel/converter_cache.h"
 
 namespace lean {
+/** \brief Statistics for the definitional equality memo used by \c default_converter. */
+struct def_eq_memo_stats {
+    uint64 m_num_queries;       // number of is_def_eq (sub)problems
+    uint64 m_num_equiv_hits;    // problems solved using the union-find data structure
+    uint64 m_num_failure_hits;  // problems solved using the failure memo
+    uint64 m_num_cache_hits;    // problems solved using the environment cache (see converter_cache)
+    def_eq_memo_stats():m_num_queries(0), m_num_equiv_hits(0), m_num_failure_hits(0), m_num_cache_hits(0) {}
+    def_eq_memo_stats & operator+=(def_eq_memo_stats const & s);
+};
+std::ostream & operator<<(std::ostream & out, def_eq_memo_stats const & s);
+
+/** \brief Enable/disable the collection of statistics for the definitional equality memo.
+    Return the previous value. The default is false. */
+bool enable_def_eq_memo_stats(bool f);
+/** \brief Return the statistics accumulated by all converters that have been destroyed
+    while the collection of statistics was enabled. */
+def_eq_memo_stats get_def_eq_memo_stats();
+void reset_def_eq_memo_stats();
+
 /** \breif Converter used in the kernel */
 class default_converter : public converter {
 protected:
@@ -22,6 +44,9 @@ protected:
     expr_struct_map<expr>                       m_whnf_core_cache;
     expr_struct_map<pair<expr, constraint_seq>> m_whnf_cache;
     equiv_manager                               m_eqv_manager;
+    def_eq_memo_stats                           m_stats;
+    bool                                        m_cache_initialized;
+    converter_cache *                           m_cache; // environment cache, see use_converter_cache
 
     // The two auxiliary fields are set when the public methods whnf and is_def_eq are invoked.
     // The goal is to avoid to keep carrying them around.
@@ -42,6 +67,12 @@ protected:
 
     expr whnf(expr const & e_prime, constraint_seq & cs);
 
+    virtual bool use_converter_cache() const;
+    converter_cache * get_cache();
+    unsigned get_cache_mode() const { return m_module_idx ? *m_module_idx + 1 : 0; }
+    bool is_cacheable(expr const & e) const;
+    bool has_undeclared_constant(expr const & e) const;
+
     pair<bool, constraint_seq> to_bcs(bool b) { return mk_pair(b, constraint_seq()); }
     pair<bool, constraint_seq> to_bcs(bool b, constraint const & c) { return mk_pair(b, constraint_seq(c)); }
     pair<bool, constraint_seq> to_bcs(bool b, constraint_seq const & cs) { return mk_pair(b, cs); }
@@ -75,6 +106,7 @@ protected:
 public:
     default_converter(environment const & env, optional<module_idx> mod_idx, bool memoize = true);
     default_converter(environment const & env, bool relax_main_opaque, bool memoize = true);
+    virtual ~default_converter();
 
     virtual optional<declaration> is_delta(expr const & e) const;
     virtual bool is_opaque(declaration const & d) const;
@@ -10,12 +10,15 @@ Author: Leonardo de Moura
 #include "util/thread.h"
 #include "kernel/environment.h"
 #include "kernel/kernel_exception.h"
+#include "kernel/converter_cache.h"
 
 namespace lean {
 environment_header::environment_header(unsigned trust_lvl, bool prop_proof_irrel, bool eta, bool impredicative,
                                        std::unique_ptr<normalizer_extension const> ext):
     m_trust_lvl(trust_lvl), m_prop_proof_irrel(prop_proof_irrel), m_eta(eta), m_impredicative(impredicative),
-    m_norm_ext(std::move(ext)) {}
+    m_norm_ext(std::move(ext)), m_converter_cache(new converter_cache()) {}
+
+environment_header::~environment_header() {}
 
 environment_extension::~environment_extension() {}
 
@@ -119,6 +122,20 @@ environment environment::add(certified_declaration const & d) const {
     return environment(m_header, m_id, insert(m_declarations, n, d.get_declaration()), m_global_levels, m_extensions);
 }
 
+environment environment::add(unsigned num, certified_declaration const * ds) const {
+    declarations new_decls = m_declarations;
+    for (unsigned i = 0; i < num; i++) {
+        certified_declaration const & d = ds[i];
+        if (!m_id.is_descendant(d.get_id()))
+            throw_incompatible_environment(*this);
+        name const & n = d.get_declaration().get_name();
+        if (new_decls.contains(n))
+            throw_already_declared(*this, n);
+        new_decls.insert(n, d.get_declaration());
+    }
+    return environment(m_header, m_id, new_decls, m_global_levels, m_extensions);
+}
+
 environment environment::add_universe(name const & n) const {
     if (m_global_levels.contains(n))
         throw_kernel_exception(*this,
@@ -212,6 +229,14 @@ void environment::for_each_declaration(std::function<void(declaration const & d)
     m_declarations.for_each([&](name const &, declaration const & d) { return f(d); });
 }
 
+void environment::for_each_declaration_diff(environment const & env,
+                                            std::function<void(declaration const *, declaration const *)> const & f) const {
+    m_declarations.for_each_diff(env.m_declarations, [&](name const &, declaration const * d1, declaration const * d2) {
+            if (!d1 || !d2 || !is_eqp(*d1, *d2))
+                f(d1, d2);
+        });
+}
+
 void environment::for_each_universe(std::function<void(name const & n)> const & f) const {
     m_global_levels.for_each([&](name const & n) { return f(n); });
 }
@@ -29,6 +29,7 @@ namespace lean {
 class type_checker;
 class environment;
 class certified_declaration;
+class converter_cache;
 
 typedef std::function<bool(name const &)> extra_opaque_pred; // NOLINT
 extra_opaque_pred const & no_extra_opaque();
@@ -47,15 +48,18 @@ class environment_header {
     bool m_eta;               //!< true if the kernel uses eta-reduction in convertability checks
     bool m_impredicative;     //!< true if the kernel should treat (universe level 0) as a impredicative Prop.
     std::unique_ptr<normalizer_extension const> m_norm_ext;
+    std::unique_ptr<converter_cache>            m_converter_cache; //!< whnf/is_def_eq results shared by all environments with this header
     void dealloc();
 public:
     environment_header(unsigned trust_lvl, bool prop_proof_irrel, bool eta, bool impredicative,
                        std::unique_ptr<normalizer_extension const> ext);
+    ~environment_header();
     unsigned trust_lvl() const { return m_trust_lvl; }
     bool prop_proof_irrel() const { return m_prop_proof_irrel; }
     bool eta() const { return m_eta; }
     bool impredicative() const { return m_impredicative; }
     normalizer_extension const & norm_ext() const { return *(m_norm_ext.get()); }
+    converter_cache & get_converter_cache() const { return *(m_converter_cache.get()); }
 };
 
 class environment_extension {
@@ -140,6 +144,9 @@ public:
     /** \brief Return reference to the normalizer extension associatied with this environment. */
     normalizer_extension const & norm_ext() const { return m_header->norm_ext(); }
 
+    /** \brief Return the table used to share \c whnf and \c is_def_eq results between type checkers. */
+    converter_cache & get_converter_cache() const { return m_header->get_converter_cache(); }
+
     /** \brief Return declaration with name \c n (if it is defined in this environment). */
     optional<declaration> find(name const & n) const;
 
@@ -163,6 +170,13 @@ public:
     */
     environment add(certified_declaration const & d) const;
 
+    /**
+       \brief Extends the current environment with the given \c num (certified) declarations.
+       It is equivalent to adding them one by one, but a single environment (and identifier) is created.
+       So, it is cheaper, and the depth of the environment identifier increases only by one.
+    */
+    environment add(unsigned num, certified_declaration const * ds) const;
+
     /**
        \brief Adds a declaration that was not type checked. This method throws an excetion if
        trust_lvl() <= LEAN_BELIEVER_TRUST_LEVEL.
@@ -210,6 +224,17 @@ public:
     /** \brief Apply the function \c f to each declaration */
     void for_each_declaration(std::function<void(declaration const & d)> const & f) const;
 
+    /**
+        \brief Apply the function \c f to each declaration of this environment or \c env such that the declarations
+        associated with its name in both environments are not pointer equal. The first (second) argument of \c f
+        is nullptr if the name is not declared in this environment (\c env).
+
+        \remark The declarations shared by both environments are skipped. So, if this environment is a descendant of \c env,
+        the cost is proportional to the number of declarations added since \c env was created.
+    */
+    void for_each_declaration_diff(environment const & env,
+                                   std::function<void(declaration const * d1, declaration const * d2)> const & f) const;
+
     /** \brief Apply the function \c f to each universe */
     void for_each_universe(std::function<void(name const & u)> const & f) const;
 };
@@ -225,6 +250,7 @@ class name_generator;
 */
 class certified_declaration {
     friend certified_declaration check(environment const & env, declaration const & d, name_generator const & g);
+    friend certified_declaration check_cached(environment const & env, declaration const & d);
     environment_id m_id;
     declaration    m_declaration;
     certified_declaration(environment_id const & id, declaration const & d):m_id(id), m_declaration(d) {}
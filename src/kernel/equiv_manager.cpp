@@ -117,4 +117,27 @@ void equiv_manager::add_equiv(expr const & e1, expr const & e2) {
     node_ref r2 = to_node(e2);
     merge(r1, r2);
 }
+
+auto equiv_manager::mk_root_pair(node_ref n1, node_ref n2) -> node_pair {
+    node_ref r1 = find(n1);
+    node_ref r2 = find(n2);
+    // the relation is symmetric
+    return r1 < r2 ? mk_pair(r1, r2) : mk_pair(r2, r1);
+}
+
+bool equiv_manager::is_failure(expr const & e1, expr const & e2) {
+    if (m_failures.empty())
+        return false;
+    auto it1 = m_to_node.find(e1);
+    if (it1 == m_to_node.end())
+        return false;
+    auto it2 = m_to_node.find(e2);
+    if (it2 == m_to_node.end())
+        return false;
+    return m_failures.find(mk_root_pair(it1->second, it2->second)) != m_failures.end();
+}
+
+void equiv_manager::add_failure(expr const & e1, expr const & e2) {
+    m_failures.insert(mk_root_pair(to_node(e1), to_node(e2)));
+}
 }
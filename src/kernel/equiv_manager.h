@@ -6,11 +6,24 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <vector>
+#include <unordered_set>
+#include <utility>
+#include "util/hash.h"
 #include "kernel/expr_maps.h"
 
 namespace lean {
+/**
+   \brief Union-find data structure for tracking expressions that are known to be
+   definitionally equal. It also stores pairs of equivalence classes that are known to
+   be not definitionally equal.
+
+   Nodes are indexed by pointer, and the structural equality test used in \c is_equiv
+   merges the nodes of structurally equal expressions.
+*/
 class equiv_manager {
     typedef unsigned node_ref;
+    typedef std::pair<node_ref, node_ref> node_pair;
+    struct node_pair_hash { unsigned operator()(node_pair const & p) const { return hash(p.first, p.second); } };
 
     struct node {
         node_ref m_parent;
@@ -20,15 +33,23 @@ class equiv_manager {
     std::vector<node>  m_nodes;
     expr_map<node_ref> m_to_node;
     bool               m_use_hash;
+    // Pairs of roots that are known to be not definitionally equal.
+    // Remark: an entry becomes useless (but it is still sound) when one of its roots is merged into another node.
+    std::unordered_set<node_pair, node_pair_hash> m_failures;
 
     node_ref mk_node();
     node_ref find(node_ref n);
     void merge(node_ref n1, node_ref n2);
     node_ref to_node(expr const & e);
     bool is_equiv_core(expr const & e1, expr const & e2);
+    node_pair mk_root_pair(node_ref n1, node_ref n2);
 public:
     equiv_manager():m_use_hash(false) {}
     bool is_equiv(expr const & e1, expr const & e2, bool use_hash = false);
     void add_equiv(expr const & e1, expr const & e2);
+    /** \brief Return true if \c e1 and \c e2 are known to be not equivalent (see \c add_failure). */
+    bool is_failure(expr const & e1, expr const & e2);
+    /** \brief Store the fact that \c e1 and \c e2 are not equivalent. */
+    void add_failure(expr const & e1, expr const & e2);
 };
 }
@@ -10,6 +10,7 @@ Author: Leonardo de Moura
 #include <string>
 #include <algorithm>
 #include <limits>
+#include <unordered_set>
 #include "util/list_fn.h"
 #include "util/hash.h"
 #include "util/buffer.h"
@@ -25,6 +26,10 @@ Author: Leonardo de Moura
 #define LEAN_INITIAL_EXPR_CACHE_CAPACITY 1024*16
 #endif
 
+#ifndef LEAN_EXPR_HASH_CONS_SHARDS
+#define LEAN_EXPR_HASH_CONS_SHARDS 64
+#endif
+
 namespace lean {
 unsigned add_weight(unsigned w1, unsigned w2) {
     unsigned r = w1 + w2;
@@ -105,6 +110,22 @@ void expr_cell::set_tag(tag t) {
     m_tag = t;
 }
 
+bool expr_cell::try_inc_ref() {
+#if defined(LEAN_MULTI_THREAD)
+    unsigned rc = m_rc.load(memory_order_relaxed);
+    while (rc != 0) {
+        if (m_rc.compare_exchange_weak(rc, rc + 1, memory_order_relaxed))
+            return true;
+    }
+    return false;
+#else
+    if (get_rc() == 0)
+        return false;
+    inc_ref();
+    return true;
+#endif
+}
+
 bool is_meta(expr const & e) {
     return is_metavar(get_app_fn(e));
 }
@@ -144,7 +165,7 @@ DEF_THREAD_MEMORY_POOL(get_mlocal_allocator, sizeof(expr_mlocal));
 expr_mlocal::expr_mlocal(bool is_meta, name const & n, expr const & t, tag g):
     expr_composite(is_meta ? expr_kind::Meta : expr_kind::Local, n.hash(), is_meta || t.has_expr_metavar(), t.has_univ_metavar(),
                    !is_meta || t.has_local(), t.has_param_univ(),
-                   1, get_free_var_range(t), g),
+                   1, get_free_var_range(t), mk_mlocal_filter(n) | get_mlocal_filter(t), g),
     m_name(n),
     m_type(t) {}
 void expr_mlocal::dealloc(buffer<expr_cell*> & todelete) {
@@ -166,10 +187,12 @@ void expr_local::dealloc(buffer<expr_cell*> & todelete) {
 
 // Composite expressions
 expr_composite::expr_composite(expr_kind k, unsigned h, bool has_expr_mv, bool has_univ_mv,
-                               bool has_local, bool has_param_univ, unsigned w, unsigned fv_range, tag g):
+                               bool has_local, bool has_param_univ, unsigned w, unsigned fv_range,
+                               unsigned mlocal_filter, tag g):
     expr_cell(k, h, has_expr_mv, has_univ_mv, has_local, has_param_univ, g),
     m_weight(w),
-    m_free_var_range(fv_range) {}
+    m_free_var_range(fv_range),
+    m_mlocal_filter(mlocal_filter) {}
 
 // Expr applications
 DEF_THREAD_MEMORY_POOL(get_app_allocator, sizeof(expr_app));
@@ -181,6 +204,7 @@ expr_app::expr_app(expr const & fn, expr const & arg, tag g):
                    fn.has_param_univ()   || arg.has_param_univ(),
                    inc_weight(add_weight(get_weight(fn), get_weight(arg))),
                    std::max(get_free_var_range(fn), get_free_var_range(arg)),
+                   get_mlocal_filter(fn) | get_mlocal_filter(arg),
                    g),
     m_fn(fn), m_arg(arg) {
     m_hash = ::lean::hash(m_hash, m_weight);
@@ -213,6 +237,7 @@ expr_binding::expr_binding(expr_kind k, name const & n, expr const & t, expr con
                    t.has_param_univ()     || b.has_param_univ(),
                    inc_weight(add_weight(get_weight(t), get_weight(b))),
                    std::max(get_free_var_range(t), dec(get_free_var_range(b))),
+                   get_mlocal_filter(t) | get_mlocal_filter(b),
                    g),
     m_binder(n, t, i),
     m_body(b) {
@@ -278,6 +303,13 @@ static unsigned get_free_var_range(unsigned num, expr const * args) {
     return r;
 }
 
+static unsigned get_mlocal_filter(unsigned num, expr const * args) {
+    unsigned r = 0;
+    for (unsigned i = 0; i < num; i++)
+        r |= get_mlocal_filter(args[i]);
+    return r;
+}
+
 expr_macro::expr_macro(macro_definition const & m, unsigned num, expr const * args, tag g):
     expr_composite(expr_kind::Macro,
                    lean::hash(num, [&](unsigned i) { return args[i].hash(); }, m.hash()),
@@ -287,6 +319,7 @@ expr_macro::expr_macro(macro_definition const & m, unsigned num, expr const * ar
                    std::any_of(args, args+num, [](expr const & e) { return e.has_param_univ(); }),
                    inc_weight(add_weight(num, args)),
                    get_free_var_range(num, args),
+                   get_mlocal_filter(num, args),
                    g),
     m_definition(m),
     m_num_args(num) {
@@ -326,11 +359,119 @@ inline expr cache(expr && e) { return e; }
 bool enable_expr_caching(bool) { return true; } // NOLINT
 #endif
 
+/**
+   \brief Global hash-consing table. It is split in shards to reduce contention.
+
+   The table does not keep cells alive. A cell is removed from the table when its reference
+   counter reaches zero (see expr_cell::dealloc). Between these two events, the cell is still in
+   the table, but it cannot be reused (see expr_cell::try_inc_ref).
+
+   The children of a cell in the table are usually in the table too. So, we use a shallow
+   equality test (i.e., pointer equality for children). When a child is not in the table, we may
+   miss some sharing, but the result is still correct.
+*/
+class expr_hash_cons_table {
+    struct cell_hash { unsigned operator()(expr_cell * c) const { return c->hash(); } };
+    struct cell_eq {
+        bool operator()(expr_cell * c1, expr_cell * c2) const {
+            if (c1->kind() != c2->kind() || c1->hash() != c2->hash())
+                return false;
+            switch (c1->kind()) {
+            case expr_kind::Var:
+                return var_idx(c1) == var_idx(c2);
+            case expr_kind::Sort:
+                return sort_level(c1) == sort_level(c2);
+            case expr_kind::Constant:
+                return const_name(c1) == const_name(c2) && const_levels(c1) == const_levels(c2);
+            case expr_kind::App:
+                return is_eqp(app_fn(c1), app_fn(c2)) && is_eqp(app_arg(c1), app_arg(c2));
+            case expr_kind::Lambda: case expr_kind::Pi:
+                return
+                    is_eqp(binding_domain(c1), binding_domain(c2)) &&
+                    is_eqp(binding_body(c1), binding_body(c2)) &&
+                    binding_name(c1) == binding_name(c2) &&
+                    binding_info(c1) == binding_info(c2);
+            default:
+                lean_unreachable();
+            }
+        }
+    };
+    typedef std::unordered_set<expr_cell *, cell_hash, cell_eq> cell_set;
+    struct shard {
+        mutex    m_mutex;
+        cell_set m_cells;
+    };
+    shard m_shards[LEAN_EXPR_HASH_CONS_SHARDS];
+    shard & get_shard(expr_cell * c) { return m_shards[c->hash() % LEAN_EXPR_HASH_CONS_SHARDS]; }
+public:
+    /** \brief Return a cell structurally equal to the (new) cell \c e. */
+    expr insert(expr const & e) {
+        expr_cell * c = e.raw();
+        shard & s = get_shard(c);
+        lock_guard<mutex> lock(s.m_mutex);
+        auto it = s.m_cells.find(c);
+        if (it != s.m_cells.end()) {
+            expr_cell * old = *it;
+            if (old->try_inc_ref()) {
+                expr r(old);
+                old->dec_ref_core(); // r is also holding a reference to old
+                return r;
+            }
+            // old is being deleted
+            s.m_cells.erase(it);
+        }
+        c->set_hash_consed();
+        s.m_cells.insert(c);
+        return e;
+    }
+
+    /** \brief Remove the given cell from the table.
+        \pre c->get_rc() == 0 */
+    void erase(expr_cell * c) {
+        shard & s = get_shard(c);
+        lock_guard<mutex> lock(s.m_mutex);
+        auto it = s.m_cells.find(c);
+        // remark: the cell may have been replaced by a new one
+        if (it != s.m_cells.end() && *it == c)
+            s.m_cells.erase(it);
+    }
+
+    unsigned size() {
+        unsigned r = 0;
+        for (shard & s : m_shards) {
+            lock_guard<mutex> lock(s.m_mutex);
+            r += s.m_cells.size();
+        }
+        return r;
+    }
+};
+
+static expr_hash_cons_table * g_hash_cons_table = nullptr;
+static atomic<bool> g_hash_cons_enabled(false);
+
+bool enable_expr_hash_consing(bool f) {
+    bool r = g_hash_cons_enabled;
+    g_hash_cons_enabled = f;
+    return r;
+}
+
+unsigned get_expr_hash_consing_size() {
+    return g_hash_cons_table ? g_hash_cons_table->size() : 0;
+}
+
+/** \brief Return the shared version of the new expression \c e. */
+inline expr share(expr && e) {
+    if (g_hash_cons_enabled && g_hash_cons_table)
+        return g_hash_cons_table->insert(e);
+    else
+        return cache(std::move(e));
+}
+
 expr mk_var(unsigned idx, tag g) {
-    return cache(expr(new (get_var_allocator().allocate()) expr_var(idx, g)));
+    return share(expr(new (get_var_allocator().allocate()) expr_var(idx, g)));
 }
 expr mk_constant(name const & n, levels const & ls, tag g) {
-    return cache(expr(new (get_const_allocator().allocate()) expr_const(n, ls, g)));
+    return share(expr(new (get_const_allocator().allocate()) expr_const(n, ls, g)));
 }
 expr mk_macro(macro_definition const & m, unsigned num, expr const * args, tag g) {
     return cache(expr(new expr_macro(m, num, args, g)));
@@ -342,13 +483,13 @@ expr mk_local(name const & n, name const & pp_n, expr const & t, binder_info con
     return cache(expr(new (get_local_allocator().allocate()) expr_local(n, pp_n, t, bi, g)));
 }
 expr mk_app(expr const & f, expr const & a, tag g) {
-    return cache(expr(new (get_app_allocator().allocate()) expr_app(f, a, g)));
+    return share(expr(new (get_app_allocator().allocate()) expr_app(f, a, g)));
 }
 expr mk_binding(expr_kind k, name const & n, expr const & t, expr const & e, binder_info const & i, tag g) {
-    return cache(expr(new (get_binding_allocator().allocate()) expr_binding(k, n, t, e, i, g)));
+    return share(expr(new (get_binding_allocator().allocate()) expr_binding(k, n, t, e, i, g)));
 }
 expr mk_sort(level const & l, tag g) {
-    return cache(expr(new (get_sort_allocator().allocate()) expr_sort(l, g)));
+    return share(expr(new (get_sort_allocator().allocate()) expr_sort(l, g)));
 }
 // =======================================
 
@@ -361,6 +502,8 @@ void expr_cell::dealloc() {
             expr_cell * it = todo.back();
             todo.pop_back();
             lean_assert(it->get_rc() == 0);
+            if (it->is_hash_consed() && g_hash_cons_table)
+                g_hash_cons_table->erase(it);
             switch (it->kind()) {
             case expr_kind::Var:        static_cast<expr_var*>(it)->dealloc(); break;
             case expr_kind::Macro:      static_cast<expr_macro*>(it)->dealloc(todo); break;
@@ -647,6 +790,7 @@ unsigned hash_bi(expr const & e) {
 }
 
 void initialize_expr() {
+    g_hash_cons_table = new expr_hash_cons_table();
     g_dummy        = new expr(mk_var(0));
     g_default_name = new name("a");
     g_Type1        = new expr(mk_sort(mk_level_one()));
@@ -658,5 +802,8 @@ void finalize_expr() {
     delete g_Type1;
     delete g_dummy;
     delete g_default_name;
+    expr_hash_cons_table * t = g_hash_cons_table;
+    g_hash_cons_table = nullptr;
+    delete t;
 }
 }
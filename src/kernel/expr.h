@@ -51,6 +51,7 @@ class expr_cell {
 protected:
     // The bits of the following field mean:
     //    0-1  - term is an arrow (0 - not initialized, 1 - is arrow, 2 - is not arrow)
+    //    2    - term is stored in the global hash-consing table (see enable_expr_hash_consing)
     // Remark: we use atomic_uchar because these flags are computed lazily (i.e., after the expression is created)
     atomic_uchar       m_flags;
     unsigned           m_kind:8;
@@ -68,6 +69,12 @@ protected:
     void set_is_arrow(bool flag);
     friend bool is_arrow(expr const & e);
 
+    bool is_hash_consed() const { return (m_flags & 4) != 0; }
+    void set_hash_consed() { m_flags |= 4; }
+    /** \brief Increment the reference counter if it is not zero, i.e., the cell is not being deleted. */
+    bool try_inc_ref();
+    friend class expr_hash_cons_table;
+
      static void dec_ref(expr & c, buffer<expr_cell*> & todelete);
 public:
     expr_cell(expr_kind k, unsigned h, bool has_expr_mv, bool has_univ_mv, bool has_local, bool has_param_univ, tag g);
@@ -97,6 +104,7 @@ private:
     friend class expr_cell;
     expr_cell * steal_ptr() { expr_cell * r = m_ptr; m_ptr = nullptr; return r; }
     friend class optional<expr>;
+    friend class expr_hash_cons_table;
 public:
     /**
       \brief The default constructor creates a reference to a "dummy"
@@ -186,11 +194,13 @@ class expr_composite : public expr_cell {
 protected:
     unsigned m_weight;
     unsigned m_free_var_range;
+    unsigned m_mlocal_filter; // see get_mlocal_filter
     friend unsigned get_weight(expr const & e);
     friend unsigned get_free_var_range(expr const & e);
+    friend unsigned get_mlocal_filter(expr const & e);
 public:
     expr_composite(expr_kind k, unsigned h, bool has_expr_mv, bool has_univ_mv, bool has_local,
-                   bool has_param_univ, unsigned w, unsigned fv_range, tag g);
+                   bool has_param_univ, unsigned w, unsigned fv_range, unsigned mlocal_filter, tag g);
 };
 
 /** \brief Metavariables and local constants */
@@ -492,6 +502,19 @@ struct scoped_expr_caching {
     scoped_expr_caching(bool f) { m_old = enable_expr_caching(f); }
     ~scoped_expr_caching() { enable_expr_caching(m_old); }
 };
+
+/**
+    \brief Enable/disable the global hash-consing table for variables, sorts, constants, applications and binders,
+    and return the previous value.
+
+    The table is shared by all threads, and does not keep expressions alive (i.e., it contains weak references).
+    When it is enabled, structurally equal expressions created by the functions mk_var, mk_sort, mk_constant,
+    mk_app and mk_binding are represented by the same cell (modulo tags), and the thread local expression cache
+    is not used by them. Expressions created when the table was disabled are not affected.
+*/
+bool enable_expr_hash_consing(bool f);
+/** \brief Return the number of expressions stored in the global hash-consing table. */
+unsigned get_expr_hash_consing_size();
 // =======================================
 
 // =======================================
@@ -555,6 +578,28 @@ inline unsigned get_free_var_range(expr const & e) {
     default:                                        return static_cast<expr_composite*>(e.raw())->m_free_var_range;
     }
 }
+/** \brief Return the bit used to represent metavariables and local constants named \c n in
+    the summaries returned by \c get_mlocal_filter. */
+inline unsigned mk_mlocal_filter(name const & n) { return 1u << (n.hash() & 31u); }
+/**
+   \brief Return a summary (bloom filter) of the names of the metavariables and local constants
+   occurring in \c e (including the ones occurring in their types). It is the union of
+   <tt>mk_mlocal_filter(n)</tt> for each name \c n.
+
+   \remark If <tt>get_mlocal_filter(e) & mk_mlocal_filter(n)</tt> is zero, then \c e does not contain
+   a metavariable/local constant named \c n. The converse is not true.
+*/
+inline unsigned get_mlocal_filter(expr const & e) {
+    switch (e.kind()) {
+    case expr_kind::Var: case expr_kind::Constant: case expr_kind::Sort: return 0;
+    default: return static_cast<expr_composite*>(e.raw())->m_mlocal_filter;
+    }
+}
+/** \brief Return false if \c e does not contain a metavariable or local constant named \c n.
+    \see get_mlocal_filter */
+inline bool may_contain_mlocal(expr const & e, name const & n) {
+    return (get_mlocal_filter(e) & mk_mlocal_filter(n)) != 0;
+}
 /** \brief Return true iff the given expression has free variables. */
 inline bool has_free_vars(expr const & e) { return get_free_var_range(e) > 0; }
 /** \brief Return true iff the given expression does not have free variables. */
@@ -4,10 +4,15 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <exception>
 #include "util/name_generator.h"
 #include "util/sstream.h"
 #include "util/list_fn.h"
 #include "util/rb_map.h"
+#include "util/thread_pool.h"
 #include "kernel/type_checker.h"
 #include "kernel/kernel_exception.h"
 #include "kernel/instantiate.h"
@@ -15,6 +20,10 @@ Author: Leonardo de Moura
 #include "kernel/inductive/inductive.h"
 #include "kernel/find_fn.h"
 
+#ifndef LEAN_INDUCTIVE_MIN_INTRO_RULES_PER_JOB
+#define LEAN_INDUCTIVE_MIN_INTRO_RULES_PER_JOB 8
+#endif
+
 /*
    The implementation is based on the paper: "Inductive Families", Peter Dybjer, 1997
    The main differences are:
@@ -213,6 +222,7 @@ struct add_inductive_fn {
     buffer<level>        m_it_levels;    // the levels for each inductive datatype in m_decls
     buffer<expr>         m_it_consts;    // the constants for each inductive datatype in m_decls
     buffer<unsigned>     m_it_num_args;  // total number of arguments (params + indices) for each inductive datatype in m_decls
+    std::vector<optional<certified_declaration>> m_intro_decls; // certified declaration for each introduction rule
 
     struct elim_info {
         expr             m_C;              // type former constant
@@ -235,6 +245,17 @@ struct add_inductive_fn {
         m_levels      = param_names_to_levels(level_params);
     }
 
+    /**
+        \brief Create a copy of \c s with its own type checker and name generator.
+        It is used to check introduction rules in parallel.
+    */
+    add_inductive_fn(add_inductive_fn const & s, name_generator const & ngen):
+        m_env(s.m_env), m_level_names(s.m_level_names), m_num_params(s.m_num_params), m_decls(s.m_decls),
+        m_is_not_zero(s.m_is_not_zero), m_decls_sz(s.m_decls_sz), m_levels(s.m_levels), m_ngen(ngen),
+        m_tc(new type_checker(m_env)), m_elim_level(s.m_elim_level), m_dep_elim(s.m_dep_elim),
+        m_param_consts(s.m_param_consts), m_it_levels(s.m_it_levels), m_it_consts(s.m_it_consts),
+        m_it_num_args(s.m_it_num_args) {}
+
     /** \brief Return the number of inductive datatypes being defined. */
     unsigned get_num_its() const { return m_decls_sz; }
 
@@ -391,10 +412,11 @@ struct add_inductive_fn {
 
     /**
        \brief Check the intro_rule \c ir of the given inductive decl. \c d_idx is the position of \c d in m_decls.
+       Return the certified declaration for \c ir.
 
        \see check_intro_rules
     */
-    void check_intro_rule(unsigned d_idx, intro_rule const & ir) {
+    certified_declaration check_intro_rule(unsigned d_idx, intro_rule const & ir) {
         expr t = intro_rule_type(ir);
         name n = intro_rule_name(ir);
         tc().check(t, m_level_names);
@@ -434,6 +456,7 @@ struct add_inductive_fn {
         }
         if (!is_valid_it_app(t, d_idx))
             throw kernel_exception(m_env, sstream() << "invalid return type for '" << n << "'");
+        return check(m_env, mk_constant_assumption(n, m_level_names, intro_rule_type(ir)));
     }
 
     /**
@@ -443,24 +466,80 @@ struct add_inductive_fn {
            - all inductive datatype occurrences are positive
            - all introduction rules are well typed
 
+        The introduction rules are independent of each other. So, when there are many of them,
+        they are checked in parallel. The certified declarations are stored in m_intro_decls.
+
         \remark this method must be executed after declare_inductive_types
     */
     void check_intro_rules() {
-        unsigned i = 0;
+        buffer<pair<unsigned, intro_rule>> irs; // (position of the inductive decl, intro rule)
+        unsigned d_idx = 0;
         for (auto d : m_decls) {
             for (auto ir : inductive_decl_intros(d))
-                check_intro_rule(i, ir);
-            i++;
+                irs.emplace_back(d_idx, ir);
+            d_idx++;
         }
+        m_intro_decls.clear();
+        m_intro_decls.resize(irs.size());
+#if defined(LEAN_MULTI_THREAD)
+        unsigned num_jobs = std::min(hardware_concurrency(), irs.size() / LEAN_INDUCTIVE_MIN_INTRO_RULES_PER_JOB);
+        if (num_jobs > 1)
+            return check_intro_rules(irs, num_jobs);
+#endif
+        for (unsigned i = 0; i < irs.size(); i++)
+            m_intro_decls[i] = check_intro_rule(irs[i].first, irs[i].second);
     }
 
-    /** \brief Add all introduction rules (aka constructors) to environment. */
+#if defined(LEAN_MULTI_THREAD)
+    /**
+        \brief Check the introduction rules \c irs using \c num_jobs jobs. Each job checks a contiguous
+        block of \c irs using its own type checker. If more than one block fails, we report the exception
+        for the first one. Thus, the error message is the one produced by the sequential version.
+
+        \remark job_group ignores exceptions thrown by jobs, then each job stores its own exception.
+    */
+    void check_intro_rules(buffer<pair<unsigned, intro_rule>> const & irs, unsigned num_jobs) {
+        std::vector<std::exception_ptr> exs(num_jobs);
+        {
+            job_group g;
+            for (unsigned j = 0; j < num_jobs; j++) {
+                name_generator ngen = m_ngen.mk_child();
+                unsigned begin      = (j * irs.size()) / num_jobs;
+                unsigned end        = ((j + 1) * irs.size()) / num_jobs;
+                g.add([=, &irs, &exs]() {
+                        add_inductive_fn w(*this, ngen);
+                        try {
+                            for (unsigned i = begin; i < end; i++)
+                                m_intro_decls[i] = w.check_intro_rule(irs[i].first, irs[i].second);
+                        } catch (...) {
+                            exs[j] = std::current_exception();
+                        }
+                    });
+            }
+            g.wait(num_jobs);
+        }
+        for (auto const & ex : exs) {
+            if (ex)
+                std::rethrow_exception(ex);
+        }
+        lean_assert(std::all_of(m_intro_decls.begin(), m_intro_decls.end(),
+                                [](optional<certified_declaration> const & d) { return static_cast<bool>(d); }));
+    }
+#endif
+
+    /**
+        \brief Add all introduction rules (aka constructors) to environment.
+        \pre check_intro_rules was executed
+    */
     void declare_intro_rules() {
         inductive_env_ext ext(get_extension(m_env));
+        unsigned i = 0;
         for (auto d : m_decls) {
             for (auto ir : inductive_decl_intros(d)) {
-                m_env = m_env.add(check(m_env, mk_constant_assumption(intro_rule_name(ir), m_level_names, intro_rule_type(ir))));
+                lean_assert(m_intro_decls[i]);
+                m_env = m_env.add(*m_intro_decls[i]);
                 ext.add_intro_info(intro_rule_name(ir), inductive_decl_name(d));
+                i++;
             }
         }
         m_env = update(m_env, ext);
@@ -1048,6 +1127,14 @@ optional<name> is_elim_rule(environment const & env, name const & n) {
         return optional<name>();
 }
 
+optional<pair<unsigned, expr>> get_comp_rule_rhs(environment const & env, name const & n) {
+    inductive_env_ext const & ext = get_extension(env);
+    if (auto it = ext.m_comp_rules.find(n))
+        return optional<pair<unsigned, expr>>(it->m_num_bu, it->m_comp_rhs);
+    else
+        return optional<pair<unsigned, expr>>();
+}
+
 optional<unsigned> get_elim_major_idx(environment const & env, name const & n) {
     inductive_env_ext const & ext = get_extension(env);
     if (auto it = ext.m_elim_info.find(n))
@@ -64,6 +64,14 @@ optional<name> is_intro_rule(environment const & env, name const & n);
 */
 optional<name> is_elim_rule(environment const & env, name const & n);
 
+/**
+   \brief If \c n is the name of an introduction rule in \c env, then return the number of arguments of \c n that
+   are not parameters, and the right-hand-side <tt>Fun (A, C, e, b, u), (e_k_i b u v)</tt> of the computational rule
+   associated with it. The universe level parameters of the right-hand-side are the ones of the corresponding eliminator.
+   Return none otherwise.
+*/
+optional<pair<unsigned, expr>> get_comp_rule_rhs(environment const & env, name const & n);
+
 /** \brief Given the eliminator \c n, this function return the position of major premise */
 optional<unsigned> get_elim_major_idx(environment const & env, name const & n);
 bool is_elim_meta_app(type_checker & tc, expr const & e);
@@ -41,7 +41,7 @@ expr instantiate(expr const & a, unsigned s, unsigned n, expr const * subst) {
     if (s == 0)
         if (auto r = instantiate_easy_fn<false>(n, subst)(a, true))
             return *r;
-    return replace(a, [=](expr const & m, unsigned offset) -> optional<expr> {
+    return replace_spine(a, [=](expr const & m, unsigned offset) -> optional<expr> {
             unsigned s1 = s + offset;
             if (s1 < s)
                 return some_expr(m); // overflow, vidx can't be >= max unsigned
@@ -72,7 +72,7 @@ expr instantiate_rev(expr const & a, unsigned n, expr const * subst) {
         return a;
     if (auto r = instantiate_easy_fn<true>(n, subst)(a, true))
         return *r;
-    return replace(a, [=](expr const & m, unsigned offset) -> optional<expr> {
+    return replace_spine(a, [=](expr const & m, unsigned offset) -> optional<expr> {
             if (offset >= get_free_var_range(m))
                 return some_expr(m); // expression m does not contain free variables with idx >= offset
             if (is_var(m)) {
@@ -14,9 +14,15 @@ Author: Leonardo de Moura
 #include "util/debug.h"
 #include "util/hash.h"
 #include "util/interrupt.h"
+#include "util/thread.h"
+#include "util/lru_cache.h"
 #include "kernel/level.h"
 #include "kernel/environment.h"
 
+#ifndef LEAN_INITIAL_LEVEL_CACHE_CAPACITY
+#define LEAN_INITIAL_LEVEL_CACHE_CAPACITY 1024*4
+#endif
+
 namespace lean {
 level_cell const & to_cell(level const & l) {
     return *l.m_ptr;
@@ -26,9 +32,12 @@ level_cell const & to_cell(level const & l) {
 struct level_cell {
     void dealloc();
     MK_LEAN_RC()
-    level_kind m_kind;
-    unsigned   m_hash;
-    level_cell(level_kind k, unsigned h):m_rc(0), m_kind(k), m_hash(h) {}
+    level_kind           m_kind;
+    unsigned             m_hash;
+    // Normal form of this level (see normalize). It is nullptr if it has not been computed yet,
+    // and it is this cell if the level is already in normal form.
+    atomic<level_cell *> m_normal;
+    level_cell(level_kind k, unsigned h):m_rc(0), m_kind(k), m_hash(h), m_normal(nullptr) {}
 };
 
 struct level_composite : public level_cell {
@@ -117,6 +126,9 @@ name const & level_id(level const & l) {
 }
 
 void level_cell::dealloc() {
+    level_cell * n = m_normal;
+    if (n && n != this)
+        n->dec_ref();
     switch (m_kind) {
     case level_kind::Succ:
         delete static_cast<level_succ*>(this);
@@ -191,8 +203,24 @@ bool is_explicit(level const & l) {
     lean_unreachable(); // LCOV_EXCL_LINE
 }
 
+#ifdef LEAN_CACHE_EXPRS
+/* Universe levels are hash-consed using a thread local cache. Thus, structurally equal levels
+   are usually pointer equal, and operator== and the normal form cache (see normalize) are
+   effective. */
+struct level_hash { unsigned operator()(level const & l) const { return l.hash(); } };
+typedef lru_cache<level, level_hash> level_cache;
+MK_THREAD_LOCAL_GET(level_cache, get_level_cache, LEAN_INITIAL_LEVEL_CACHE_CAPACITY);
+static level cache(level const & l) {
+    if (auto r = get_level_cache().insert(l))
+        return *r;
+    return l;
+}
+#else
+static level cache(level && l) { return l; }
+#endif
+
 level mk_succ(level const & l) {
-    return level(new level_succ(l));
+    return cache(level(new level_succ(l)));
 }
 
 /** \brief Convert (succ^k l) into (l, k). If l is not a succ, then return (l, 0) */
@@ -230,7 +258,7 @@ level mk_max(level const & l1, level const & l2)  {
             lean_assert(p1.second != p2.second);
             return p1.second > p2.second ? l1 : l2;
         } else {
-            return level(new level_max_core(false, l1, l2));
+            return cache(level(new level_max_core(false, l1, l2)));
         }
     }
 }
@@ -245,12 +273,12 @@ level mk_imax(level const & l1, level const & l2) {
     else if (l1 == l2)
         return l1;  // imax u u = u
     else
-        return level(new level_max_core(true,  l1, l2));
+        return cache(level(new level_max_core(true,  l1, l2)));
 }
 
-level mk_param_univ(name const & n) { return level(new level_param_core(level_kind::Param, n)); }
-level mk_global_univ(name const & n) { return level(new level_param_core(level_kind::Global, n)); }
-level mk_meta_univ(name const & n) { return level(new level_param_core(level_kind::Meta, n)); }
+level mk_param_univ(name const & n) { return cache(level(new level_param_core(level_kind::Param, n))); }
+level mk_global_univ(name const & n) { return cache(level(new level_param_core(level_kind::Global, n))); }
+level mk_meta_univ(name const & n) { return cache(level(new level_param_core(level_kind::Meta, n))); }
 
 static level * g_level_zero = nullptr;
 static level * g_level_one  = nullptr;
@@ -616,7 +644,7 @@ level mk_succ(level l, unsigned k) {
     return l;
 }
 
-level normalize(level const & l) {
+static level normalize_core(level const & l) {
     auto p = to_offset(l);
     level const & r = p.first;
     switch (kind(r)) {
@@ -683,6 +711,36 @@ level normalize(level const & l) {
     lean_unreachable(); // LCOV_EXCL_LINE
 }
 
+/** \brief Store \c n as the normal form of \c c, and return the normal form stored in \c c.
+    The result is not \c n if another thread has already stored a normal form for \c c. */
+static level_cell * set_normal(level_cell & c, level_cell * n) {
+    if (n != &c)
+        n->inc_ref();
+#if defined(LEAN_MULTI_THREAD)
+    level_cell * expected = nullptr;
+    if (c.m_normal.compare_exchange_strong(expected, n))
+        return n;
+    if (n != &c)
+        n->dec_ref(); // the caller also owns a reference to n
+    return expected;
+#else
+    c.m_normal = n;
+    return n;
+#endif
+}
+
+level normalize(level const & l) {
+    level_cell & c = const_cast<level_cell &>(to_cell(l));
+    if (level_cell * n = c.m_normal)
+        return level(n);
+    level r = normalize_core(l);
+    level_cell & rc = const_cast<level_cell &>(to_cell(r));
+    // r is in normal form, we mark it (without taking a reference) before publishing it as the normal form of c.
+    // Otherwise, normalizing r later could store a reference to c in r, and create a cycle.
+    level_cell * n = set_normal(rc, &rc);
+    return level(set_normal(c, n));
+}
+
 bool is_equivalent(level const & lhs, level const & rhs) {
     check_system("level constraints");
     return lhs == rhs || normalize(lhs) == normalize(rhs);
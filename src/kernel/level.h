@@ -148,7 +148,8 @@ level update_max(level const & l, level const & new_lhs, level const & new_rhs);
    The check is done by normalization.
 */
 bool is_equivalent(level const & lhs, level const & rhs);
-/** \brief Return the given level expression normal form */
+/** \brief Return the given level expression normal form
+    \remark The result is cached in the level, so subsequent calls are cheap. */
 level normalize(level const & l);
 
 /**
@@ -23,7 +23,7 @@ Author: Leonardo de Moura
 #endif
 
 namespace lean {
-substitution::substitution() {}
+substitution::substitution():m_assigned_filter(0) {}
 
 bool substitution::is_expr_assigned(name const & m) const {
     return m_expr_subst.contains(m);
@@ -66,6 +66,7 @@ void substitution::assign(expr const & mvar, buffer<expr> const & locals, expr c
 void substitution::assign(name const & m, expr const & t, justification const & j) {
     lean_assert(closed(t));
     m_expr_subst.insert(m, t);
+    m_assigned_filter |= mk_mlocal_filter(m);
     m_occs_map.erase(m);
     if (!j.is_none())
         m_expr_jsts.insert(m, j);
@@ -216,6 +217,8 @@ protected:
     expr visit(expr const & e) {
         if (!has_metavar(e))
             return e;
+        if (!has_univ_metavar(e) && !m_subst.may_contain_assigned(e))
+            return e; // e does not contain assigned metavariables
         check_system("instantiate metavars");
 
         if (auto it = m_cache->find(e))
@@ -335,6 +338,8 @@ bool substitution::occurs_expr(name const & m, expr const & e) {
     bool found = false;
     for_each(e, [&](expr const & e, unsigned) {
             if (found || !has_expr_metavar(e)) return false;
+            if (!may_contain_mlocal(e, m) && !may_contain_assigned(e))
+                return false; // e does not contain ?m, nor assigned metavariables that may contain it
             if (is_metavar(e)) {
                 name const & n = mlocal_name(e);
                 if (is_expr_assigned(n)) {
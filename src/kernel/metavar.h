@@ -34,6 +34,12 @@ private:
         This mapping is built (and updated) on demand, and is used to improve the performance of #occurs_expr.
     */
     occs_map  m_occs_map;
+    /** \brief Union of mk_mlocal_filter(?m) for every assigned metavariable ?m in m_expr_subst.
+        If <tt>get_mlocal_filter(e) & m_assigned_filter</tt> is zero, then \c e does not contain
+        assigned metavariables (see may_contain_assigned). */
+    unsigned  m_assigned_filter;
+
+    bool may_contain_assigned(expr const & e) const { return (get_mlocal_filter(e) & m_assigned_filter) != 0; }
 
     friend class instantiate_metavars_fn;
     pair<level, justification> instantiate_metavars(level const & l, bool use_jst);
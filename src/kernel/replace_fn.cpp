@@ -58,6 +58,30 @@ struct replace_cache {
 
 MK_CACHE_STACK(replace_cache, LEAN_DEFAULT_REPLACE_CACHE_CAPACITY)
 
+replace_cache * acquire_replace_cache() {
+    replace_cache_stack & s = get_replace_cache_stack();
+    lean_assert(s.m_top <= s.m_cache_stack.size());
+    if (s.m_top == s.m_cache_stack.size())
+        s.m_cache_stack.push_back(std::unique_ptr<replace_cache>(new replace_cache(LEAN_DEFAULT_REPLACE_CACHE_CAPACITY)));
+    return s.m_cache_stack[s.m_top++].get();
+}
+
+void release_replace_cache(replace_cache * c) {
+    replace_cache_stack & s = get_replace_cache_stack();
+    lean_assert(s.m_top > 0);
+    lean_assert(s.m_cache_stack[s.m_top - 1].get() == c);
+    s.m_top--;
+    c->clear();
+}
+
+expr const * find_replace_cache(replace_cache * c, expr const & e, unsigned offset) {
+    return c->find(e, offset);
+}
+
+void insert_replace_cache(replace_cache * c, expr const & e, unsigned offset, expr const & v) {
+    c->insert(e, offset, v);
+}
+
 class replace_rec_fn {
     replace_cache_ref                                     m_cache;
     std::function<optional<expr>(expr const &, unsigned)> m_f;
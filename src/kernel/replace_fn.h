@@ -8,6 +8,7 @@ Author: Leonardo de Moura
 #include <tuple>
 #include "util/buffer.h"
 #include "util/interrupt.h"
+#include "util/memory.h"
 #include "kernel/expr.h"
 #include "kernel/expr_maps.h"
 
@@ -24,4 +25,127 @@ expr replace(expr const & e, std::function<optional<expr>(expr const &, unsigned
 inline expr replace(expr const & e, std::function<optional<expr>(expr const &)> const & f, bool use_cache = true) {
     return replace(e, [&](expr const & e, unsigned) { return f(e); }, use_cache);
 }
+
+struct replace_cache;
+/** \brief Retrieve a cache from the thread local stack of caches used by \c replace.
+    \remark Caches must be released in the reverse order they were acquired. */
+replace_cache * acquire_replace_cache();
+void release_replace_cache(replace_cache * c);
+expr const * find_replace_cache(replace_cache * c, expr const & e, unsigned offset);
+void insert_replace_cache(replace_cache * c, expr const & e, unsigned offset, expr const & v);
+
+/**
+   \brief Template version of \c replace. The function object \c f is not wrapped in a \c std::function,
+   and application spines <tt>(f a_1 ... a_n)</tt> are traversed iteratively.
+   It is used to implement performance critical procedures such as \c instantiate and \c abstract_locals.
+
+   \remark \c f is invoked in the same order used by \c replace.
+*/
+template<typename F>
+class replace_spine_fn {
+    F const &       m_f;
+    replace_cache * m_cache;
+
+    expr save_result(expr const & e, unsigned offset, expr const & r, bool shared) {
+        if (shared)
+            insert_replace_cache(m_cache, e, offset, r);
+        return r;
+    }
+
+    /** \brief Return true if the result for \c e is \c r, i.e., it is in the cache or \c f produced it.
+        If the result was not found in the cache, then \c shared is set to true iff \c e should be cached. */
+    bool visit_node(expr const & e, unsigned offset, expr & r, bool & shared) {
+        shared = false;
+        if (m_cache && is_shared(e)) {
+            if (auto it = find_replace_cache(m_cache, e, offset)) {
+                r = *it;
+                return true;
+            }
+            shared = true;
+        }
+        check_interrupted();
+        check_memory("replace");
+        if (optional<expr> new_e = m_f(e, offset)) {
+            r = save_result(e, offset, *new_e, shared);
+            return true;
+        }
+        return false;
+    }
+
+    expr visit_app(expr const & e, unsigned offset, bool shared) {
+        // Remark: the nodes in the spine are visited from the root to the head,
+        // and rebuilt from the head to the root.
+        buffer<expr const *> spine;
+        buffer<bool>         spine_shared;
+        spine.push_back(&e);
+        spine_shared.push_back(shared);
+        expr r;
+        expr const * it = &app_fn(e);
+        while (true) {
+            bool it_shared;
+            if (visit_node(*it, offset, r, it_shared))
+                break;
+            if (!is_app(*it)) {
+                r = visit_children(*it, offset, it_shared);
+                break;
+            }
+            spine.push_back(it);
+            spine_shared.push_back(it_shared);
+            it = &app_fn(*it);
+        }
+        unsigned i = spine.size();
+        while (i > 0) {
+            --i;
+            expr const & s = *spine[i];
+            expr new_a = apply(app_arg(s), offset);
+            r = save_result(s, offset, update_app(s, r, new_a), spine_shared[i]);
+        }
+        return r;
+    }
+
+    expr visit_children(expr const & e, unsigned offset, bool shared) {
+        switch (e.kind()) {
+        case expr_kind::Constant: case expr_kind::Sort: case expr_kind::Var:
+            return save_result(e, offset, e, shared);
+        case expr_kind::Meta:     case expr_kind::Local: {
+            expr new_t = apply(mlocal_type(e), offset);
+            return save_result(e, offset, update_mlocal(e, new_t), shared);
+        }
+        case expr_kind::App:
+            return visit_app(e, offset, shared);
+        case expr_kind::Pi: case expr_kind::Lambda: {
+            expr new_d = apply(binding_domain(e), offset);
+            expr new_b = apply(binding_body(e), offset+1);
+            return save_result(e, offset, update_binding(e, new_d, new_b), shared);
+        }
+        case expr_kind::Macro: {
+            buffer<expr> new_args;
+            unsigned nargs = macro_num_args(e);
+            for (unsigned i = 0; i < nargs; i++)
+                new_args.push_back(apply(macro_arg(e, i), offset));
+            return save_result(e, offset, update_macro(e, new_args.size(), new_args.data()), shared);
+        }}
+        lean_unreachable();
+    }
+
+    expr apply(expr const & e, unsigned offset) {
+        expr r;
+        bool shared;
+        if (visit_node(e, offset, r, shared))
+            return r;
+        return visit_children(e, offset, shared);
+    }
+
+public:
+    replace_spine_fn(F const & f, bool use_cache):m_f(f), m_cache(use_cache ? acquire_replace_cache() : nullptr) {}
+    ~replace_spine_fn() { if (m_cache) release_replace_cache(m_cache); }
+    replace_spine_fn(replace_spine_fn const &) = delete;
+    replace_spine_fn & operator=(replace_spine_fn const &) = delete;
+
+    expr operator()(expr const & e) { return apply(e, 0); }
+};
+
+template<typename F> expr replace_spine(expr const & e, F const & f, bool use_cache = true) {
+    return replace_spine_fn<F>(f, use_cache)(e);
+}
 }
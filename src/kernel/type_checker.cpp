@@ -21,6 +21,7 @@ Author: Leonardo de Moura
 #include "kernel/kernel_exception.h"
 #include "kernel/abstract.h"
 #include "kernel/replace_fn.h"
+#include "kernel/for_each_fn.h"
 
 namespace lean {
 expr replace_range(expr const & type, expr const & new_range) {
@@ -501,6 +502,41 @@ certified_declaration check(environment const & env, declaration const & d) {
     return check(env, d, name_generator(*g_tmp_prefix));
 }
 
+static void check_cached_level(environment const & env, declaration const & d, level const & l, expr const & s) {
+    if (auto n1 = get_undef_global(l, env))
+        throw_kernel_exception(env, sstream() << "invalid reference to undefined global universe level '" << *n1 << "'", s);
+    if (auto n2 = get_undef_param(l, d.get_univ_params()))
+        throw_kernel_exception(env, sstream() << "invalid reference to undefined universe level parameter '"
+                               << *n2 << "'", s);
+}
+
+/** \brief Check whether all constants and universe levels occurring in \c e are defined. */
+static void check_cached_expr(environment const & env, declaration const & d, expr const & e) {
+    for_each(e, [&](expr const & c, unsigned) {
+            if (is_constant(c)) {
+                if (!env.find(const_name(c)))
+                    throw_unknown_declaration(env, const_name(c));
+                for (level const & l : const_levels(c))
+                    check_cached_level(env, d, l, c);
+            } else if (is_sort(c)) {
+                check_cached_level(env, d, sort_level(c), c);
+            }
+            return true;
+        });
+}
+
+certified_declaration check_cached(environment const & env, declaration const & d) {
+    if (d.is_definition()) {
+        check_no_mlocal(env, d.get_name(), d.get_value(), false);
+        check_cached_expr(env, d, d.get_value());
+    }
+    check_no_mlocal(env, d.get_name(), d.get_type(), true);
+    check_cached_expr(env, d, d.get_type());
+    check_name(env, d.get_name());
+    check_duplicated_params(env, d);
+    return certified_declaration(env.get_id(), d);
+}
+
 void initialize_type_checker() {
     g_tmp_prefix = new name(name::mk_internal_unique_name());
 }
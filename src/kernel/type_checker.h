@@ -235,6 +235,18 @@ void check_no_metavar(environment const & env, name const & n, expr const & e, b
 certified_declaration check(environment const & env, declaration const & d, name_generator const & g);
 certified_declaration check(environment const & env, declaration const & d);
 
+/**
+   \brief Return a certified declaration for \c d without type checking it.
+   Only inexpensive structural checks are performed: \c d must not contain metavariables
+   or local constants, its name must not be in \c env, its universe parameters must be distinct,
+   and every constant and universe level occurring in \c d must be defined.
+
+   \remark This is a trusted operation used to implement caches of kernel checks (see library/check_cache.h).
+   The caller is responsible for guaranteeing that \c d was type checked by the kernel in an environment
+   with the same configuration and where the declarations \c d depends on were the same.
+*/
+certified_declaration check_cached(environment const & env, declaration const & d);
+
 /**
     \brief Create a justification for an application \c e where the expected type must be \c d_type and
     the argument type is \c a_type.
@@ -0,0 +1,179 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include "util/sha256.h"
+#include "util/sstream.h"
+#include "util/serializer.h"
+#include "library/check_cache.h"
+#include "version.h"
+
+#if defined(LEAN_WINDOWS) && !defined(LEAN_CYGWIN)
+#define LEAN_NO_FILE_LOCK
+#include <process.h>
+#elif defined(LEAN_EMSCRIPTEN)
+#define LEAN_NO_FILE_LOCK
+#include <unistd.h>
+#else
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace lean {
+static char const * g_check_cache_header = "leancheckcache2";
+// header of the format where the keys were 64-bit hash codes, these files are ignored
+static char const * g_check_cache_v1_header = "leancheckcache";
+
+#if defined(LEAN_NO_FILE_LOCK)
+/** \brief File locks are not supported on this platform. Updates made by different processes
+    may be lost, but the cache file is never corrupted since it is replaced using rename. */
+class check_cache_file_lock {
+public:
+    check_cache_file_lock(std::string const &) {}
+};
+
+/** \brief Return a fresh file name in the same directory of \c fname. */
+static std::string mk_check_cache_tmp_file(std::string const & fname) {
+    static atomic<unsigned> g_counter(0);
+#if defined(LEAN_EMSCRIPTEN)
+    unsigned pid = getpid();
+#else
+    unsigned pid = _getpid();
+#endif
+    return fname + "." + std::to_string(pid) + "." + std::to_string(g_counter++) + ".tmp";
+}
+#else
+/** \brief Exclusive lock on the auxiliary file <tt>fname.lock</tt>.
+    It serializes updates to the cache file \c fname made by different processes. */
+class check_cache_file_lock {
+    int m_fd;
+public:
+    check_cache_file_lock(std::string const & fname) {
+        std::string lock_fname = fname + ".lock";
+        m_fd = open(lock_fname.c_str(), O_RDWR | O_CREAT, 0644);
+        if (m_fd < 0)
+            throw exception(sstream() << "failed to create lock file '" << lock_fname << "'");
+        if (flock(m_fd, LOCK_EX) != 0) {
+            close(m_fd);
+            throw exception(sstream() << "failed to lock file '" << lock_fname << "'");
+        }
+    }
+    ~check_cache_file_lock() {
+        flock(m_fd, LOCK_UN);
+        close(m_fd);
+    }
+};
+
+/** \brief Create a fresh file in the same directory of \c fname, and return its name. */
+static std::string mk_check_cache_tmp_file(std::string const & fname) {
+    std::string tmpl = fname + ".XXXXXX";
+    std::vector<char> buffer(tmpl.begin(), tmpl.end());
+    buffer.push_back(0);
+    int fd = mkstemp(buffer.data());
+    if (fd < 0)
+        throw exception(sstream() << "failed to create temporary file for check cache file '" << fname << "'");
+    close(fd);
+    return std::string(buffer.data());
+}
+#endif
+
+check_cache::check_cache(std::string const & fname):m_fname(fname) {
+    load(m_fname, m_keys);
+}
+
+static void write_key(serializer & s, check_cache::key const & k) {
+    s.write_chars(reinterpret_cast<char const *>(k.m_data), sizeof(k.m_data));
+}
+
+static check_cache::key read_key(deserializer & d) {
+    check_cache::key k;
+    for (unsigned char & c : k.m_data)
+        c = static_cast<unsigned char>(d.read_char());
+    return k;
+}
+
+void check_cache::load(std::string const & fname, key_set & keys) {
+    std::ifstream in(fname, std::ifstream::binary);
+    if (!in.good())
+        return; // cache does not exist yet
+    try {
+        deserializer d(in);
+        std::string header;
+        d >> header;
+        if (header == g_check_cache_v1_header)
+            return; // old format, the keys are discarded
+        if (header != g_check_cache_header)
+            throw exception(sstream() << "file '" << fname << "' is not a valid Lean check cache");
+        unsigned num = d.read_unsigned();
+        for (unsigned i = 0; i < num; i++)
+            keys.insert(read_key(d));
+    } catch (corrupted_stream_exception &) {
+        throw exception(sstream() << "check cache file '" << fname << "' is corrupted");
+    }
+}
+
+bool check_cache::contains(key const & k) const {
+    lock_guard<mutex> lock(m_mutex);
+    return m_keys.find(k) != m_keys.end();
+}
+
+void check_cache::insert(key const & k) {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_keys.insert(k).second)
+        m_new_keys.push_back(k);
+}
+
+void check_cache::save() {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_new_keys.empty())
+        return;
+    // other processes may update the file concurrently, the lock makes load+merge+rename atomic
+    check_cache_file_lock file_lock(m_fname);
+    key_set keys;
+    load(m_fname, keys);
+    keys.insert(m_new_keys.begin(), m_new_keys.end());
+    // write to an auxiliary file and rename it, readers never observe a partially written cache
+    std::string tmp_fname = mk_check_cache_tmp_file(m_fname);
+    bool ok;
+    {
+        std::ofstream out(tmp_fname, std::ofstream::binary);
+        serializer s(out);
+        s << g_check_cache_header;
+        s.write_unsigned(keys.size());
+        for (key const & k : keys)
+            write_key(s, k);
+        out.flush();
+        ok = out.good();
+    }
+    if (!ok || std::rename(tmp_fname.c_str(), m_fname.c_str()) != 0) {
+        std::remove(tmp_fname.c_str());
+        throw exception(sstream() << "failed to update check cache file '" << m_fname << "'");
+    }
+    m_new_keys.clear();
+}
+
+check_cache::key combine_check_cache_keys(check_cache::key const & k1, check_cache::key const & k2) {
+    sha256 h;
+    h.update(k1);
+    h.update(k2);
+    return h.finalize();
+}
+
+check_cache::key hash_check_cache_data(char const * begin, char const * end) {
+    return mk_sha256(begin, end);
+}
+
+check_cache::key mk_check_cache_config_key(environment const & env) {
+    unsigned flags = (env.prop_proof_irrel() ? 1 : 0) | (env.eta() ? 2 : 0) | (env.impredicative() ? 4 : 0);
+    std::string config = (sstream() << "lean " << LEAN_VERSION_MAJOR << "." << LEAN_VERSION_MINOR << "."
+                          << LEAN_VERSION_PATCH << " trust " << env.trust_lvl() << " flags " << flags).str();
+    return mk_sha256(config.data(), config.data() + config.size());
+}
+}
@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include "util/sha256.h"
+#include "util/thread.h"
+#include "kernel/environment.h"
+
+namespace lean {
+/**
+   \brief Persistent cache of declarations that have already been type checked by the kernel.
+
+   Each entry is a key (SHA-256 digest) that identifies a declaration and everything its type checking
+   depends on. The importer (see library/module.cpp) computes the key of an imported declaration
+   by combining:
+      - the digest of its binary representation in the .olean file;
+      - the kernel configuration (see mk_check_cache_config_key);
+      - the keys of all declarations it refers to.
+   Thus, a key can only be found in the cache if the same declaration was previously checked
+   in an environment containing the same dependencies (recursively).
+
+   \remark Soundness: when a key is found in the cache, the declaration is added to the environment
+   using check_cached, i.e., it is NOT type checked again. Thus, we are trusting the
+   cache file, and assuming there are no SHA-256 collisions between distinct keys.
+   Users who want the full soundness guarantees should not use this cache.
+*/
+class check_cache {
+public:
+    typedef sha256_digest key;
+private:
+    struct key_hash {
+        unsigned operator()(key const & k) const { return k.hash(); }
+    };
+    typedef std::unordered_set<key, key_hash> key_set;
+    std::string             m_fname;
+    mutable mutex           m_mutex;
+    key_set                 m_keys;
+    std::vector<key>        m_new_keys; // keys added since the cache was loaded
+    void load(std::string const & fname, key_set & keys);
+public:
+    /** \brief Create a cache associated with the given file. If the file exists, its contents are loaded. */
+    check_cache(std::string const & fname);
+    bool contains(key const & k) const;
+    void insert(key const & k);
+    /** \brief Store the new keys in the cache file. Keys added to the file by other processes are preserved. */
+    void save();
+};
+
+/** \brief Return a key that identifies the kernel configuration used to type check declarations in \c env. */
+check_cache::key mk_check_cache_config_key(environment const & env);
+/** \brief Key (digest) for the given memory region. */
+check_cache::key hash_check_cache_data(char const * begin, char const * end);
+/** \brief Combine two keys, the result is the digest of their concatenation. */
+check_cache::key combine_check_cache_keys(check_cache::key const & k1, check_cache::key const & k2);
+}
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <string>
+#include <memory>
 #include "util/lbool.h"
 #include "util/sstream.h"
 #include "kernel/instantiate.h"
@@ -12,6 +13,8 @@ Author: Leonardo de Moura
 #include "library/kernel_serializer.h"
 #include "library/reducible.h"
 #include "library/aliases.h"
+#include "library/discr_tree.h"
+#include "library/class_instance_cache.h"
 
 #ifndef LEAN_INSTANCE_DEFAULT_PRIORITY
 #define LEAN_INSTANCE_DEFAULT_PRIORITY 1000
@@ -32,12 +35,24 @@ struct class_entry {
         m_cmd_kind(class_entry_kind::MultiCmd), m_class(c) {}
 };
 
+/** \brief Return the conclusion of \c type, the bound variables are wildcards in discrimination trees. */
+static expr const & get_conclusion(expr const & type) {
+    expr const * it = &type;
+    while (is_pi(*it))
+        it = &binding_body(*it);
+    return *it;
+}
+
 struct class_state {
     typedef name_map<list<name>> class_instances;
     typedef name_map<unsigned>   instance_priorities;
     class_instances     m_instances;
     instance_priorities m_priorities;
     name_set            m_multiple; // set of classes that allow multiple solutions/instances
+    discr_tree<name>    m_tree;     // index for the conclusion of the instance types
+    std::shared_ptr<class_instance_cache> m_cache; // it is reset whenever a new instance is added
+
+    class_state():m_cache(std::make_shared<class_instance_cache>()) {}
 
     unsigned get_priority(name const & i) const {
         if (auto it = m_priorities.find(i))
@@ -69,7 +84,7 @@ struct class_state {
             m_instances.insert(c, list<name>());
     }
 
-    void add_instance(name const & c, name const & i, unsigned p) {
+    void add_instance(environment const & env, name const & c, name const & i, unsigned p) {
         auto it = m_instances.find(c);
         if (!it) {
             m_instances.insert(c, to_list(i));
@@ -78,6 +93,11 @@ struct class_state {
             m_instances.insert(c, insert(i, p, lst));
         }
         m_priorities.insert(i, p);
+        m_cache = std::make_shared<class_instance_cache>();
+        if (auto d = env.find(i))
+            m_tree.insert(env, get_conclusion(d->get_type()), i);
+        else
+            m_tree.insert(env, mk_var(0), i);
     }
 
     void add_multiple(name const & c) {
@@ -92,13 +112,13 @@ static std::string * g_key = nullptr;
 struct class_config {
     typedef class_state state;
     typedef class_entry entry;
-    static void add_entry(environment const &, io_state const &, state & s, entry const & e) {
+    static void add_entry(environment const & env, io_state const &, state & s, entry const & e) {
         switch (e.m_cmd_kind) {
         case class_entry_kind::ClassCmd:
             s.add_class(e.m_class);
             break;
         case class_entry_kind::InstanceCmd:
-            s.add_instance(e.m_class, e.m_instance, e.m_priority);
+            s.add_instance(env, e.m_class, e.m_instance, e.m_priority);
             break;
         case class_entry_kind::MultiCmd:
             s.add_multiple(e.m_class);
@@ -228,6 +248,24 @@ list<name> get_class_instances(environment const & env, name const & c) {
     return ptr_to_list(s.m_instances.find(c));
 }
 
+class_instance_cache & get_class_instance_cache(environment const & env) {
+    return *class_ext::get_state(env).m_cache;
+}
+
+list<name> get_class_instances(environment const & env, name const & c, expr const & type) {
+    class_state const & s = class_ext::get_state(env);
+    list<name> const * insts = s.m_instances.find(c);
+    if (!insts)
+        return list<name>();
+    expr const & conclusion = get_conclusion(type);
+    buffer<expr> args;
+    if (get_discr_tree_key(env, nullptr, conclusion, args).is_star())
+        return *insts; // index would return all instances
+    name_set candidates;
+    s.m_tree.find(env, conclusion, [&](name const & i) { candidates.insert(i); });
+    return filter(*insts, [&](name const & i) { return candidates.contains(i); });
+}
+
 /** \brief If the constant \c e is a class, return its name */
 optional<name> constant_is_ext_class(environment const & env, expr const & e) {
     name const & cls_name = const_name(e);
@@ -19,6 +19,12 @@ bool is_class(environment const & env, name const & c);
 bool is_instance(environment const & env, name const & i);
 /** \brief Return the instances of the given class. */
 list<name> get_class_instances(environment const & env, name const & c);
+/**
+    \brief Return the instances of the given class that may produce an element of \c type.
+    The result is a subset of #get_class_instances(env, c) (in the same order), and it is computed using
+    a discrimination tree indexing the conclusion of the instance types.
+*/
+list<name> get_class_instances(environment const & env, name const & c, expr const & type);
 /** \brief Return the classes in the given environment. */
 void get_classes(environment const & env, buffer<name> & classes);
 name get_class_name(environment const & env, expr const & e);
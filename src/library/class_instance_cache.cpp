@@ -0,0 +1,47 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include "util/hash.h"
+#include "library/class_instance_cache.h"
+
+namespace lean {
+class_instance_cache_key::class_instance_cache_key(expr const & type, list<expr> const & local_insts, unsigned flags):
+    m_type(type), m_local_instances(local_insts), m_flags(flags) {
+    m_hash = ::lean::hash(type.hash(), flags);
+    for (expr const & l : local_insts)
+        m_hash = ::lean::hash(m_hash, l.hash());
+}
+
+bool operator==(class_instance_cache_key const & k1, class_instance_cache_key const & k2) {
+    return
+        k1.m_hash == k2.m_hash && k1.m_flags == k2.m_flags &&
+        k1.m_type == k2.m_type && k1.m_local_instances == k2.m_local_instances;
+}
+
+class_instance_cache::class_instance_cache():m_hits(0), m_misses(0) {}
+
+optional<expr> class_instance_cache::find(environment const & env, class_instance_cache_key const & k) {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        auto it = m_entries.find(k);
+        if (it != m_entries.end() && env.get_id().is_descendant(it->second.m_env_id)) {
+            m_hits++;
+            return some_expr(it->second.m_solution);
+        }
+    }
+    m_misses++;
+    return none_expr();
+}
+
+void class_instance_cache::insert(environment const & env, class_instance_cache_key const & k, expr const & solution) {
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_entries.find(k);
+    if (it == m_entries.end())
+        m_entries.insert(mk_pair(k, entry(env.get_id(), solution)));
+    else
+        it->second = entry(env.get_id(), solution);
+}
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <unordered_map>
+#include "util/thread.h"
+#include "kernel/environment.h"
+
+namespace lean {
+/**
+   \brief Key for the class-instance resolution cache.
+   It contains the type of the instance being synthesized (without metavariables), the local instances
+   that may be used to solve the problem, and flags identifying the resolution procedure configuration.
+*/
+class class_instance_cache_key {
+    expr       m_type;
+    list<expr> m_local_instances;
+    unsigned   m_flags;
+    unsigned   m_hash;
+public:
+    class_instance_cache_key(expr const & type, list<expr> const & local_insts, unsigned flags);
+    unsigned hash() const { return m_hash; }
+    friend bool operator==(class_instance_cache_key const & k1, class_instance_cache_key const & k2);
+};
+
+/**
+   \brief Table for class-instance resolution. It maps resolution problems to solutions.
+   Each environment has its own table (see #get_class_instance_cache), and a new table is created
+   whenever a new instance is declared.
+
+   A solution is only reused in environments that are descendants of the one used to compute it,
+   this is important because a problem may contain constants that are redefined when a file is
+   reprocessed (e.g., by the server).
+
+   \remark This object is thread safe.
+*/
+class class_instance_cache {
+    struct key_hash {
+        unsigned operator()(class_instance_cache_key const & k) const { return k.hash(); }
+    };
+    struct entry {
+        environment_id m_env_id;
+        expr           m_solution;
+        entry(environment_id const & id, expr const & s):m_env_id(id), m_solution(s) {}
+    };
+    mutable mutex m_mutex;
+    std::unordered_map<class_instance_cache_key, entry, key_hash> m_entries;
+    atomic<unsigned> m_hits;
+    atomic<unsigned> m_misses;
+public:
+    class_instance_cache();
+    /** \brief Return a solution for the problem \c k computed in an ancestor of \c env. */
+    optional<expr> find(environment const & env, class_instance_cache_key const & k);
+    void insert(environment const & env, class_instance_cache_key const & k, expr const & solution);
+    unsigned get_num_hits() const { return m_hits; }
+    unsigned get_num_misses() const { return m_misses; }
+};
+
+/** \brief Return the class-instance resolution table for \c env. */
+class_instance_cache & get_class_instance_cache(environment const & env);
+}
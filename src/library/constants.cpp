@@ -96,6 +96,7 @@ name const * g_tactic_now = nullptr;
 name const * g_tactic_opt_expr_list = nullptr;
 name const * g_tactic_or_else = nullptr;
 name const * g_tactic_par = nullptr;
+name const * g_tactic_portfolio_tac = nullptr;
 name const * g_tactic_sexact = nullptr;
 name const * g_tactic_state = nullptr;
 name const * g_tactic_rename = nullptr;
@@ -104,6 +105,8 @@ name const * g_tactic_revert = nullptr;
 name const * g_tactic_reverts = nullptr;
 name const * g_tactic_rotate_left = nullptr;
 name const * g_tactic_rotate_right = nullptr;
+name const * g_tactic_tactic_list_cons = nullptr;
+name const * g_tactic_tactic_list_nil = nullptr;
 name const * g_tactic_trace = nullptr;
 name const * g_tactic_try_for = nullptr;
 name const * g_tactic_unfold = nullptr;
@@ -209,6 +212,7 @@ void initialize_constants() {
     g_tactic_opt_expr_list = new name{"tactic", "opt_expr_list"};
     g_tactic_or_else = new name{"tactic", "or_else"};
     g_tactic_par = new name{"tactic", "par"};
+    g_tactic_portfolio_tac = new name{"tactic", "portfolio_tac"};
     g_tactic_sexact = new name{"tactic", "sexact"};
     g_tactic_state = new name{"tactic", "state"};
     g_tactic_rename = new name{"tactic", "rename"};
@@ -217,6 +221,8 @@ void initialize_constants() {
     g_tactic_reverts = new name{"tactic", "reverts"};
     g_tactic_rotate_left = new name{"tactic", "rotate_left"};
     g_tactic_rotate_right = new name{"tactic", "rotate_right"};
+    g_tactic_tactic_list_cons = new name{"tactic", "tactic_list", "cons"};
+    g_tactic_tactic_list_nil = new name{"tactic", "tactic_list", "nil"};
     g_tactic_trace = new name{"tactic", "trace"};
     g_tactic_try_for = new name{"tactic", "try_for"};
     g_tactic_unfold = new name{"tactic", "unfold"};
@@ -323,6 +329,7 @@ void finalize_constants() {
     delete g_tactic_opt_expr_list;
     delete g_tactic_or_else;
     delete g_tactic_par;
+    delete g_tactic_portfolio_tac;
     delete g_tactic_sexact;
     delete g_tactic_state;
     delete g_tactic_rename;
@@ -331,6 +338,8 @@ void finalize_constants() {
     delete g_tactic_reverts;
     delete g_tactic_rotate_left;
     delete g_tactic_rotate_right;
+    delete g_tactic_tactic_list_cons;
+    delete g_tactic_tactic_list_nil;
     delete g_tactic_trace;
     delete g_tactic_try_for;
     delete g_tactic_unfold;
@@ -436,6 +445,7 @@ name const & get_tactic_now_name() { return *g_tactic_now; }
 name const & get_tactic_opt_expr_list_name() { return *g_tactic_opt_expr_list; }
 name const & get_tactic_or_else_name() { return *g_tactic_or_else; }
 name const & get_tactic_par_name() { return *g_tactic_par; }
+name const & get_tactic_portfolio_tac_name() { return *g_tactic_portfolio_tac; }
 name const & get_tactic_sexact_name() { return *g_tactic_sexact; }
 name const & get_tactic_state_name() { return *g_tactic_state; }
 name const & get_tactic_rename_name() { return *g_tactic_rename; }
@@ -444,6 +454,8 @@ name const & get_tactic_revert_name() { return *g_tactic_revert; }
 name const & get_tactic_reverts_name() { return *g_tactic_reverts; }
 name const & get_tactic_rotate_left_name() { return *g_tactic_rotate_left; }
 name const & get_tactic_rotate_right_name() { return *g_tactic_rotate_right; }
+name const & get_tactic_tactic_list_cons_name() { return *g_tactic_tactic_list_cons; }
+name const & get_tactic_tactic_list_nil_name() { return *g_tactic_tactic_list_nil; }
 name const & get_tactic_trace_name() { return *g_tactic_trace; }
 name const & get_tactic_try_for_name() { return *g_tactic_try_for; }
 name const & get_tactic_unfold_name() { return *g_tactic_unfold; }
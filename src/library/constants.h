@@ -98,6 +98,7 @@ name const & get_tactic_now_name();
 name const & get_tactic_opt_expr_list_name();
 name const & get_tactic_or_else_name();
 name const & get_tactic_par_name();
+name const & get_tactic_portfolio_tac_name();
 name const & get_tactic_sexact_name();
 name const & get_tactic_state_name();
 name const & get_tactic_rename_name();
@@ -106,6 +107,8 @@ name const & get_tactic_revert_name();
 name const & get_tactic_reverts_name();
 name const & get_tactic_rotate_left_name();
 name const & get_tactic_rotate_right_name();
+name const & get_tactic_tactic_list_cons_name();
+name const & get_tactic_tactic_list_nil_name();
 name const & get_tactic_trace_name();
 name const & get_tactic_try_for_name();
 name const & get_tactic_unfold_name();
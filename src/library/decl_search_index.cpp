@@ -0,0 +1,243 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "library/decl_search_index.h"
+
+namespace lean {
+static unsigned mk_trigram(std::string const & s, unsigned i) {
+    return
+        (static_cast<unsigned>(static_cast<unsigned char>(s[i]))   << 16) |
+        (static_cast<unsigned>(static_cast<unsigned char>(s[i+1])) << 8)  |
+        static_cast<unsigned>(static_cast<unsigned char>(s[i+2]));
+}
+
+/** \brief Return the head of the conclusion of \c type, constants are not unfolded. */
+static head_index get_conclusion_head(expr const & type) {
+    expr it = type;
+    while (is_pi(it))
+        it = binding_body(it);
+    return head_index(it);
+}
+
+/** \brief Return true if \c d is a definition that may be unfolded by the matcher. */
+static bool is_unfoldable(declaration const * d) {
+    return d && d->is_definition() && !d->is_theorem();
+}
+
+/**
+   \brief Return true if the declarations whose conclusion has head \c h are stored in \c m_heads.
+
+   \remark When the head is a definition (e.g., <tt>transitive R</tt>, <tt>injective f</tt>), the matcher
+   may unfold it (see \c get_expect_num_args), and the actual conclusion is not known. These declarations are
+   stored in \c m_other_heads, and they are candidates for any query.
+*/
+bool decl_search_index::is_indexed_head(head_index const & h) const {
+    if (h.m_kind == expr_kind::Sort)
+        return true;
+    if (h.m_kind != expr_kind::Constant)
+        return false;
+    if (m_env) {
+        if (auto d = m_env->find(h.m_const_name))
+            return !is_unfoldable(&*d);
+    }
+    return true;
+}
+
+decl_search_index::decl_search_index():m_keys_sorted(true), m_num_removed(0) {}
+
+void decl_search_index::clear() {
+    m_env = optional<environment>();
+    m_entries.clear();
+    m_entry_idx.clear();
+    m_trigrams.clear();
+    m_keys.clear();
+    m_keys_sorted = true;
+    m_heads.clear();
+    m_other_heads.clear();
+    m_num_removed = 0;
+}
+
+void decl_search_index::add_head(unsigned i) {
+    head_index const & h = m_entries[i].m_head;
+    if (is_indexed_head(h))
+        m_heads[h].push_back(i);
+    else
+        m_other_heads.push_back(i);
+}
+
+void decl_search_index::add(declaration const & d) {
+    unsigned i = m_entries.size();
+    m_entries.push_back(entry(d, d.get_name().to_string(), get_conclusion_head(d.get_type())));
+    m_entry_idx.insert(d.get_name(), i);
+    std::string const & s = m_entries[i].m_name;
+    // trigrams
+    if (s.size() >= 3) {
+        std::vector<unsigned> gs;
+        for (unsigned j = 0; j + 2 < s.size(); j++)
+            gs.push_back(mk_trigram(s, j));
+        std::sort(gs.begin(), gs.end());
+        gs.erase(std::unique(gs.begin(), gs.end()), gs.end());
+        for (unsigned g : gs)
+            m_trigrams[g].push_back(i);
+    }
+    // keys
+    m_keys.emplace_back(s, i);
+    name const & n = d.get_name();
+    if (!n.is_atomic() && n.is_string())
+        m_keys.emplace_back(std::string(n.get_string()), i);
+    m_keys_sorted = false;
+    add_head(i);
+}
+
+void decl_search_index::remove_head(unsigned i) {
+    head_index const & h = m_entries[i].m_head;
+    std::vector<unsigned> & v = is_indexed_head(h) ? m_heads[h] : m_other_heads;
+    v.erase(std::find(v.begin(), v.end(), i));
+}
+
+void decl_search_index::replace(unsigned i, declaration const & d) {
+    entry & e = m_entries[i];
+    head_index new_head = get_conclusion_head(d.get_type());
+    e.m_decl = d;
+    if (head_index::cmp()(e.m_head, new_head) != 0) {
+        remove_head(i);
+        e.m_head = new_head;
+        add_head(i);
+    }
+}
+
+void decl_search_index::remove(unsigned i) {
+    // Remark: the keys and trigrams are not updated, #filter removes the entry from query results.
+    entry & e = m_entries[i];
+    lean_assert(!e.m_removed);
+    remove_head(i);
+    m_entry_idx.erase(e.m_decl.get_name());
+    e.m_removed = true;
+    m_num_removed++;
+}
+
+void decl_search_index::update(environment const & env) {
+    if (m_env && m_env->is_descendant(env) && env.is_descendant(*m_env))
+        return; // same environment
+    if (m_env && 2 * m_num_removed <= m_entries.size()) {
+        environment old_env = *m_env;
+        m_env = env; // the heads are classified with respect to the new environment
+        bool rebuild = false;
+        env.for_each_declaration_diff(old_env, [&](declaration const * d, declaration const * old_d) {
+                if (rebuild)
+                    return;
+                name const & n = d ? d->get_name() : old_d->get_name();
+                if (is_unfoldable(d) != is_unfoldable(old_d)) {
+                    auto it = m_heads.find(head_index(n));
+                    if (it != m_heads.end() && !it->second.empty()) {
+                        // the classification of the declarations whose conclusion head is n has changed
+                        rebuild = true;
+                        return;
+                    }
+                }
+                if (d) {
+                    if (unsigned const * i = m_entry_idx.find(d->get_name()))
+                        replace(*i, *d);
+                    else
+                        add(*d);
+                } else if (unsigned const * i = m_entry_idx.find(n)) {
+                    remove(*i);
+                }
+            });
+        if (!rebuild)
+            return;
+    }
+    clear();
+    m_env = env;
+    env.for_each_declaration([&](declaration const & d) { add(d); });
+}
+
+optional<unsigned> decl_search_index::find(name const & n) const {
+    if (unsigned const * i = m_entry_idx.find(n))
+        return optional<unsigned>(*i);
+    return optional<unsigned>();
+}
+
+void decl_search_index::sort_keys() {
+    if (!m_keys_sorted) {
+        std::sort(m_keys.begin(), m_keys.end());
+        m_keys_sorted = true;
+    }
+}
+
+void decl_search_index::find_prefix(std::string const & prefix, buffer<unsigned> & r) {
+    sort_keys();
+    auto it = std::lower_bound(m_keys.begin(), m_keys.end(), pair<std::string, unsigned>(prefix, 0));
+    for (; it != m_keys.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+        r.push_back(it->second);
+}
+
+void decl_search_index::find_fuzzy(std::string const & pattern, unsigned max_errors, buffer<unsigned> & r) const {
+    // q-gram lemma: if the pattern occurs in a string with at most k errors, then at least
+    // (|pattern| - q + 1) - k*q of the q-grams of the pattern occur in the string.
+    int threshold = static_cast<int>(pattern.size()) - 2 - 3 * static_cast<int>(max_errors);
+    if (threshold <= 0) {
+        find_all(r);
+        return;
+    }
+    std::vector<unsigned> gs;
+    for (unsigned j = 0; j + 2 < pattern.size(); j++)
+        gs.push_back(mk_trigram(pattern, j));
+    std::sort(gs.begin(), gs.end());
+    std::unordered_map<unsigned, int> score;
+    unsigned j = 0;
+    while (j < gs.size()) {
+        // the number of occurrences of the trigram in the pattern is its weight
+        unsigned k = j;
+        while (k < gs.size() && gs[k] == gs[j])
+            k++;
+        auto it = m_trigrams.find(gs[j]);
+        if (it != m_trigrams.end()) {
+            for (unsigned i : it->second)
+                score[i] += k - j;
+        }
+        j = k;
+    }
+    for (auto const & p : score) {
+        if (p.second >= threshold)
+            r.push_back(p.first);
+    }
+}
+
+void decl_search_index::find_conclusion(expr const & type, buffer<unsigned> & r) const {
+    head_index h = get_conclusion_head(type);
+    if (!is_indexed_head(h)) {
+        find_all(r);
+        return;
+    }
+    auto it = m_heads.find(h);
+    if (it != m_heads.end())
+        r.append(it->second.size(), it->second.data());
+    r.append(m_other_heads.size(), m_other_heads.data());
+}
+
+void decl_search_index::find_all(buffer<unsigned> & r) const {
+    for (unsigned i = 0; i < m_entries.size(); i++)
+        r.push_back(i);
+}
+
+void decl_search_index::filter(environment const & env, buffer<unsigned> & r) const {
+    lean_assert(m_env && m_env->is_descendant(env) && env.is_descendant(*m_env));
+    std::sort(r.begin(), r.end(), [&](unsigned i1, unsigned i2) {
+            return quick_cmp(m_entries[i1].m_decl.get_name(), m_entries[i2].m_decl.get_name()) < 0;
+        });
+    unsigned j = 0;
+    for (unsigned k = 0; k < r.size(); k++) {
+        unsigned i = r[k];
+        if ((j == 0 || r[j-1] != i) && !m_entries[i].m_removed)
+            r[j++] = i;
+    }
+    r.shrink(j);
+}
+}
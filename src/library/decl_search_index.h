@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include "util/buffer.h"
+#include "util/name_map.h"
+#include "kernel/environment.h"
+#include "library/head_map.h"
+
+namespace lean {
+/**
+   \brief Index for searching declarations by name and by the head symbol of their conclusion.
+   It is used to implement auto-completion (FINDP), goal matching (FINDG) and the find_decl command.
+
+   The index contains:
+   - The string representation of each declaration name, and a trigram index over them.
+   - A sorted table mapping the name and its last component to the declaration.
+   - A map from the head symbol of the conclusion of each declaration type (see \c head_index).
+     Declarations whose conclusion head is a definition are not in this map, since the matcher may unfold it.
+
+   The index is updated incrementally (see #update), only the declarations that were added, replaced or removed
+   since the previous update are processed. Removed declarations are just marked, the query methods may still
+   return them, then the results must be filtered using #filter. The index is rebuilt when most of its
+   entries have been removed.
+
+   \remark This object is not thread safe.
+*/
+class decl_search_index {
+    struct entry {
+        declaration m_decl;
+        std::string m_name; // string representation of the declaration name
+        head_index  m_head; // head of the conclusion of the declaration type
+        bool        m_removed;
+        entry(declaration const & d, std::string const & n, head_index const & h):
+            m_decl(d), m_name(n), m_head(h), m_removed(false) {}
+    };
+    typedef std::vector<pair<std::string, unsigned>>             key_table;
+    typedef std::unordered_map<unsigned, std::vector<unsigned>> trigram_table;
+    struct head_lt {
+        bool operator()(head_index const & h1, head_index const & h2) const { return head_index::cmp()(h1, h2) < 0; }
+    };
+    typedef std::map<head_index, std::vector<unsigned>, head_lt> head_table;
+    optional<environment>  m_env; // last environment used to update the index
+    std::vector<entry>     m_entries;
+    name_map<unsigned>     m_entry_idx;
+    trigram_table          m_trigrams;
+    key_table              m_keys;
+    bool                   m_keys_sorted;
+    head_table             m_heads;
+    std::vector<unsigned>  m_other_heads; // declarations whose conclusion head is not a sort nor a constant, or is a definition
+    unsigned               m_num_removed;
+
+    void add(declaration const & d);
+    void replace(unsigned i, declaration const & d);
+    void remove(unsigned i);
+    void remove_head(unsigned i);
+    void clear();
+    bool is_indexed_head(head_index const & h) const;
+    void add_head(unsigned i);
+    void sort_keys();
+public:
+    decl_search_index();
+    /**
+        \brief Make sure the declarations in the index are the ones in \c env.
+        It is a no-op if \c env is the environment used in the previous call.
+    */
+    void update(environment const & env);
+
+    declaration const & get_decl(unsigned i) const { return m_entries[i].m_decl; }
+    /** \brief Return the position of the declaration named \c n in the index. */
+    optional<unsigned> find(name const & n) const;
+    /** \brief Return the string representation of the name of the i-th declaration */
+    std::string const & get_name_str(unsigned i) const { return m_entries[i].m_name; }
+
+    /** \brief Store in \c r the declarations such that their name or the last component of their name starts with \c prefix. */
+    void find_prefix(std::string const & prefix, buffer<unsigned> & r);
+    /**
+        \brief Store in \c r a superset of the declarations whose name contains \c pattern with at most \c max_errors
+        errors (insertions, deletions and substitutions). The candidates are selected using the q-gram lemma.
+    */
+    void find_fuzzy(std::string const & pattern, unsigned max_errors, buffer<unsigned> & r) const;
+    /**
+        \brief Store in \c r a superset of the declarations whose conclusion may be unified with the conclusion of \c type
+        when constants are not unfolded.
+    */
+    void find_conclusion(expr const & type, buffer<unsigned> & r) const;
+    /** \brief Store in \c r all declarations in the index. */
+    void find_all(buffer<unsigned> & r) const;
+    /**
+        \brief Remove from \c r the declarations that are not in \c env (i.e., removed entries), and duplicates.
+        The remaining declarations are sorted in the order used by environment::for_each_declaration.
+
+        \pre #update(env) was the last update.
+    */
+    void filter(environment const & env, buffer<unsigned> & r) const;
+};
+}
@@ -16,6 +16,7 @@ Author: Leonardo de Moura
 #include "library/bin_app.h"
 #include "library/util.h"
 #include "library/normalize.h"
+#include "library/definitional/checked_decls.h"
 
 namespace lean {
 static void throw_corrupted(name const & n) {
@@ -145,7 +146,7 @@ static environment mk_below(environment const & env, name const & n, bool ibelow
     bool use_conv_opt = true;
     declaration new_d = mk_definition(env, below_name, blvls, below_type, below_value,
                                       opaque, rec_decl.get_module_idx(), use_conv_opt);
-    environment new_env = module::add(env, check(env, new_d));
+    environment new_env = module::add(env, check_aux_decl(env, new_d));
     new_env = set_reducible(new_env, below_name, reducible_status::Reducible);
     new_env = add_unfold_c_hint(new_env, below_name, nparams + nindices + ntypeformers);
     return add_protected(new_env, below_name);
@@ -331,7 +332,7 @@ static environment mk_brec_on(environment const & env, name const & n, bool ind)
     bool use_conv_opt = true;
     declaration new_d = mk_definition(env, brec_on_name, blps, brec_on_type, brec_on_value,
                                       opaque, rec_decl.get_module_idx(), use_conv_opt);
-    environment new_env = module::add(env, check(env, new_d));
+    environment new_env = module::add(env, check_aux_decl(env, new_d));
     new_env = set_reducible(new_env, brec_on_name, reducible_status::Reducible);
     new_env = add_unfold_c_hint(new_env, brec_on_name, nparams + nindices + ntypeformers);
     return add_protected(new_env, brec_on_name);
@@ -15,6 +15,7 @@ Author: Leonardo de Moura
 #include "library/reducible.h"
 #include "library/constants.h"
 #include "library/normalize.h"
+#include "library/definitional/checked_decls.h"
 
 namespace lean {
 static void throw_corrupted(name const & n) {
@@ -181,7 +182,7 @@ environment mk_cases_on(environment const & env, name const & n) {
     bool use_conv_opt = true;
     declaration new_d = mk_definition(env, cases_on_name, rec_decl.get_univ_params(), cases_on_type, cases_on_value,
                                       opaque, rec_decl.get_module_idx(), use_conv_opt);
-    environment new_env = module::add(env, check(env, new_d));
+    environment new_env = module::add(env, check_aux_decl(env, new_d));
     new_env = set_reducible(new_env, cases_on_name, reducible_status::Reducible);
     new_env = add_unfold_c_hint(new_env, cases_on_name, cases_on_major_idx);
     return add_protected(new_env, cases_on_name);
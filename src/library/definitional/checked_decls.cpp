@@ -0,0 +1,181 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <memory>
+#include "util/name_set.h"
+#include "util/buffer.h"
+#include "util/thread_pool.h"
+#include "kernel/for_each_fn.h"
+#include "kernel/type_checker.h"
+#include "library/definitional/checked_decls.h"
+
+namespace lean {
+/** \brief Return true if \c d1 and \c d2 are structurally equal. */
+static bool is_same_decl(declaration const & d1, declaration const & d2) {
+    if (is_eqp(d1, d2))
+        return true;
+    if (d1.get_name() != d2.get_name() ||
+        d1.is_definition() != d2.is_definition() ||
+        d1.is_theorem() != d2.is_theorem() ||
+        d1.is_axiom() != d2.is_axiom() ||
+        d1.get_univ_params() != d2.get_univ_params() ||
+        d1.get_type() != d2.get_type())
+        return false;
+    if (!d1.is_definition())
+        return true;
+    return
+        d1.is_opaque() == d2.is_opaque() &&
+        d1.use_conv_opt() == d2.use_conv_opt() &&
+        d1.get_weight() == d2.get_weight() &&
+        d1.get_value() == d2.get_value();
+}
+
+/**
+   \brief Return true if the constants occurring in \c e, and the ones they depend on (transitively),
+   are the same in \c env1 and \c env2.
+
+   \remark It is not enough to compare the constants occurring in \c e. An unchanged definition may
+   unfold to a constant that has been modified (e.g., \c c := c2 where \c c2 has been edited).
+   The values of theorems are not visited since the kernel does not unfold them.
+   The traversal stops at imported declarations that are pointer equal in both environments.
+*/
+static bool same_dependencies(environment const & env1, environment const & env2, expr const & e, name_set & visited) {
+    buffer<expr> todo;
+    todo.push_back(e);
+    bool ok = true;
+    while (ok && !todo.empty()) {
+        expr curr = todo.back();
+        todo.pop_back();
+        for_each(curr, [&](expr const & c, unsigned) {
+                if (!ok)
+                    return false;
+                if (is_constant(c) && !visited.contains(const_name(c))) {
+                    name const & n = const_name(c);
+                    visited.insert(n);
+                    auto d1 = env1.find(n);
+                    auto d2 = env2.find(n);
+                    if (!d1 || !d2 || !is_same_decl(*d1, *d2)) {
+                        ok = false;
+                    } else if (is_eqp(*d1, *d2) && d1->get_module_idx() != g_main_module_idx) {
+                        // imported declarations are shared by both environments, and so are their dependencies
+                    } else {
+                        todo.push_back(d1->get_type());
+                        if (d1->is_definition() && !d1->is_theorem())
+                            todo.push_back(d1->get_value());
+                    }
+                }
+                return true;
+            });
+    }
+    return ok;
+}
+
+void checked_decls::insert(environment const & env, declaration const & d) {
+    lock_guard<mutex> lock(m_mutex);
+    m_entries.erase(d.get_name());
+    m_entries.insert(mk_pair(d.get_name(), entry(env, d)));
+}
+
+bool checked_decls::contains(environment const & env, declaration const & d) const {
+    environment old_env;
+    declaration old_d;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        auto it = m_entries.find(d.get_name());
+        if (it == m_entries.end())
+            return false;
+        old_env = it->second.m_env;
+        old_d   = it->second.m_decl;
+    }
+    if (!is_same_decl(d, old_d))
+        return false;
+    name_set visited;
+    return
+        same_dependencies(env, old_env, d.get_type(), visited) &&
+        (!d.is_definition() || same_dependencies(env, old_env, d.get_value(), visited));
+}
+
+void checked_decls::retain(environment const & env) {
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_entries.begin();
+    while (it != m_entries.end()) {
+        auto d = env.find(it->first);
+        if (d && is_eqp(*d, it->second.m_decl)) {
+            it->second.m_env = env;
+            ++it;
+        } else {
+            it = m_entries.erase(it);
+        }
+    }
+}
+
+void checked_decls::clear() {
+    lock_guard<mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+LEAN_THREAD_PTR(checked_decls, g_checked_decls);
+
+scoped_checked_decls::scoped_checked_decls(checked_decls & s):m_old(g_checked_decls) {
+    g_checked_decls = &s;
+}
+
+scoped_checked_decls::~scoped_checked_decls() {
+    g_checked_decls = m_old;
+}
+
+checked_decls * get_checked_decls() {
+    return g_checked_decls;
+}
+
+certified_declaration check_aux_decl(environment const & env, declaration const & d) {
+    if (!g_checked_decls)
+        return check(env, d);
+    bool checked = g_checked_decls->contains(env, d);
+    certified_declaration r = checked ? check_cached(env, d) : check(env, d);
+    // we also store \c d when it is already in the set, the set must keep the declaration objects added to \c env (see \c retain)
+    g_checked_decls->insert(env, d);
+    return r;
+}
+
+#if defined(LEAN_MULTI_THREAD)
+void precheck_aux_decls(environment const & env, buffer<aux_decl_fn> const & fns, unsigned num_threads, checked_decls & s) {
+    unsigned num_jobs = std::min(num_threads, fns.size());
+    if (num_jobs <= 1)
+        return;
+    atomic<unsigned> next(0);
+    job_group g;
+    for (unsigned j = 0; j < num_jobs; j++) {
+        g.add([&]() {
+                scoped_checked_decls scope(s);
+                while (true) {
+                    check_interrupted();
+                    unsigned i = next++;
+                    if (i >= fns.size())
+                        return;
+                    try {
+                        fns[i](env);
+                    } catch (interrupted &) {
+                        throw;
+                    } catch (throwable &) {
+                        // errors are reported by the sequential execution
+                    }
+                }
+            });
+    }
+    try {
+        g.wait(num_jobs);
+    } catch (interrupted &) {
+        // the owner was interrupted while waiting, stop the jobs before propagating the exception
+        g.interrupt();
+        throw;
+    }
+}
+#else
+void precheck_aux_decls(environment const &, buffer<aux_decl_fn> const &, unsigned, checked_decls &) {}
+#endif
+}
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <functional>
+#include <unordered_map>
+#include "util/thread.h"
+#include "util/buffer.h"
+#include "kernel/environment.h"
+
+namespace lean {
+/**
+   \brief Set of declarations that have already been type checked by the kernel.
+
+   The auxiliary declarations for inductive datatypes (rec_on, cases_on, below, ...) are
+   produced by independent procedures. We execute them speculatively in parallel (see \c precheck_aux_decls),
+   and store the declarations they type check here. Then, the procedures are executed again
+   sequentially, and the declarations found here are not type checked again.
+
+   The lean server also keeps one of these sets for each worker. When a file is processed again after
+   an edit, the declarations that did not change, and do not depend on changed ones, are not type checked again.
+   After each run, the server only retains the declarations of the resulting environment (see \c retain).
+
+   A declaration is only considered checked if it is identical to the stored one, and the
+   declarations it depends on (directly or transitively) are identical in both environments.
+*/
+class checked_decls {
+    struct entry {
+        environment m_env; // environment used to type check m_decl
+        declaration m_decl;
+        entry(environment const & env, declaration const & d):m_env(env), m_decl(d) {}
+    };
+    mutable mutex                                        m_mutex;
+    std::unordered_map<name, entry, name_hash, name_eq> m_entries;
+public:
+    /** \brief Store the fact that \c d was type checked in \c env. */
+    void insert(environment const & env, declaration const & d);
+    /** \brief Return true iff \c d can be added to \c env without type checking it again. */
+    bool contains(environment const & env, declaration const & d) const;
+    /**
+        \brief Remove the declarations that do not occur in \c env (pointer equality), and make \c env the environment
+        of the remaining ones. Thus, the set keeps at most one environment alive after this operation.
+    */
+    void retain(environment const & env);
+    void clear();
+};
+
+/** \brief Auxiliary object for setting (and restoring) the set of checked declarations used by \c check_aux_decl in the current thread. */
+class scoped_checked_decls {
+    checked_decls * m_old;
+public:
+    scoped_checked_decls(checked_decls & s);
+    ~scoped_checked_decls();
+};
+
+/** \brief Return the set of checked declarations associated with the current thread, or nullptr if there isn't one. */
+checked_decls * get_checked_decls();
+
+/**
+   \brief Type check \c d. If the current thread is associated with a set of checked declarations
+   (see \c scoped_checked_decls), and \c d is in the set, then we skip the type checking step.
+   Otherwise, \c d is type checked and stored in the set.
+*/
+certified_declaration check_aux_decl(environment const & env, declaration const & d);
+
+typedef std::function<environment(environment const &)> aux_decl_fn;
+
+/**
+   \brief Execute the procedures \c fns in parallel using at most \c num_threads threads. Each procedure is
+   applied to \c env, and the declarations type checked by them using \c check_aux_decl are stored in \c s.
+   The resulting environments and exceptions are discarded. Thus, the caller must execute them again sequentially
+   (in a scope where \c s is active) to obtain the actual result.
+
+   \remark It throws \c interrupted if the current thread is interrupted while waiting for the procedures.
+   In this case, the threads executing them are interrupted too.
+
+   \remark It does nothing if multi-threading support is disabled.
+*/
+void precheck_aux_decls(environment const & env, buffer<aux_decl_fn> const & fns, unsigned num_threads, checked_decls & s);
+}
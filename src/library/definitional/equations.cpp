@@ -8,6 +8,7 @@ Author: Leonardo de Moura
 #include <string>
 #include "util/sstream.h"
 #include "util/list_fn.h"
+#include "util/sexpr/option_declarations.h"
 #include "kernel/expr.h"
 #include "kernel/type_checker.h"
 #include "kernel/abstract.h"
@@ -15,6 +16,7 @@ Author: Leonardo de Moura
 #include "kernel/error_msgs.h"
 #include "kernel/for_each_fn.h"
 #include "kernel/find_fn.h"
+#include "kernel/expr_maps.h"
 #include "library/generic_exception.h"
 #include "library/kernel_serializer.h"
 #include "library/io_state_stream.h"
@@ -24,8 +26,21 @@ Author: Leonardo de Moura
 #include "library/constants.h"
 #include "library/normalize.h"
 #include "library/pp_options.h"
+#include "library/max_sharing.h"
 #include "library/tactic/inversion_tactic.h"
 
+#ifndef LEAN_DEFAULT_EQN_COMPILER_MAX_SHARING
+#define LEAN_DEFAULT_EQN_COMPILER_MAX_SHARING true
+#endif
+
+#ifndef LEAN_DEFAULT_EQN_COMPILER_TRACE
+#define LEAN_DEFAULT_EQN_COMPILER_TRACE false
+#endif
+
+#ifndef LEAN_DEFAULT_EQN_COMPILER_TRACE_SIZE
+#define LEAN_DEFAULT_EQN_COMPILER_TRACE_SIZE false
+#endif
+
 namespace lean {
 static name * g_equations_name                 = nullptr;
 static name * g_equation_name                  = nullptr;
@@ -38,6 +53,21 @@ static std::string * g_equation_opcode         = nullptr;
 static std::string * g_no_equation_opcode      = nullptr;
 static std::string * g_decreasing_opcode       = nullptr;
 static std::string * g_equations_result_opcode = nullptr;
+static name * g_eqn_compiler_max_sharing       = nullptr;
+static name * g_eqn_compiler_trace             = nullptr;
+static name * g_eqn_compiler_trace_size        = nullptr;
+
+static bool get_eqn_compiler_max_sharing(options const & o) {
+    return o.get_bool(*g_eqn_compiler_max_sharing, LEAN_DEFAULT_EQN_COMPILER_MAX_SHARING);
+}
+
+static bool get_eqn_compiler_trace(options const & o) {
+    return o.get_bool(*g_eqn_compiler_trace, LEAN_DEFAULT_EQN_COMPILER_TRACE);
+}
+
+static bool get_eqn_compiler_trace_size(options const & o) {
+    return o.get_bool(*g_eqn_compiler_trace_size, LEAN_DEFAULT_EQN_COMPILER_TRACE_SIZE);
+}
 
 [[ noreturn ]] static void throw_eqs_ex() { throw exception("unexpected occurrence of 'equations' expression"); }
 
@@ -239,6 +269,15 @@ void initialize_equations() {
     g_no_equation_opcode      = new std::string("NEqn");
     g_decreasing_opcode       = new std::string("Decr");
     g_equations_result_opcode = new std::string("EqnR");
+    g_eqn_compiler_max_sharing = new name{"eqn_compiler", "max_sharing"};
+    g_eqn_compiler_trace       = new name{"eqn_compiler", "trace"};
+    g_eqn_compiler_trace_size  = new name{"eqn_compiler", "trace_size"};
+    register_bool_option(*g_eqn_compiler_max_sharing, LEAN_DEFAULT_EQN_COMPILER_MAX_SHARING,
+                         "(equation compiler) maximize sharing in the terms produced by the equation compiler");
+    register_bool_option(*g_eqn_compiler_trace, LEAN_DEFAULT_EQN_COMPILER_TRACE,
+                         "(equation compiler) display the number of case splits performed by the equation compiler");
+    register_bool_option(*g_eqn_compiler_trace_size, LEAN_DEFAULT_EQN_COMPILER_TRACE_SIZE,
+                         "(equation compiler) display the size of the terms produced by the equation compiler");
     register_annotation(*g_inaccessible_name);
     register_macro_deserializer(*g_equations_opcode,
                                 [](deserializer & d, unsigned num, expr const * args) {
@@ -279,6 +318,9 @@ void initialize_equations() {
 }
 
 void finalize_equations() {
+    delete g_eqn_compiler_max_sharing;
+    delete g_eqn_compiler_trace;
+    delete g_eqn_compiler_trace_size;
     delete g_equations_result_opcode;
     delete g_equation_opcode;
     delete g_no_equation_opcode;
@@ -442,6 +484,12 @@ class equation_compiler_fn {
     buffer<program>  m_init_prgs;
     unsigned         m_prg_idx; // current program index being compiled
 
+    // Split templates: constructor applied to the inductive datatype parameters ==> its type in telescope form
+    // (i.e., a Pi-type whose body does not have to be normalized to expose the constructor arguments).
+    // It is used to avoid type inference and normalization at every compile_complete step.
+    expr_map<expr>   m_constructor_types;
+    unsigned         m_num_splits; // number of case splits, it is only used for tracing
+
 #ifdef LEAN_DEBUG
     // For debugging purposes: checks whether all local constants occurring in \c e
     // are in local_ctx or m_global_context
@@ -767,6 +815,27 @@ class equation_compiler_fn {
         return has_variable && has_constructor;
     }
 
+    // Return true iff all remaining patterns of \c e are variables or inaccessible terms.
+    static bool is_irrefutable(eqn const & e) {
+        return std::all_of(e.m_patterns.begin(), e.m_patterns.end(),
+                           [](expr const & p) { return is_local(p) || is_inaccessible(p); });
+    }
+
+    // The equations are tried in order. So, the equations after the first irrefutable one are unreachable.
+    // We remove them before splitting. Otherwise, they may produce unnecessary case splits,
+    // and the size of the resulting decision tree may be exponential in the number of equations.
+    program remove_unreachable(program const & p) const {
+        buffer<eqn> new_eqns;
+        for (eqn const & e : p.m_eqns) {
+            new_eqns.push_back(e);
+            if (is_irrefutable(e))
+                break;
+        }
+        if (new_eqns.size() == length(p.m_eqns))
+            return p;
+        return program(p, to_list(new_eqns));
+    }
+
     // Remove variable from local context
     static list<expr> remove(list<expr> const & local_ctx, expr const & l) {
         if (!local_ctx)
@@ -949,8 +1018,13 @@ class equation_compiler_fn {
 
     expr mk_constructor(name const & n, levels const & ls, buffer<expr> const & params, buffer<expr> & args) {
         expr c = mk_app(mk_constant(n, ls), params);
-        expr t = infer_type(c);
-        to_telescope_ext(t, args);
+        auto it = m_constructor_types.find(c);
+        if (it != m_constructor_types.end()) {
+            to_telescope(it->second, args);
+        } else {
+            expr r = to_telescope_ext(infer_type(c), args);
+            m_constructor_types.insert(mk_pair(c, Pi(args, r)));
+        }
         return mk_app(c, args);
     }
 
@@ -1006,8 +1080,9 @@ class equation_compiler_fn {
             });
     }
 
-    expr compile_core(program const & p) {
-        lean_assert(check_program(p));
+    expr compile_core(program const & _p) {
+        lean_assert(check_program(_p));
+        program p = remove_unreachable(_p);
         // out() << "compile_core step\n";
         // display(p);
         // out() << "------------------\n";
@@ -1019,6 +1094,7 @@ class equation_compiler_fn {
             } else if (is_variable_transition(p)) {
                 return compile_variable(p);
             } else if (is_constructor_transition(p)) {
+                m_num_splits++;
                 return compile_constructor(p);
             } else if (is_complete_transition(p)) {
                 return compile_complete(p);
@@ -1723,12 +1799,11 @@ class equation_compiler_fn {
 public:
     equation_compiler_fn(type_checker & tc, io_state const & ios, expr const & meta, expr const & meta_type,
                          bool /* relax */):
-        m_tc(tc), m_ios(ios), m_meta(meta), m_meta_type(meta_type) {
+        m_tc(tc), m_ios(ios), m_meta(meta), m_meta_type(meta_type), m_num_splits(0) {
         get_app_args(m_meta, m_global_context);
     }
 
-    expr operator()(expr eqns) {
-        check_limitations(eqns);
+    expr compile(expr const & eqns) {
         buffer<program> prgs;
         initialize(eqns, prgs);
         m_init_prgs.append(prgs);
@@ -1743,6 +1818,35 @@ public:
             return compile_pat_match(prgs[0], 0);
         }
     }
+
+    /** \brief Return the number of distinct (i.e., not shared) subterms in \c e */
+    static unsigned get_dag_size(expr const & e) {
+        unsigned r = 0;
+        for_each(e, [&](expr const &, unsigned) { r++; return true; });
+        return r;
+    }
+
+    expr operator()(expr eqns) {
+        check_limitations(eqns);
+        expr r = compile(eqns);
+        options const & opts = m_ios.get_options();
+        if (get_eqn_compiler_trace(opts))
+            diagnostic(env(), ios()) << "equation compiler: " << m_num_splits << " case split(s)\n";
+        // The sizes depend on the terms produced by the inversion package, so they are traced by a separate option.
+        bool trace_size = get_eqn_compiler_trace_size(opts);
+        if (trace_size)
+            diagnostic(env(), ios()) << "equation compiler: term size: " << get_weight(r) << ", dag size: " << get_dag_size(r);
+        if (get_eqn_compiler_max_sharing(opts)) {
+            // The kernel and the elaborator type checker cache results using structural equality,
+            // maximizing sharing reduces the amount of memory and the cost of the equality tests.
+            r = max_sharing(r);
+            if (trace_size)
+                diagnostic(env(), ios()) << ", dag size after max_sharing: " << get_dag_size(r);
+        }
+        if (trace_size)
+            diagnostic(env(), ios()) << "\n";
+        return r;
+    }
 };
 
 expr compile_equations(type_checker & tc, io_state const & ios, expr const & eqns,
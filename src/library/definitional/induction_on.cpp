@@ -11,6 +11,7 @@ Author: Leonardo de Moura
 #include "library/module.h"
 #include "library/protected.h"
 #include "library/util.h"
+#include "library/definitional/checked_decls.h"
 
 namespace lean {
 environment mk_induction_on(environment const & env, name const & n) {
@@ -29,10 +30,10 @@ environment mk_induction_on(environment const & env, name const & n) {
     environment new_env       = env;
     if (rec_on_num_univs == ind_num_univs) {
         // easy case, induction_on is just an alias for rec_on
-        certified_declaration cdecl = check(new_env,
-                                            mk_definition(new_env, induction_on_name, rec_on_decl.get_univ_params(),
-                                                          rec_on_decl.get_type(), rec_on_decl.get_value(),
-                                                          opaque, rec_on_decl.get_module_idx(), use_conv_opt));
+        certified_declaration cdecl = check_aux_decl(new_env,
+                                                     mk_definition(new_env, induction_on_name, rec_on_decl.get_univ_params(),
+                                                                   rec_on_decl.get_type(), rec_on_decl.get_value(),
+                                                                   opaque, rec_on_decl.get_module_idx(), use_conv_opt));
         new_env = module::add(new_env, cdecl);
     } else {
         level_param_names induction_on_univs = tail(rec_on_decl.get_univ_params());
@@ -40,10 +41,10 @@ environment mk_induction_on(environment const & env, name const & n) {
         level             to    = mk_level_zero();
         expr induction_on_type  = instantiate_univ_param(rec_on_decl.get_type(), from, to);
         expr induction_on_value = instantiate_univ_param(rec_on_decl.get_value(), from, to);
-        certified_declaration cdecl = check(new_env,
-                                            mk_definition(new_env, induction_on_name, induction_on_univs,
-                                                          induction_on_type, induction_on_value,
-                                                          opaque, rec_on_decl.get_module_idx(), use_conv_opt));
+        certified_declaration cdecl = check_aux_decl(new_env,
+                                                     mk_definition(new_env, induction_on_name, induction_on_univs,
+                                                                   induction_on_type, induction_on_value,
+                                                                   opaque, rec_on_decl.get_module_idx(), use_conv_opt));
         new_env = module::add(new_env, cdecl);
     }
     return add_protected(new_env, induction_on_name);
@@ -15,6 +15,7 @@ Author: Leonardo de Moura
 #include "library/util.h"
 #include "library/reducible.h"
 #include "library/constants.h"
+#include "library/definitional/checked_decls.h"
 
 namespace lean {
 static void throw_corrupted(name const & n) {
@@ -138,7 +139,7 @@ optional<environment> mk_no_confusion_type(environment const & env, name const &
     bool use_conv_opt = true;
     declaration new_d = mk_definition(env, no_confusion_type_name, lps, no_confusion_type_type, no_confusion_type_value,
                                       opaque, ind_decl.get_module_idx(), use_conv_opt);
-    environment new_env = module::add(env, check(env, new_d));
+    environment new_env = module::add(env, check_aux_decl(env, new_d));
     new_env = set_reducible(new_env, no_confusion_type_name, reducible_status::Reducible);
     return some(add_protected(new_env, no_confusion_type_name));
 }
@@ -273,7 +274,7 @@ environment mk_no_confusion(environment const & env, name const & n) {
     bool use_conv_opt = true;
     declaration new_d = mk_definition(new_env, no_confusion_name, lps, no_confusion_ty, no_confusion_val,
                                       opaque, no_confusion_type_decl.get_module_idx(), use_conv_opt);
-    new_env = module::add(new_env, check(new_env, new_d));
+    new_env = module::add(new_env, check_aux_decl(new_env, new_d));
     new_env = set_reducible(new_env, no_confusion_name, reducible_status::Reducible);
     return add_protected(new_env, no_confusion_name);
 }
@@ -14,6 +14,7 @@ Author: Leonardo de Moura
 #include "library/reducible.h"
 #include "library/protected.h"
 #include "library/normalize.h"
+#include "library/definitional/checked_decls.h"
 
 namespace lean {
 environment mk_rec_on(environment const & env, name const & n) {
@@ -56,9 +57,9 @@ environment mk_rec_on(environment const & env, name const & n) {
     bool opaque       = false;
     bool use_conv_opt = true;
     environment new_env = module::add(env,
-                                      check(env, mk_definition(env, rec_on_name, rec_decl.get_univ_params(),
-                                                               rec_on_type, rec_on_val,
-                                                               opaque, rec_decl.get_module_idx(), use_conv_opt)));
+                                      check_aux_decl(env, mk_definition(env, rec_on_name, rec_decl.get_univ_params(),
+                                                                        rec_on_type, rec_on_val,
+                                                                        opaque, rec_decl.get_module_idx(), use_conv_opt)));
     new_env = set_reducible(new_env, rec_on_name, reducible_status::Reducible);
     new_env = add_unfold_c_hint(new_env, rec_on_name, rec_on_major_idx);
     return add_protected(new_env, rec_on_name);
@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include "kernel/type_checker.h"
+#include "kernel/inductive/inductive.h"
+#include "library/discr_tree.h"
+
+namespace lean {
+int discr_tree_key::cmp::operator()(discr_tree_key const & k1, discr_tree_key const & k2) const {
+    if (k1.m_kind != k2.m_kind)
+        return static_cast<int>(k1.m_kind) - static_cast<int>(k2.m_kind);
+    if (k1.m_arity != k2.m_arity)
+        return k1.m_arity < k2.m_arity ? -1 : 1;
+    return quick_cmp(k1.m_name, k2.m_name);
+}
+
+static expr const & get_conclusion(expr const & type) {
+    expr const * it = &type;
+    while (is_pi(*it))
+        it = &binding_body(*it);
+    return *it;
+}
+
+/** \brief Return true if the elements of the inductive datatype \c n cannot be propositions. */
+static bool is_not_prop_inductive(environment const & env, name const & n) {
+    if (!env.impredicative() || !env.prop_proof_irrel())
+        return true;
+    expr const & s = get_conclusion(env.get(n).get_type());
+    return is_sort(s) && is_not_zero(sort_level(s));
+}
+
+/** \brief Return true iff applications of the constant \c n cannot be reduced, nor be equal to other terms by proof irrelevance. */
+static bool is_rigid_constant(environment const & env, type_checker const * tc, name const & n) {
+    if (inductive::is_inductive_decl(env, n))
+        return true;
+    if (auto I = inductive::is_intro_rule(env, n))
+        return is_not_prop_inductive(env, *I);
+    if (inductive::is_elim_rule(env, n))
+        return false;
+    if (auto d = env.find(n)) {
+        if (d->is_definition())
+            return tc && tc->is_opaque(*d);
+        return !d->is_axiom() && is_sort(get_conclusion(d->get_type()));
+    }
+    return false;
+}
+
+static expr * g_star = nullptr;
+
+discr_tree_key get_discr_tree_key(environment const & env, type_checker const * tc, expr const & e, buffer<expr> & args) {
+    expr const & f = get_app_args(e, args);
+    switch (f.kind()) {
+    case expr_kind::Constant:
+        if (is_rigid_constant(env, tc, const_name(f))) {
+            expr const * it = &env.get(const_name(f)).get_type();
+            for (expr & arg : args) {
+                if (!is_pi(*it))
+                    break;
+                if (binding_info(*it).is_inst_implicit())
+                    arg = *g_star;
+                it = &binding_body(*it);
+            }
+            return discr_tree_key(discr_tree_key_kind::Constant, const_name(f), args.size());
+        }
+        break;
+    case expr_kind::Local:
+        return discr_tree_key(discr_tree_key_kind::Local, mlocal_name(f), args.size());
+    case expr_kind::Sort:
+        if (args.empty())
+            return discr_tree_key(discr_tree_key_kind::Sort, name(), 0);
+        break;
+    case expr_kind::Var:   case expr_kind::Meta:  case expr_kind::Macro:
+    case expr_kind::Lambda: case expr_kind::Pi: case expr_kind::App:
+        break;
+    }
+    args.clear();
+    return discr_tree_key();
+}
+
+void initialize_discr_tree() {
+    g_star = new expr(mk_var(0));
+}
+
+void finalize_discr_tree() {
+    delete g_star;
+}
+}
@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include "util/trie.h"
+#include "util/list_fn.h"
+#include "kernel/environment.h"
+
+namespace lean {
+class type_checker;
+enum class discr_tree_key_kind { Star, Constant, Local, Sort };
+
+/** \brief Key (aka symbol) used in discrimination trees. The arity is the number of keys for the arguments. */
+struct discr_tree_key {
+    discr_tree_key_kind m_kind;
+    name                m_name; // only relevant for Constant and Local
+    unsigned            m_arity;
+    discr_tree_key():m_kind(discr_tree_key_kind::Star), m_arity(0) {}
+    discr_tree_key(discr_tree_key_kind k, name const & n, unsigned arity):m_kind(k), m_name(n), m_arity(arity) {}
+    bool is_star() const { return m_kind == discr_tree_key_kind::Star; }
+
+    struct cmp {
+        int operator()(discr_tree_key const & k1, discr_tree_key const & k2) const;
+    };
+};
+
+/**
+   \brief Return the key of \c e, and store in \c args the subterms that must be indexed after it.
+
+   Only the symbols that cannot be modified by reduction are indexed: local constants,
+   sorts, inductive datatypes, constructors of datatypes that are not propositions, and
+   constants that are not axioms and produce types. Everything else (e.g., metavariables, definitions,
+   recursors, binders and macros) is a Star (wildcard).
+
+   Instance implicit arguments are also treated as wildcards since the matcher used in the
+   rewrite tactic ignores them.
+
+   If \c tc is not nullptr, then definitions that are opaque with respect to \c tc are also indexed.
+   This is only safe if \c tc does not use proof irrelevance (e.g., it is only used for whnf).
+*/
+discr_tree_key get_discr_tree_key(environment const & env, type_checker const * tc, expr const & e, buffer<expr> & args);
+
+/**
+   \brief Discrimination tree (aka imperfect term index). It maps expressions to values, and
+   given an expression \c e, it retrieves the values associated with all expressions that may be
+   unified with \c e. The result is a superset: it must still be checked using unification or matching.
+
+   Stars (wildcards) may occur in the stored expressions and in the queries. The datastructure is
+   persistent, copying is a constant time operation.
+*/
+template<typename V>
+class discr_tree {
+    typedef trie<discr_tree_key, list<V>, discr_tree_key::cmp> node;
+    type_checker const * m_tc;
+    node                 m_root;
+
+    template<typename F>
+    void find(environment const & env, node const & n, list<expr> const & todo, F & fn) const {
+        if (!todo) {
+            if (list<V> const * vs = n.value()) {
+                for (V const & v : *vs)
+                    fn(v);
+            }
+            return;
+        }
+        buffer<expr> args;
+        discr_tree_key k = get_discr_tree_key(env, m_tc, head(todo), args);
+        if (k.is_star()) {
+            skip(env, n, 1, tail(todo), fn);
+            return;
+        }
+        if (node const * c = n.find(discr_tree_key()))
+            find(env, *c, tail(todo), fn);
+        if (node const * c = n.find(k)) {
+            list<expr> new_todo = tail(todo);
+            unsigned i = args.size();
+            while (i > 0) {
+                --i;
+                new_todo = cons(args[i], new_todo);
+            }
+            find(env, *c, new_todo, fn);
+        }
+    }
+
+    /** \brief Skip \c num indexed subterms, and then process \c todo. */
+    template<typename F>
+    void skip(environment const & env, node const & n, unsigned num, list<expr> const & todo, F & fn) const {
+        if (num == 0) {
+            find(env, n, todo, fn);
+        } else {
+            n.for_each_child([&](discr_tree_key const & k, node const & c) {
+                    skip(env, c, num - 1 + k.m_arity, todo, fn);
+                });
+        }
+    }
+
+public:
+    /** \brief See #get_discr_tree_key for the meaning of \c tc. */
+    explicit discr_tree(type_checker const * tc = nullptr):m_tc(tc) {}
+
+    void insert(environment const & env, expr const & e, V const & v) {
+        buffer<discr_tree_key> keys;
+        buffer<expr> todo;
+        buffer<expr> args;
+        todo.push_back(e);
+        while (!todo.empty()) {
+            expr t = todo.back();
+            todo.pop_back();
+            args.clear();
+            keys.push_back(get_discr_tree_key(env, m_tc, t, args));
+            unsigned i = args.size();
+            while (i > 0) {
+                --i;
+                todo.push_back(args[i]);
+            }
+        }
+        list<V> vs;
+        if (list<V> const * old_vs = m_root.find(keys.begin(), keys.end()))
+            vs = filter(*old_vs, [&](V const & v2) { return v != v2; });
+        m_root.insert(keys.begin(), keys.end(), cons(v, vs));
+    }
+
+    /** \brief Apply \c fn to the values associated with expressions that may be unified with \c e. */
+    template<typename F>
+    void find(environment const & env, expr const & e, F && fn) const {
+        find(env, m_root, to_list(e), fn);
+    }
+
+    /** \brief Return true iff there is a value associated with an expression that may be unified with \c e. */
+    bool may_match(environment const & env, expr const & e) const {
+        bool r = false;
+        find(env, e, [&](V const &) { r = true; });
+        return r;
+    }
+};
+
+void initialize_discr_tree();
+void finalize_discr_tree();
+}
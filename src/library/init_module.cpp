@@ -10,6 +10,7 @@ Author: Leonardo de Moura
 #include "library/let.h"
 #include "library/typed_expr.h"
 #include "library/choice.h"
+#include "library/discr_tree.h"
 #include "library/class.h"
 #include "library/string.h"
 #include "library/num.h"
@@ -65,6 +66,7 @@ void initialize_library_module() {
     initialize_coercion();
     initialize_unifier_plugin();
     initialize_sorry();
+    initialize_discr_tree();
     initialize_class();
     initialize_library_util();
     initialize_pp_options();
@@ -80,6 +82,7 @@ void finalize_library_module() {
     finalize_pp_options();
     finalize_library_util();
     finalize_class();
+    finalize_discr_tree();
     finalize_sorry();
     finalize_unifier_plugin();
     finalize_coercion();
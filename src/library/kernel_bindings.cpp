@@ -656,6 +656,8 @@ static const struct luaL_Reg expr_m[] = {
 };
 
 static int enable_expr_caching(lua_State * L) { return push_boolean(L, enable_expr_caching(lua_toboolean(L, 1))); }
+static int enable_expr_hash_consing(lua_State * L) { return push_boolean(L, enable_expr_hash_consing(lua_toboolean(L, 1))); }
+static int get_expr_hash_consing_size(lua_State * L) { return push_integer(L, get_expr_hash_consing_size()); }
 
 static void open_expr(lua_State * L) {
     luaL_newmetatable(L, expr_mt);
@@ -682,6 +684,8 @@ static void open_expr(lua_State * L) {
     SET_GLOBAL_FUN(expr_pred,        "is_expr");
 
     SET_GLOBAL_FUN(enable_expr_caching, "enable_expr_caching");
+    SET_GLOBAL_FUN(enable_expr_hash_consing, "enable_expr_hash_consing");
+    SET_GLOBAL_FUN(get_expr_hash_consing_size, "expr_hash_consing_size");
 
     push_expr(L, mk_Prop());
     lua_setglobal(L, "Prop");
@@ -278,7 +278,7 @@ expr read_expr(deserializer & d) {
 // Declaration serialization
 serializer & operator<<(serializer & s, level_param_names const & ps) { return write_list<name>(s, ps); }
 level_param_names read_level_params(deserializer & d) { return read_list<name>(d); }
-serializer & operator<<(serializer & s, declaration const & d) {
+static void write_declaration(serializer & s, declaration const & d, bool store_weight) {
     char k = 0;
     if (d.is_definition()) {
         k |= 1;
@@ -292,13 +292,21 @@ serializer & operator<<(serializer & s, declaration const & d) {
     s << k << d.get_name() << d.get_univ_params() << d.get_type();
     if (d.is_definition()) {
         s << d.get_value();
-        if (!d.is_theorem())
+        if (!d.is_theorem() && store_weight)
             s << d.get_weight();
     }
+}
+
+serializer & operator<<(serializer & s, declaration const & d) {
+    write_declaration(s, d, true);
     return s;
 }
 
-declaration read_declaration(deserializer & d, module_idx midx) {
+void write_declaration_without_weight(serializer & s, declaration const & d) {
+    write_declaration(s, d, false);
+}
+
+static declaration read_declaration_core(deserializer & d, module_idx midx, optional<unsigned> const & weight) {
     char k               = d.read_char();
     bool has_value       = (k & 1) != 0;
     bool is_th_ax        = (k & 8) != 0;
@@ -310,7 +318,7 @@ declaration read_declaration(deserializer & d, module_idx midx) {
         if (is_th_ax) {
             return mk_theorem(n, ps, t, v, midx);
         } else {
-            unsigned w        = d.read_unsigned();
+            unsigned w        = weight ? *weight : d.read_unsigned();
             bool is_opaque    = (k & 2) != 0;
             bool use_conv_opt = (k & 4) != 0;
             return mk_definition(n, ps, t, v, is_opaque, w, midx, use_conv_opt);
@@ -323,6 +331,37 @@ declaration read_declaration(deserializer & d, module_idx midx) {
     }
 }
 
+declaration read_declaration(deserializer & d, module_idx midx) {
+    return read_declaration_core(d, midx, optional<unsigned>());
+}
+
+declaration read_declaration(deserializer & d, module_idx midx, unsigned weight) {
+    return read_declaration_core(d, midx, optional<unsigned>(weight));
+}
+
+declaration read_lazy_declaration(deserializer & d, module_idx midx, unsigned weight, declaration_value_fn const & value_fn) {
+    char k               = d.read_char();
+    bool has_value       = (k & 1) != 0;
+    bool is_th_ax        = (k & 8) != 0;
+    name n               = read_name(d);
+    level_param_names ps = read_level_params(d);
+    expr t               = read_expr(d);
+    if (has_value) {
+        if (is_th_ax) {
+            return mk_lazy_theorem(n, ps, t, value_fn, midx);
+        } else {
+            bool is_opaque    = (k & 2) != 0;
+            bool use_conv_opt = (k & 4) != 0;
+            return mk_lazy_definition(n, ps, t, value_fn, is_opaque, weight, midx, use_conv_opt);
+        }
+    } else {
+        if (is_th_ax)
+            return mk_axiom(n, ps, t);
+        else
+            return mk_constant_assumption(n, ps, t);
+    }
+}
+
 using inductive::inductive_decl;
 using inductive::intro_rule;
 using inductive::inductive_decl_name;
@@ -28,6 +28,17 @@ inline deserializer & operator>>(deserializer & d, expr & e) { e = read_expr(d);
 
 serializer & operator<<(serializer & s, declaration const & d);
 declaration read_declaration(deserializer & d, module_idx midx);
+/** \brief Store \c d without the weight of definitions. The weight must be stored separately,
+    and provided when the declaration is read back.
+    \see read_declaration(deserializer & d, module_idx midx, unsigned weight) */
+void write_declaration_without_weight(serializer & s, declaration const & d);
+/** \brief Read a declaration stored using #write_declaration_without_weight,
+    \c weight is the definition weight. */
+declaration read_declaration(deserializer & d, module_idx midx, unsigned weight);
+/** \brief Similar to read_declaration, but the value of definitions and theorems is not decoded.
+    The resulting declaration uses \c value_fn to compute it on demand, and \c weight as the definition weight.
+    \see mk_lazy_definition */
+declaration read_lazy_declaration(deserializer & d, module_idx midx, unsigned weight, declaration_value_fn const & value_fn);
 
 typedef std::tuple<level_param_names, unsigned, list<inductive::inductive_decl>> inductive_decls;
 serializer & operator<<(serializer & s, inductive_decls const & ds);
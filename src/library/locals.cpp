@@ -62,11 +62,11 @@ void collect_locals(expr const & e, expr_struct_set & ls) {
 }
 
 bool contains_local(expr const & e, name const & n) {
-    if (!has_local(e))
+    if (!has_local(e) || !may_contain_mlocal(e, n))
         return false;
     bool result = false;
     for_each(e, [&](expr const & e, unsigned) {
-            if (result || !has_local(e))  {
+            if (result || !has_local(e) || !may_contain_mlocal(e, n))  {
                 return false;
             } else if (is_local(e) && mlocal_name(e) == n) {
                 result = true;
@@ -19,23 +19,49 @@ Author: Leonardo de Moura
 #include "util/buffer.h"
 #include "util/interrupt.h"
 #include "util/name_map.h"
+#include "util/mapped_file.h"
+#include "util/flet.h"
+#include "util/task_scheduler.h"
+#include "util/sexpr/option_declarations.h"
+#include "kernel/for_each_fn.h"
 #include "kernel/type_checker.h"
 #include "library/module.h"
 #include "library/sorry.h"
 #include "library/kernel_serializer.h"
 #include "library/unfold_macros.h"
+#include "library/check_cache.h"
 #include "version.h"
 
 #ifndef LEAN_ASYNCH_IMPORT_THEOREM
 #define LEAN_ASYNCH_IMPORT_THEOREM false
 #endif
 
+#ifndef LEAN_DEFAULT_IMPORT_LAZY
+#define LEAN_DEFAULT_IMPORT_LAZY false
+#endif
+
 namespace lean {
+static name * g_import_lazy        = nullptr;
+static name * g_import_check_cache = nullptr;
+
+bool get_import_lazy(options const & opts) {
+    return opts.get_bool(*g_import_lazy, LEAN_DEFAULT_IMPORT_LAZY);
+}
+
+char const * get_import_check_cache(options const & opts) {
+    return opts.get_string(*g_import_check_cache, "");
+}
+
 corrupted_file_exception::corrupted_file_exception(std::string const & fname):
     exception(sstream() << "failed to import '" << fname << "', file is corrupted, please regenerate the file from sources") {
 }
 
-typedef pair<std::string, std::function<void(serializer &)>> writer;
+struct writer {
+    std::string                       m_key;
+    std::function<void(serializer &)> m_fn;
+    writer(std::string const & k, std::function<void(serializer &)> const & fn):
+        m_key(k), m_fn(fn) {}
+};
 
 struct module_ext : public environment_extension {
     list<module_name> m_direct_imports;
@@ -91,8 +117,36 @@ bool direct_imports_have_changed(environment const & env) {
     return false;
 }
 
-static char const * g_olean_end_file = "EndFile";
-static char const * g_olean_header   = "oleanfile";
+/*
+  .olean file formats
+
+  Version 1 (legacy, read only):
+     "oleanfile" major minor patch hash imports code_size code
+  where code is a sequence of objects of the form <key-string> <object-data>,
+  terminated by the "EndFile" key. All objects share the same serializer, i.e.,
+  an object can only be decoded after all objects preceding it.
+
+  Version 2:
+     "oleanfile2" major minor patch hash body_size body
+  where hash is computed over body, and body is
+     imports
+     num_keys key_1 ... key_n                 (key strings used in this file)
+     num_objs (key_id offset)_1 ... (key_id offset)_m
+     code_size code
+  Each object is encoded using its own serializer, and starts at code + offset.
+  Thus, any object can be decoded independently of the other ones.
+  The price is size: names and expressions shared by different objects are stored once per object.
+  For a module with 2000 small definitions in a few namespaces, version 2 files are about 2x larger
+  than version 1 files (570 KB vs 278 KB).
+  Declaration objects ("decl") are stored as <weight> <macro_trust> <declaration>, where the declaration
+  does not contain the weight (see write_declaration_without_weight), and macro_trust is
+  the result of get_macro_trust_bound for the value of definitions and theorems (0 for other declarations).
+  It allows lazy imports to decide whether the value contains untrusted macros without decoding it. The weight is
+  stored first to allow us to create lazy declarations without decoding their values.
+*/
+static char const * g_olean_end_file  = "EndFile";
+static char const * g_olean_header    = "oleanfile";
+static char const * g_olean_header_v2 = "oleanfile2";
 
 serializer & operator<<(serializer & s, module_name const & n) {
     if (n.is_relative())
@@ -124,31 +178,163 @@ void export_module(std::ostream & out, environment const & env) {
         writers.push_back(&w);
     std::reverse(writers.begin(), writers.end());
 
-    std::ostringstream out1(std::ios_base::binary);
-    serializer s1(out1);
-
-    // store objects
+    // store objects, each one is encoded using a fresh serializer
+    std::string code;
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, unsigned> key2id;
+    buffer<pair<unsigned, unsigned>> objs; // (key_id, offset)
     for (auto p : writers) {
-        s1 << p->first;
-        p->second(s1);
+        unsigned key_id;
+        auto it = key2id.find(p->m_key);
+        if (it == key2id.end()) {
+            key_id = keys.size();
+            key2id.insert(mk_pair(p->m_key, key_id));
+            keys.push_back(p->m_key);
+        } else {
+            key_id = it->second;
+        }
+        objs.emplace_back(key_id, code.size());
+        std::ostringstream out1(std::ios_base::binary);
+        serializer s1(out1);
+        p->m_fn(s1);
+        code += out1.str();
     }
-    s1 << g_olean_end_file;
 
-    serializer s2(out);
-    std::string r = out1.str();
-    unsigned h    = hash(r.size(), [&](unsigned i) { return r[i]; });
-    s2 << g_olean_header << LEAN_VERSION_MAJOR << LEAN_VERSION_MINOR << LEAN_VERSION_PATCH;
-    s2 << h;
+    std::ostringstream body_out(std::ios_base::binary);
+    serializer s1(body_out);
     // store imported files
-    s2 << imports.size();
+    s1 << imports.size();
     for (auto m : imports)
-        s2 << m;
+        s1 << m;
+    // store offset table
+    s1 << static_cast<unsigned>(keys.size());
+    for (auto const & k : keys)
+        s1 << k;
+    s1 << objs.size();
+    for (auto const & o : objs)
+        s1 << o.first << o.second;
     // store object code
-    s2.write_unsigned(r.size());
-    for (unsigned i = 0; i < r.size(); i++)
-        s2.write_char(r[i]);
+    s1.write_unsigned(code.size());
+    s1.write_chars(code.data(), code.size());
+
+    serializer s2(out);
+    std::string body = body_out.str();
+    unsigned h       = hash(body.size(), [&](unsigned i) { return body[i]; });
+    s2 << g_olean_header_v2 << LEAN_VERSION_MAJOR << LEAN_VERSION_MINOR << LEAN_VERSION_PATCH;
+    s2 << h;
+    s2.write_unsigned(body.size());
+    s2.write_chars(body.data(), body.size());
 }
 
+/** \brief Header of an .olean file, and the memory mapped object code.
+    The objects themselves are not decoded. */
+class olean_file {
+    std::string                        m_fname;
+    std::unique_ptr<mapped_file>       m_file;
+    unsigned                           m_format;
+    buffer<module_name>                m_imports;
+    std::vector<std::string>           m_keys;       // format 2 only
+    std::vector<pair<unsigned, unsigned>> m_objects; // format 2 only, (key_id, offset)
+    char const *                       m_code_begin;
+    char const *                       m_code_end;
+
+    void read_v1(deserializer & d) {
+        unsigned major, minor, patch, claimed_hash;
+        d >> major >> minor >> patch >> claimed_hash;
+        // Enforce version?
+
+        unsigned num_imports  = d.read_unsigned();
+        for (unsigned i = 0; i < num_imports; i++)
+            m_imports.push_back(read_module_name(d));
+
+        unsigned code_size    = d.read_unsigned();
+        char const * code     = d.get_pos();
+        d.skip(code_size);
+
+        unsigned computed_hash = hash(code_size, [&](unsigned i) { return code[i]; });
+        if (claimed_hash != computed_hash)
+            throw exception(sstream() << "file '" << m_fname << "' has been corrupted, checksum mismatch");
+        m_code_begin = code;
+        m_code_end   = code + code_size;
+    }
+
+    void read_v2(deserializer & d1) {
+        unsigned major, minor, patch, claimed_hash;
+        d1 >> major >> minor >> patch >> claimed_hash;
+        unsigned body_size    = d1.read_unsigned();
+        char const * body     = d1.get_pos();
+        d1.skip(body_size);
+        unsigned computed_hash = hash(body_size, [&](unsigned i) { return body[i]; });
+        if (claimed_hash != computed_hash)
+            throw exception(sstream() << "file '" << m_fname << "' has been corrupted, checksum mismatch");
+
+        deserializer d(body, body + body_size);
+        unsigned num_imports  = d.read_unsigned();
+        for (unsigned i = 0; i < num_imports; i++)
+            m_imports.push_back(read_module_name(d));
+        unsigned num_keys     = d.read_unsigned();
+        for (unsigned i = 0; i < num_keys; i++)
+            m_keys.push_back(d.read_string());
+        unsigned num_objs     = d.read_unsigned();
+        for (unsigned i = 0; i < num_objs; i++) {
+            unsigned key_id, offset;
+            d >> key_id >> offset;
+            if (key_id >= num_keys)
+                throw corrupted_stream_exception();
+            m_objects.emplace_back(key_id, offset);
+        }
+        unsigned code_size    = d.read_unsigned();
+        m_code_begin          = d.get_pos();
+        d.skip(code_size);
+        m_code_end            = m_code_begin + code_size;
+        for (auto const & o : m_objects) {
+            if (o.second > code_size)
+                throw corrupted_stream_exception();
+        }
+    }
+
+public:
+    olean_file(std::string const & fname):
+        m_fname(fname), m_file(new mapped_file(fname)), m_format(0), m_code_begin(nullptr), m_code_end(nullptr) {
+        try {
+            deserializer d(m_file->begin(), m_file->end());
+            std::string header;
+            d >> header;
+            if (header == g_olean_header) {
+                m_format = 1;
+                read_v1(d);
+            } else if (header == g_olean_header_v2) {
+                m_format = 2;
+                read_v2(d);
+            } else {
+                throw exception(sstream() << "file '" << fname << "' does not seem to be a valid object Lean file, invalid header");
+            }
+        } catch (corrupted_stream_exception&) {
+            throw corrupted_file_exception(fname);
+        }
+    }
+
+    std::string const & get_fname() const { return m_fname; }
+    unsigned get_format() const { return m_format; }
+    buffer<module_name> const & get_imports() const { return m_imports; }
+
+    /** \brief Memory region containing the object code */
+    char const * get_code_begin() const { return m_code_begin; }
+    char const * get_code_end() const { return m_code_end; }
+
+    unsigned get_num_objects() const { lean_assert(m_format == 2); return m_objects.size(); }
+    std::string const & get_key(unsigned obj_idx) const { return m_keys[m_objects[obj_idx].first]; }
+    /** \brief Memory region containing the i-th object (format 2) */
+    pair<char const *, char const *> get_object(unsigned obj_idx) const {
+        lean_assert(m_format == 2);
+        char const * begin = m_code_begin + m_objects[obj_idx].second;
+        char const * end   = obj_idx + 1 < m_objects.size() ? m_code_begin + m_objects[obj_idx+1].second : m_code_end;
+        if (begin > end)
+            throw corrupted_file_exception(m_fname);
+        return mk_pair(begin, end);
+    }
+};
+
 typedef std::unordered_map<std::string, module_object_reader> object_readers;
 static object_readers * g_object_readers = nullptr;
 static object_readers & get_object_readers() { return *g_object_readers; }
@@ -163,6 +349,19 @@ static std::string * g_glvl_key = nullptr;
 static std::string * g_decl_key = nullptr;
 static std::string * g_inductive = nullptr;
 
+/** \brief Return 0 if \c e does not contain macros, and 1 + the maximum trust level of its macros otherwise.
+    Thus, \c e contains untrusted macros with respect to \c trust_lvl (see contains_untrusted_macro)
+    iff the result is greater than \c trust_lvl. */
+static unsigned get_macro_trust_bound(expr const & e) {
+    unsigned r = 0;
+    for_each(e, [&](expr const & e, unsigned) {
+            if (is_macro(e))
+                r = std::max(r, macro_def(e).trust_level() + 1);
+            return true;
+        });
+    return r;
+}
+
 namespace module {
 environment add(environment const & env, std::string const & k, std::function<void(serializer &)> const & wr) {
     module_ext ext = get_extension(env);
@@ -170,6 +369,16 @@ environment add(environment const & env, std::string const & k, std::function<vo
     return update(env, ext);
 }
 
+static environment add_decl_writer(environment const & env, declaration const & d) {
+    module_ext ext = get_extension(env);
+    ext.m_writers  = cons(writer(*g_decl_key, [=](serializer & s) {
+                s << d.get_weight();
+                s << (d.is_definition() ? get_macro_trust_bound(d.get_value()) : 0u);
+                write_declaration_without_weight(s, d);
+            }), ext.m_writers);
+    return update(env, ext);
+}
+
 environment add_universe(environment const & env, name const & l) {
     environment new_env = env.add_universe(l);
     return add(new_env, *g_glvl_key, [=](serializer & s) { s << l; });
@@ -189,13 +398,13 @@ environment add(environment const & env, certified_declaration const & d) {
     environment new_env = env.add(d);
     declaration _d = d.get_declaration();
     new_env = update_module_defs(new_env, _d);
-    return add(new_env, *g_decl_key, [=](serializer & s) { s << _d; });
+    return add_decl_writer(new_env, _d);
 }
 
 environment add(environment const & env, declaration const & d) {
     environment new_env = env.add(d);
     new_env = update_module_defs(new_env, d);
-    return add(new_env, *g_decl_key, [=](serializer & s) { s << d; });
+    return add_decl_writer(new_env, d);
 }
 
 bool is_definition(environment const & env, name const & n) {
@@ -228,27 +437,44 @@ environment add_inductive(environment const & env, name const & ind_name, level_
 }
 } // end of namespace module
 
+/** \brief Decode a declaration object stored in a file using the given format. */
+static declaration read_decl_object(deserializer & d, module_idx midx, unsigned format) {
+    if (format > 1) {
+        unsigned weight = d.read_unsigned();
+        d.read_unsigned(); // macro_trust
+        return read_declaration(d, midx, weight);
+    } else {
+        return read_declaration(d, midx);
+    }
+}
+
 struct import_modules_fn {
     typedef std::tuple<module_idx, unsigned, delayed_update_fn> delayed_update;
     shared_environment             m_senv;
     unsigned                       m_num_threads;
     bool                           m_keep_proofs;
+    bool                           m_lazy; // true if the value of imported declarations should be decoded on demand
     io_state                       m_ios;
-    mutex                          m_asynch_mutex;
-    condition_variable             m_asynch_cv;
+    // Tasks created before process_asynch_tasks is invoked, i.e., while we are loading the module DAG.
     std::vector<asynch_update_fn>  m_asynch_tasks;
+    task_scheduler *               m_scheduler; // not null when processing asynchronous tasks
     mutex                          m_delayed_mutex;
     std::vector<delayed_update>    m_delayed_tasks;
     atomic<unsigned>               m_next_module_idx;
-    atomic<unsigned>               m_import_counter; // number of modules to be processed
-    atomic<bool>                   m_all_modules_imported;
+    // Cache of kernel checks (see library/check_cache.h), it is only used for format 2 files.
+    std::unique_ptr<check_cache>   m_check_cache;
+    check_cache::key               m_config_key;
+    mutex                          m_cache_keys_mutex;
+    name_map<check_cache::key>     m_cache_keys; // keys of imported declarations
 
     struct module_info {
         std::string                               m_fname;
         atomic<unsigned>                          m_counter; // number of dependencies to be processed
         unsigned                                  m_module_idx;
         std::vector<std::shared_ptr<module_info>> m_dependents;
-        std::vector<char>                         m_obj_code;
+        // The object code is read directly from the memory mapped .olean file.
+        // The file is shared with lazy declarations (see import_lazy_decl).
+        std::shared_ptr<olean_file>               m_file;
         module_info():m_counter(0), m_module_idx(0) {}
     };
     typedef std::shared_ptr<module_info> module_info_ptr;
@@ -257,8 +483,9 @@ struct import_modules_fn {
     name_set                  m_imported; // contains all imported files, even ones from previous calls
 
     import_modules_fn(environment const & env, unsigned num_threads, bool keep_proofs, io_state const & ios):
-        m_senv(env), m_num_threads(num_threads), m_keep_proofs(keep_proofs), m_ios(ios),
-        m_next_module_idx(1), m_import_counter(0), m_all_modules_imported(false) {
+        m_senv(env), m_num_threads(num_threads), m_keep_proofs(keep_proofs),
+        m_lazy(get_import_lazy(ios.get_options()) && env.trust_lvl() > LEAN_BELIEVER_TRUST_LEVEL), m_ios(ios),
+        m_scheduler(nullptr), m_next_module_idx(1) {
         module_ext const & ext = get_extension(env);
         m_imported = ext.m_imported;
         if (m_num_threads == 0)
@@ -270,9 +497,61 @@ struct import_modules_fn {
         if (env.trust_lvl() > LEAN_BELIEVER_TRUST_LEVEL) {
             // it doesn't payoff to use multiple threads if we will not type check anything
             m_num_threads = 1;
+        } else {
+            std::string cache_fname = get_import_check_cache(ios.get_options());
+            if (!cache_fname.empty()) {
+                m_check_cache.reset(new check_cache(cache_fname));
+                m_config_key = mk_check_cache_config_key(env);
+            }
         }
     }
 
+    /** \brief Return the cache key for a declaration/object with hash code \c obj_key that depends
+        on the constants occurring in \c es. Return none if one of the constants was not imported
+        by this object, i.e., we do not know its key. */
+    optional<check_cache::key> mk_cache_key(check_cache::key obj_key, buffer<expr> const & es) {
+        name_set deps;
+        for (expr const & e : es) {
+            for_each(e, [&](expr const & c, unsigned) {
+                    if (is_constant(c))
+                        deps.insert(const_name(c));
+                    return true;
+                });
+        }
+        check_cache::key r = combine_check_cache_keys(m_config_key, obj_key);
+        bool ok = true;
+        lock_guard<mutex> lk(m_cache_keys_mutex);
+        // name_set is sorted, so the result does not depend on the order constants occur in es
+        deps.for_each([&](name const & n) {
+                if (!ok)
+                    return;
+                if (auto k = m_cache_keys.find(n))
+                    r = combine_check_cache_keys(r, *k);
+                else
+                    ok = false;
+            });
+        if (ok)
+            return optional<check_cache::key>(r);
+        else
+            return optional<check_cache::key>();
+    }
+
+    void set_cache_key(name const & n, check_cache::key k) {
+        lock_guard<mutex> lk(m_cache_keys_mutex);
+        m_cache_keys.insert(n, k);
+    }
+
+    /** \brief Type check the given declaration, or retrieve it from the check cache.
+        \remark \c key is the cache key for \c decl (if available). */
+    certified_declaration check_decl(environment const & env, declaration const & decl, optional<check_cache::key> const & key) {
+        if (key && m_check_cache->contains(*key))
+            return check_cached(env, decl);
+        certified_declaration c = check(env, decl);
+        if (key)
+            m_check_cache->insert(*key);
+        return c;
+    }
+
     module_info_ptr load_module_file(std::string const & base, module_name const & mname) {
         std::string fname = find_file(base, mname.get_k(), mname.get_name(), {".olean"});
         auto it    = m_module_info.find(fname);
@@ -284,65 +563,35 @@ struct import_modules_fn {
             throw exception(sstream() << "circular dependency detected at '" << fname << "'");
         m_visited.insert(fname);
         m_imported.insert(fname);
-        std::ifstream in(fname, std::ifstream::binary);
-        if (!in.good())
-            throw exception(sstream() << "failed to open file '" << fname << "'");
-        try {
-            deserializer d1(in);
-            std::string header;
-            d1 >> header;
-            if (header != g_olean_header)
-                throw exception(sstream() << "file '" << fname << "' does not seem to be a valid object Lean file, invalid header");
-            unsigned major, minor, patch, claimed_hash;
-            d1 >> major >> minor >> patch >> claimed_hash;
-            // Enforce version?
-
-            unsigned num_imports  = d1.read_unsigned();
-            buffer<module_name> imports;
-            for (unsigned i = 0; i < num_imports; i++)
-                imports.push_back(read_module_name(d1));
-
-            unsigned code_size    = d1.read_unsigned();
-            std::vector<char> code(code_size);
-            for (unsigned i = 0; i < code_size; i++)
-                code[i] = d1.read_char();
-
-            unsigned computed_hash = hash(code_size, [&](unsigned i) { return code[i]; });
-            if (claimed_hash != computed_hash)
-                throw exception(sstream() << "file '" << fname << "' has been corrupted, checksum mismatch");
-
-            module_info_ptr r = std::make_shared<module_info>();
-            r->m_fname        = fname;
-            r->m_counter      = 0;
-            r->m_module_idx   = g_null_module_idx;
-            m_import_counter++;
-            std::string new_base = dirname(fname.c_str());
-            std::swap(r->m_obj_code, code);
-            bool has_dependency = false;
-            for (auto i : imports) {
-                if (auto d = load_module_file(new_base, i)) {
-                    r->m_counter++;
-                    d->m_dependents.push_back(r);
-                    has_dependency = true;
-                }
+        std::shared_ptr<olean_file> file = std::make_shared<olean_file>(fname);
+        module_info_ptr r = std::make_shared<module_info>();
+        r->m_fname        = fname;
+        r->m_counter      = 0;
+        r->m_module_idx   = g_null_module_idx;
+        std::string new_base = dirname(fname.c_str());
+        buffer<module_name> const & imports = file->get_imports();
+        r->m_file         = std::move(file);
+        bool has_dependency = false;
+        for (auto i : imports) {
+            if (auto d = load_module_file(new_base, i)) {
+                r->m_counter++;
+                d->m_dependents.push_back(r);
+                has_dependency = true;
             }
-            m_module_info.insert(fname, r);
-            r->m_module_idx = m_next_module_idx++;
-
-            if (!has_dependency)
-                add_import_module_task(r);
-            return r;
-        } catch (corrupted_stream_exception&) {
-            throw corrupted_file_exception(fname);
         }
+        m_module_info.insert(fname, r);
+        r->m_module_idx = m_next_module_idx++;
+
+        if (!has_dependency)
+            add_import_module_task(r);
+        return r;
     }
 
     void add_asynch_task(asynch_update_fn const & f) {
-        {
-            lock_guard<mutex> l(m_asynch_mutex);
+        if (m_scheduler)
+            m_scheduler->add([=]() { f(m_senv); });
+        else
             m_asynch_tasks.push_back(f);
-        }
-        m_asynch_cv.notify_one();
     }
 
     void add_import_module_task(module_info_ptr const & r) {
@@ -354,13 +603,57 @@ struct import_modules_fn {
         return mk_axiom(decl.get_name(), decl.get_univ_params(), decl.get_type());
     }
 
-    void import_decl(deserializer & d, module_idx midx) {
-        declaration decl = read_declaration(d, midx);
+    /** \brief Import a declaration stored in the given memory region (format 2) without
+        decoding its value. The value is decoded on demand using the memory mapped file.
+        \pre m_lazy */
+    void import_lazy_decl(std::shared_ptr<olean_file> const & file, char const * begin, char const * end, module_idx midx) {
+        lean_assert(m_lazy);
+        deserializer d(begin, end);
+        unsigned weight      = d.read_unsigned();
+        unsigned macro_trust = d.read_unsigned();
+        // Remark: the value does not contain untrusted macros (see test below). Thus, it does not need
+        // an environment for unfolding them, and the lazy declarations do not keep environments alive.
+        declaration_value_fn value_fn = [=]() {
+            deserializer d(begin, end);
+            try {
+                d.read_unsigned(); // weight
+                d.read_unsigned(); // macro_trust
+                return read_declaration(d, midx, weight).get_value();
+            } catch (corrupted_stream_exception &) {
+                throw corrupted_file_exception(file->get_fname());
+            }
+        };
+        declaration decl = read_lazy_declaration(d, midx, weight, value_fn);
+        environment env  = m_senv.env();
+        if (macro_trust > env.trust_lvl() || contains_untrusted_macro(env.trust_lvl(), decl.get_type())) {
+            // macros must be unfolded, then we decode the whole declaration
+            deserializer d2(begin, end);
+            return import_decl(read_decl_object(d2, midx, 2), midx);
+        }
+        if (decl.get_name() == get_sorry_name() && has_sorry(env))
+            return;
+        if (!m_keep_proofs && decl.is_theorem())
+            m_senv.add(theorem2axiom(decl));
+        else
+            m_senv.add(decl);
+    }
+
+    /** \brief Import declaration.
+        \remark \c obj_key is the hash code of the object storing the declaration when the check cache is being used. */
+    void import_decl(declaration decl, module_idx midx, optional<check_cache::key> const & obj_key = optional<check_cache::key>()) {
         lean_assert(!decl.is_definition() || decl.get_module_idx() == midx);
         environment env  = m_senv.env();
         decl = unfold_untrusted_macros(env, decl);
         if (decl.get_name() == get_sorry_name() && has_sorry(env))
             return;
+        optional<check_cache::key> key;
+        if (obj_key) {
+            buffer<expr> es;
+            es.push_back(decl.get_type());
+            if (decl.is_definition())
+                es.push_back(decl.get_value());
+            key = mk_cache_key(*obj_key, es);
+        }
         if (env.trust_lvl() > LEAN_BELIEVER_TRUST_LEVEL) {
             if (!m_keep_proofs && decl.is_theorem())
                 m_senv.add(theorem2axiom(decl));
@@ -377,13 +670,45 @@ struct import_modules_fn {
                         m_senv.replace(c);
                 });
         } else {
-            if (!m_keep_proofs && decl.is_theorem()) {
-                // check theorem, but add an axiom
-                check(env, decl);
-                m_senv.add(check(env, theorem2axiom(decl)));
-            } else {
-                certified_declaration c = check(env, decl);
-                m_senv.add(c);
+            m_senv.add(check_imported_decl(env, decl, key));
+        }
+    }
+
+    /** \brief Type check an imported declaration, and return the certified declaration that should be
+        added to the environment. If proofs are not being kept, then the result is an axiom for theorems. */
+    certified_declaration check_imported_decl(environment const & env, declaration const & decl,
+                                              optional<check_cache::key> const & key) {
+        certified_declaration c = check_decl(env, decl, key);
+        if (key)
+            set_cache_key(decl.get_name(), *key);
+        if (!m_keep_proofs && decl.is_theorem()) {
+            // check theorem, but add an axiom
+            return check_cached(env, theorem2axiom(decl));
+        } else {
+            return c;
+        }
+    }
+
+    /** \brief Import inductive declarations stored in a format 2 object with hash code \c obj_key.
+        \remark The inductive declarations are always checked by the kernel, the check cache is only
+        used to compute the keys of the declarations that depend on them. */
+    void import_inductive(deserializer & d, check_cache::key obj_key) {
+        inductive_decls ds = read_inductive_decls(d);
+        m_senv.update([&](environment const & env) {
+                return inductive::add_inductive(env, std::get<0>(ds), std::get<1>(ds), std::get<2>(ds));
+            });
+        buffer<expr> es;
+        for (inductive::inductive_decl const & decl : std::get<2>(ds)) {
+            es.push_back(inductive::inductive_decl_type(decl));
+            for (inductive::intro_rule const & ir : inductive::inductive_decl_intros(decl))
+                es.push_back(inductive::intro_rule_type(ir));
+        }
+        if (auto key = mk_cache_key(obj_key, es)) {
+            for (inductive::inductive_decl const & decl : std::get<2>(ds)) {
+                set_cache_key(inductive::inductive_decl_name(decl), *key);
+                set_cache_key(inductive::get_elim_name(inductive::inductive_decl_name(decl)), *key);
+                for (inductive::intro_rule const & ir : inductive::inductive_decl_intros(decl))
+                    set_cache_key(inductive::intro_rule_name(ir), *key);
             }
         }
     }
@@ -393,10 +718,213 @@ struct import_modules_fn {
         m_senv.update([=](environment const & env) { return env.add_universe(l); });
     }
 
+    void import_object(std::string const & k, deserializer & d, module_info_ptr const & r,
+                       std::function<void(asynch_update_fn const &)> & add_asynch_update,
+                       std::function<void(delayed_update_fn const &)> & add_delayed_update) {
+        if (k == *g_decl_key) {
+            import_decl(read_decl_object(d, r->m_module_idx, r->m_file->get_format()), r->m_module_idx);
+        } else if (k == *g_glvl_key) {
+            import_universe(d);
+        } else {
+            object_readers & readers = get_object_readers();
+            auto it = readers.find(k);
+            if (it == readers.end())
+                throw exception(sstream() << "file '" << r->m_fname << "' has been corrupted, unknown object");
+            it->second(d, r->m_module_idx, m_senv, add_asynch_update, add_delayed_update);
+        }
+    }
+
+    /** \brief State for importing a format 2 module using multiple threads.
+
+        All objects are decoded up front. A declaration is type checked (in its own task) as soon as
+        all objects it depends on have been added to the shared environment. Objects are added to the
+        shared environment in file order (see #commit_objects). Thus, independent declarations of the same
+        module are type checked concurrently.
+
+        We assume that only declaration, inductive and universe objects extend the kernel environment. */
+    struct module_import {
+        struct object {
+            std::string const *             m_key;
+            char const *                    m_begin;
+            char const *                    m_end;
+            optional<declaration>           m_decl;    // decoded declaration (only for declaration objects)
+            optional<certified_declaration> m_cdecl;   // result of type checking m_decl
+            bool                            m_checked; // true if m_decl has been checked (or skipped)
+            object():m_key(nullptr), m_begin(nullptr), m_end(nullptr), m_checked(false) {}
+        };
+        module_info_ptr                    m_module;
+        std::vector<object>                m_objects;
+        // m_waiting[i] contains the declarations that can be checked after the i-th object is added.
+        std::vector<std::vector<unsigned>> m_waiting;
+        mutex                              m_mutex;
+        unsigned                           m_next; // next object to be added to the shared environment
+        bool                               m_done; // true if all objects have been added to the shared environment
+        module_import(module_info_ptr const & r):m_module(r), m_next(0), m_done(false) {}
+    };
+    typedef std::shared_ptr<module_import> module_import_ptr;
+
+    /** \brief Return true if \c e contains a macro. The expansion of a macro may refer to constants
+        that do not occur in \c e. */
+    static bool has_macro(expr const & e) {
+        bool r = false;
+        for_each(e, [&](expr const & s, unsigned) {
+                if (is_macro(s))
+                    r = true;
+                return !r;
+            });
+        return r;
+    }
+
+    void import_module_in_parallel(module_info_ptr const & r) {
+        olean_file const & file = *r->m_file;
+        module_import_ptr s     = std::make_shared<module_import>(r);
+        unsigned num_objs       = file.get_num_objects();
+        s->m_objects.resize(num_objs);
+        s->m_waiting.resize(num_objs);
+        std::vector<unsigned> roots; // declarations that do not depend on objects of this module
+        name_map<unsigned> local;    // constants defined in this module
+        optional<unsigned> last_barrier;
+        try {
+            for (unsigned i = 0; i < num_objs; i++) {
+                check_interrupted();
+                module_import::object & obj = s->m_objects[i];
+                std::tie(obj.m_begin, obj.m_end) = file.get_object(i);
+                obj.m_key = &file.get_key(i);
+                std::string const & k = *obj.m_key;
+                if (k == *g_decl_key) {
+                    deserializer d(obj.m_begin, obj.m_end);
+                    declaration decl = read_decl_object(d, r->m_module_idx, 2);
+                    optional<unsigned> wait = last_barrier;
+                    auto visit = [&](expr const & e) {
+                        if (has_macro(e) && i > 0) {
+                            wait = i - 1;
+                            return;
+                        }
+                        for_each(e, [&](expr const & c, unsigned) {
+                                if (is_constant(c)) {
+                                    if (auto idx = local.find(const_name(c))) {
+                                        if (!wait || *wait < *idx)
+                                            wait = *idx;
+                                    }
+                                }
+                                return true;
+                            });
+                    };
+                    visit(decl.get_type());
+                    if (decl.is_definition())
+                        visit(decl.get_value());
+                    local.insert(decl.get_name(), i);
+                    obj.m_decl = decl;
+                    if (wait)
+                        s->m_waiting[*wait].push_back(i);
+                    else
+                        roots.push_back(i);
+                } else if (k == *g_inductive) {
+                    deserializer d(obj.m_begin, obj.m_end);
+                    inductive_decls ds = read_inductive_decls(d);
+                    for (inductive::inductive_decl const & decl : std::get<2>(ds)) {
+                        local.insert(inductive::inductive_decl_name(decl), i);
+                        local.insert(inductive::get_elim_name(inductive::inductive_decl_name(decl)), i);
+                        for (inductive::intro_rule const & ir : inductive::inductive_decl_intros(decl))
+                            local.insert(inductive::intro_rule_name(ir), i);
+                    }
+                } else if (k == *g_glvl_key) {
+                    last_barrier = i;
+                }
+            }
+        } catch (corrupted_stream_exception&) {
+            throw corrupted_file_exception(r->m_fname);
+        }
+        for (unsigned i : roots)
+            add_check_task(s, i);
+        commit_objects(s);
+    }
+
+    void add_check_task(module_import_ptr const & s, unsigned i) {
+        add_asynch_task([=](shared_environment & m_senv) {
+                module_import::object & obj = s->m_objects[i];
+                // all dependencies of obj have already been added to m_senv
+                environment env  = m_senv.env();
+                declaration decl = unfold_untrusted_macros(env, *obj.m_decl);
+                optional<certified_declaration> c;
+                if (decl.get_name() != get_sorry_name() || !has_sorry(env)) {
+                    optional<check_cache::key> key;
+                    if (m_check_cache) {
+                        buffer<expr> es;
+                        es.push_back(decl.get_type());
+                        if (decl.is_definition())
+                            es.push_back(decl.get_value());
+                        key = mk_cache_key(hash_check_cache_data(obj.m_begin, obj.m_end), es);
+                    }
+                    c = check_imported_decl(env, decl, key);
+                }
+                {
+                    lock_guard<mutex> lk(s->m_mutex);
+                    obj.m_cdecl   = c;
+                    obj.m_checked = true;
+                }
+                commit_objects(s);
+            });
+    }
+
+    /** \brief Add to the shared environment the longest sequence of objects (in file order) that
+        are ready, and create the tasks for checking the declarations that depend on them. */
+    void commit_objects(module_import_ptr const & s) {
+        module_info_ptr const & r = s->m_module;
+        std::vector<unsigned> to_check;
+        bool done = false;
+        {
+            lock_guard<mutex> lk(s->m_mutex);
+            if (s->m_done)
+                return;
+            unsigned num_objs = s->m_objects.size();
+            // consecutive declarations are added to the shared environment using a single update
+            buffer<certified_declaration> batch;
+            while (s->m_next < num_objs) {
+                unsigned i = s->m_next;
+                module_import::object & obj = s->m_objects[i];
+                if (obj.m_decl) {
+                    if (!obj.m_checked)
+                        break;
+                    if (obj.m_cdecl)
+                        batch.push_back(*obj.m_cdecl);
+                    obj.m_decl  = none_declaration();
+                    obj.m_cdecl = optional<certified_declaration>();
+                } else {
+                    m_senv.add(batch);
+                    batch.clear();
+                    std::function<void(asynch_update_fn const &)> add_asynch_update([&](asynch_update_fn const & f) {
+                            add_asynch_task(f);
+                        });
+                    std::function<void(delayed_update_fn const &)> add_delayed_update([&](delayed_update_fn const & f) {
+                            lock_guard<mutex> lk(m_delayed_mutex);
+                            m_delayed_tasks.push_back(std::make_tuple(r->m_module_idx, i, f));
+                        });
+                    try {
+                        deserializer d(obj.m_begin, obj.m_end);
+                        import_object(*obj.m_key, d, r, add_asynch_update, add_delayed_update);
+                    } catch (corrupted_stream_exception&) {
+                        throw corrupted_file_exception(r->m_fname);
+                    }
+                }
+                to_check.insert(to_check.end(), s->m_waiting[i].begin(), s->m_waiting[i].end());
+                s->m_next++;
+            }
+            // remark: the tasks in to_check are only created after the batch is added
+            m_senv.add(batch);
+            done = s->m_next == num_objs;
+            s->m_done = done;
+        }
+        for (unsigned i : to_check)
+            add_check_task(s, i);
+        if (done)
+            finish_import_module(r);
+    }
+
     void import_module(module_info_ptr const & r) {
-        std::string s(r->m_obj_code.data(), r->m_obj_code.size());
-        std::istringstream in(s, std::ios_base::binary);
-        deserializer d(in);
+        olean_file const & file = *r->m_file;
+        if (m_num_threads > 1 && file.get_format() > 1 && !m_lazy)
+            return import_module_in_parallel(r);
         unsigned obj_counter = 0;
         std::function<void(asynch_update_fn const &)> add_asynch_update([&](asynch_update_fn const & f) {
                 add_asynch_task(f);
@@ -405,30 +933,50 @@ struct import_modules_fn {
                 lock_guard<mutex> lk(m_delayed_mutex);
                 m_delayed_tasks.push_back(std::make_tuple(r->m_module_idx, obj_counter, f));
             });
-        while (true) {
-            check_interrupted();
-            std::string k;
-            d >> k;
-            if (k == g_olean_end_file) {
-                break;
-            } else if (k == *g_decl_key) {
-                import_decl(d, r->m_module_idx);
-            } else if (k == *g_glvl_key) {
-                import_universe(d);
+        try {
+            if (file.get_format() == 1) {
+                deserializer d(file.get_code_begin(), file.get_code_end());
+                while (true) {
+                    check_interrupted();
+                    std::string k;
+                    d >> k;
+                    if (k == g_olean_end_file)
+                        break;
+                    import_object(k, d, r, add_asynch_update, add_delayed_update);
+                    obj_counter++;
+                }
             } else {
-                object_readers & readers = get_object_readers();
-                auto it = readers.find(k);
-                if (it == readers.end())
-                    throw exception(sstream() << "file '" << r->m_fname << "' has been corrupted, unknown object");
-                it->second(d, r->m_module_idx, m_senv, add_asynch_update, add_delayed_update);
+                unsigned num_objs = file.get_num_objects();
+                for (; obj_counter < num_objs; obj_counter++) {
+                    check_interrupted();
+                    auto obj = file.get_object(obj_counter);
+                    std::string const & k = file.get_key(obj_counter);
+                    if (m_lazy && k == *g_decl_key) {
+                        import_lazy_decl(r->m_file, obj.first, obj.second, r->m_module_idx);
+                    } else if (m_check_cache && (k == *g_decl_key || k == *g_inductive)) {
+                        check_cache::key obj_key = hash_check_cache_data(obj.first, obj.second);
+                        deserializer d(obj.first, obj.second);
+                        if (k == *g_decl_key) {
+                            import_decl(read_decl_object(d, r->m_module_idx, 2), r->m_module_idx,
+                                        optional<check_cache::key>(obj_key));
+                        } else {
+                            import_inductive(d, obj_key);
+                        }
+                    } else {
+                        deserializer d(obj.first, obj.second);
+                        import_object(k, d, r, add_asynch_update, add_delayed_update);
+                    }
+                }
             }
-            obj_counter++;
-        }
-        if (atomic_fetch_sub_explicit(&m_import_counter, 1u, memory_order_release) == 1u) {
-            atomic_thread_fence(memory_order_acquire);
-            m_all_modules_imported = true;
-            m_asynch_cv.notify_all();
+        } catch (corrupted_stream_exception&) {
+            throw corrupted_file_exception(r->m_fname);
         }
+        finish_import_module(r);
+    }
+
+    void finish_import_module(module_info_ptr const & r) {
+        // release the memory mapped file, it remains alive if lazy declarations are still using it
+        r->m_file.reset();
         // Module was successfully imported, we should notify descendents.
         for (module_info_ptr const & d : r->m_dependents) {
             if (atomic_fetch_sub_explicit(&(d->m_counter), 1u, memory_order_release) == 1u) {
@@ -439,61 +987,16 @@ struct import_modules_fn {
         }
     }
 
-    optional<asynch_update_fn> next_task() {
-        while (true) {
-            check_interrupted();
-            unique_lock<mutex> lk(m_asynch_mutex);
-            if (!m_asynch_tasks.empty()) {
-                asynch_update_fn r = m_asynch_tasks.back();
-                m_asynch_tasks.pop_back();
-                return optional<asynch_update_fn>(r);
-            } else if (m_all_modules_imported) {
-                return optional<asynch_update_fn>();
-            } else {
-                m_asynch_cv.wait(lk);
-            }
-        }
-    }
-
     void process_asynch_tasks() {
         if (m_asynch_tasks.empty())
             return;
-        std::vector<std::unique_ptr<interruptible_thread>> extra_threads;
-        std::vector<std::unique_ptr<throwable>> thread_exceptions(m_num_threads - 1);
-        atomic<int> failed_thread_idx(-1); // >= 0 if error
-        for (unsigned i = 0; i < m_num_threads - 1; i++) {
-            extra_threads.push_back(std::unique_ptr<interruptible_thread>(new interruptible_thread([=, &thread_exceptions, &failed_thread_idx]() {
-                            try {
-                                while (auto t = next_task()) {
-                                    (*t)(m_senv);
-                                }
-                                m_asynch_cv.notify_all();
-                            } catch (throwable & ex) {
-                                thread_exceptions[i].reset(ex.clone());
-                                failed_thread_idx = i;
-                            } catch (...) {
-                                thread_exceptions[i].reset(new exception("module import thread failed for unknown reasons"));
-                                failed_thread_idx = i;
-                            }
-                        })));
-        }
-        try {
-            while (auto t = next_task()) {
-                (*t)(m_senv);
-                int idx = failed_thread_idx;
-                if (idx >= 0)
-                    thread_exceptions[idx]->rethrow();
-            }
-            m_asynch_cv.notify_all();
-            for (auto & th : extra_threads)
-                th->join();
-        } catch (...) {
-            for (auto & th : extra_threads)
-                th->request_interrupt();
-            for (auto & th : extra_threads)
-                th->join();
-            throw;
-        }
+        // the current thread is also a worker
+        task_scheduler scheduler(m_num_threads - 1);
+        flet<task_scheduler *> set(m_scheduler, &scheduler);
+        for (asynch_update_fn const & f : m_asynch_tasks)
+            add_asynch_task(f);
+        m_asynch_tasks.clear();
+        scheduler.join();
     }
 
     environment process_delayed_tasks() {
@@ -537,6 +1040,8 @@ struct import_modules_fn {
         for (unsigned i = 0; i < num_modules; i++)
             load_module_file(base, modules[i]);
         process_asynch_tasks();
+        if (m_check_cache)
+            m_check_cache->save();
         environment env = process_delayed_tasks();
         module_ext ext = get_extension(env);
         ext.m_imported = m_imported;
@@ -561,9 +1066,20 @@ void initialize_module() {
     g_decl_key       = new std::string("decl");
     g_inductive      = new std::string("ind");
     register_module_object_reader(*g_inductive, module::inductive_reader);
+    g_import_lazy        = new name{"import", "lazy"};
+    g_import_check_cache = new name{"import", "check_cache"};
+    register_option(*g_import_check_cache, StringOption, "",
+                    "(import) name of a file used to cache the declarations already type checked by the kernel, "
+                    "when importing modules with trust level less than or equal to the believer trust level "
+                    "(WARNING: declarations found in the cache are not type checked again)");
+    register_bool_option(*g_import_lazy, LEAN_DEFAULT_IMPORT_LAZY,
+                         "(import) when the trust level is greater than the believer trust level, "
+                         "the value of imported definitions and theorems is only decoded when it is used for the first time");
 }
 
 void finalize_module() {
+    delete g_import_check_cache;
+    delete g_import_lazy;
     delete g_inductive;
     delete g_decl_key;
     delete g_glvl_key;
@@ -5,10 +5,26 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include "kernel/find_fn.h"
+#include "kernel/for_each_fn.h"
 #include "library/occurs.h"
 
 namespace lean {
 bool occurs(expr const & n, expr const & m) {
+    if (is_mlocal(n)) {
+        // subterms that do not contain metavariables/local constants named mlocal_name(n) are skipped
+        name const & id = mlocal_name(n);
+        bool found = false;
+        for_each(m, [&](expr const & e, unsigned) {
+                if (found || !may_contain_mlocal(e, id))
+                    return false;
+                if (n == e) {
+                    found = true;
+                    return false;
+                }
+                return true;
+            });
+        return found;
+    }
     return static_cast<bool>(find(m, [&](expr const & e, unsigned) { return n == e; }));
 }
 
@@ -7,31 +7,44 @@ Author: Leonardo de Moura
 #include "library/shared_environment.h"
 
 namespace lean {
-shared_environment::shared_environment() {}
-shared_environment::shared_environment(environment const & env):m_env(env) {}
+shared_environment::shared_environment():m_env(std::make_shared<environment const>()) {}
+shared_environment::shared_environment(environment const & env):m_env(std::make_shared<environment const>(env)) {}
+
+void shared_environment::publish(environment const & env) {
+    std::atomic_store(&m_env, environment_ptr(std::make_shared<environment const>(env)));
+}
 
 environment shared_environment::get_environment() const {
-    lock_guard<mutex> l(m_mutex);
-    return m_env;
+    return *std::atomic_load(&m_env);
 }
 
+// Remark: m_env is only modified by writers, and writers hold m_mutex.
+// So, it is safe to access snapshot() directly in the following methods.
+
 void shared_environment::add(certified_declaration const & d) {
     lock_guard<mutex> l(m_mutex);
-    m_env = m_env.add(d);
+    publish(snapshot().add(d));
+}
+
+void shared_environment::add(buffer<certified_declaration> const & ds) {
+    if (ds.empty())
+        return;
+    lock_guard<mutex> l(m_mutex);
+    publish(snapshot().add(ds.size(), ds.data()));
 }
 
 void shared_environment::add(declaration const & d) {
     lock_guard<mutex> l(m_mutex);
-    m_env = m_env.add(d);
+    publish(snapshot().add(d));
 }
 
 void shared_environment::replace(certified_declaration const & t) {
     lock_guard<mutex> l(m_mutex);
-    m_env = m_env.replace(t);
+    publish(snapshot().replace(t));
 }
 
 void shared_environment::update(std::function<environment(environment const &)> const & f) {
     lock_guard<mutex> l(m_mutex);
-    m_env = f(m_env);
+    publish(f(snapshot()));
 }
 }
@@ -5,42 +5,60 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <memory>
 #include <functional>
-#include "util/shared_mutex.h"
+#include "util/thread.h"
+#include "util/buffer.h"
 #include "kernel/environment.h"
 
 namespace lean {
-/** \brief Auxiliary object used when multiple threads are trying to populate the same environment. */
+/**
+    \brief Auxiliary object used when multiple threads are trying to populate the same environment.
+
+    The current environment is published as an immutable snapshot. Readers (#env) just copy the
+    snapshot pointer, and are never blocked by writers. Writers are serialized, and publish a new
+    snapshot after each update.
+*/
 class shared_environment {
-    environment          m_env;
-    mutable mutex        m_mutex;
+    typedef std::shared_ptr<environment const> environment_ptr;
+    // Current snapshot, it must only be accessed using atomic_load and atomic_store.
+    environment_ptr      m_env;
+    mutable mutex        m_mutex; // used to serialize writers
+    environment const & snapshot() const { return *m_env; }
+    void publish(environment const & env);
 public:
     shared_environment();
     shared_environment(environment const & env);
-    /** \brief Return a copy of the current environment. This is a constant time operation. */
+    /** \brief Return a copy of the current environment. This is a constant time operation,
+        and it does not block. */
     environment get_environment() const;
     environment env() const { return get_environment(); }
     /**
         \brief Add the given certified declaration to the environment.
         This is a constant time operation.
-        It blocks this object for a small amount of time.
+        It blocks writers for a small amount of time.
     */
     void add(certified_declaration const & d);
+    /**
+        \brief Add the given certified declarations to the environment using a single update.
+        It is cheaper than adding them one by one.
+    */
+    void add(buffer<certified_declaration> const & ds);
     /**
         \brief Add declaration that was not type checked.
         The method throws an exception if trust_level() <= LEAN_BELIEVER_TRUST_LEVEL
-        It blocks this object for a small amount of time.
+        It blocks writers for a small amount of time.
     */
     void add(declaration const & d);
     /**
         \brief Replace the axiom with name <tt>t.get_declaration().get_name()</tt> with the theorem t.get_declaration().
         This is a constant time operation.
-        It blocks this object for a small amount of time.
+        It blocks writers for a small amount of time.
     */
     void replace(certified_declaration const & t);
     /**
        \brief Update the environment using the given function.
-       This procedure blocks access to this object.
+       This procedure blocks other writers, but not readers.
     */
     void update(std::function<environment(environment const &)> const & f);
 };
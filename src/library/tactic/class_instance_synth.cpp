@@ -4,6 +4,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <algorithm>
 #include "util/lazy_list_fn.h"
 #include "util/flet.h"
 #include "util/sexpr/option_declarations.h"
@@ -16,6 +17,7 @@ Author: Leonardo de Moura
 #include "library/metavar_closure.h"
 #include "library/error_handling/error_handling.h"
 #include "library/class.h"
+#include "library/class_instance_cache.h"
 #include "library/local_context.h"
 #include "library/choice_iterator.h"
 #include "library/pp_options.h"
@@ -41,11 +43,16 @@ Author: Leonardo de Moura
 #define LEAN_DEFAULT_CLASS_CONSERVATIVE true
 #endif
 
+#ifndef LEAN_DEFAULT_CLASS_CACHE_INSTANCES
+#define LEAN_DEFAULT_CLASS_CACHE_INSTANCES true
+#endif
+
 namespace lean {
 static name * g_class_unique_class_instances = nullptr;
 static name * g_class_trace_instances        = nullptr;
 static name * g_class_instance_max_depth     = nullptr;
 static name * g_class_conservative           = nullptr;
+static name * g_class_cache_instances        = nullptr;
 
 [[ noreturn ]] void throw_class_exception(char const * msg, expr const & m) { throw_generic_exception(msg, m); }
 [[ noreturn ]] void throw_class_exception(expr const & m, pp_fn const & fn) { throw_generic_exception(m, fn); }
@@ -55,6 +62,7 @@ void initialize_class_instance_elaborator() {
     g_class_trace_instances        = new name{"class", "trace_instances"};
     g_class_instance_max_depth     = new name{"class", "instance_max_depth"};
     g_class_conservative           = new name{"class", "conservative"};
+    g_class_cache_instances        = new name{"class", "cache_instances"};
 
     register_bool_option(*g_class_unique_class_instances,  LEAN_DEFAULT_CLASS_UNIQUE_CLASS_INSTANCES,
                          "(class) generate an error if there is more than one solution "
@@ -68,6 +76,10 @@ void initialize_class_instance_elaborator() {
 
     register_bool_option(*g_class_conservative,  LEAN_DEFAULT_CLASS_CONSERVATIVE,
                          "(class) use conservative unification (only unfold reducible definitions, and avoid delta-delta case splits)");
+
+    register_bool_option(*g_class_cache_instances,  LEAN_DEFAULT_CLASS_CACHE_INSTANCES,
+                         "(class) reuse solutions of class-instance resolution problems that do not contain metavariables, "
+                         "and discard resolution branches that loop");
 }
 
 void finalize_class_instance_elaborator() {
@@ -75,6 +87,7 @@ void finalize_class_instance_elaborator() {
     delete g_class_trace_instances;
     delete g_class_instance_max_depth;
     delete g_class_conservative;
+    delete g_class_cache_instances;
 }
 
 bool get_class_unique_class_instances(options const & o) {
@@ -93,6 +106,10 @@ bool get_class_conservative(options const & o) {
     return o.get_bool(*g_class_conservative, LEAN_DEFAULT_CLASS_CONSERVATIVE);
 }
 
+bool get_class_cache_instances(options const & o) {
+    return o.get_bool(*g_class_cache_instances, LEAN_DEFAULT_CLASS_CACHE_INSTANCES);
+}
+
 /** \brief Context for handling class-instance metavariable choice constraint */
 struct class_instance_context {
     io_state                  m_ios;
@@ -103,6 +120,7 @@ struct class_instance_context {
     bool                      m_use_local_instances;
     bool                      m_trace_instances;
     bool                      m_conservative;
+    bool                      m_use_cache;
     unsigned                  m_max_depth;
     char const *              m_fname;
     optional<pos_info>        m_pos;
@@ -116,6 +134,8 @@ struct class_instance_context {
         m_trace_instances = get_class_trace_instances(ios.get_options());
         m_max_depth       = get_class_instance_max_depth(ios.get_options());
         m_conservative    = get_class_conservative(ios.get_options());
+        m_use_cache       = get_class_cache_instances(ios.get_options()) &&
+                            !get_class_unique_class_instances(ios.get_options());
         if (m_conservative)
             m_tc = mk_type_checker(env, m_ngen.mk_child(), false, UnfoldReducible);
         else
@@ -140,10 +160,48 @@ struct class_instance_context {
     optional<pos_info> const & get_pos() const { return m_pos; }
     char const * get_file_name() const { return m_fname; }
     unsigned get_max_depth() const { return m_max_depth; }
+
+    bool use_cache() const { return m_use_cache; }
+    class_instance_cache & cache() const { return get_class_instance_cache(env()); }
+
+    /** \brief Return the key for the problem of synthesizing an element of \c type in the context \c ctx.
+        Return none if the problem cannot be cached. */
+    optional<class_instance_cache_key> mk_cache_key(local_context const & ctx, expr const & type) {
+        if (!m_use_cache || has_metavar(type))
+            return optional<class_instance_cache_key>();
+        buffer<expr> local_insts;
+        if (m_use_local_instances) {
+            for (expr const & l : ctx.get_data()) {
+                if (is_local(l) && is_ext_class(tc(), mlocal_type(l)))
+                    local_insts.push_back(l);
+            }
+        }
+        unsigned flags = (m_relax ? 1 : 0) | (m_use_local_instances ? 2 : 0) | (m_conservative ? 4 : 0);
+        return optional<class_instance_cache_key>(type, to_list(local_insts.begin(), local_insts.end()), flags);
+    }
+
+    /** \brief Store in the cache the solution \c r for the root problem \c k.
+
+        \remark We only store solutions of root problems. The solution of a subproblem may be
+        a later alternative selected because a sibling rejected the first one. Then, reusing it would make
+        the instance selected for the same problem depend on the order the problems are solved. */
+    void cache_solution(optional<class_instance_cache_key> const & k, expr const & r) {
+        if (k && !has_metavar(r))
+            cache().insert(env(), *k, r);
+    }
+
+    void trace_cache_stats() {
+        if (!m_trace_instances || !m_use_cache)
+            return;
+        class_instance_cache const & c = cache();
+        auto out = diagnostic(env(), m_ios);
+        out << "class-instance cache: " << c.get_num_hits() << " hit(s), " << c.get_num_misses() << " miss(es)" << endl;
+    }
 };
 
 pair<expr, constraint> mk_class_instance_elaborator(std::shared_ptr<class_instance_context> const & C, local_context const & ctx,
-                                                 optional<expr> const & type, tag g, unsigned depth);
+                                                 optional<expr> const & type, tag g, unsigned depth,
+                                                 list<class_instance_cache_key> const & goals, bool use_cache);
 
 /** \brief Choice function \c fn for synthesizing class instances.
 
@@ -151,8 +209,9 @@ pair<expr, constraint> mk_class_instance_elaborator(std::shared_ptr<class_instan
     The function \c fn produces a stream of alternative solutions for ?m.
     In this case, \c fn will do the following:
     1) if the elaborated type of ?m is a 'class' C, then the stream will start with
-         a) all local instances of class C (if elaborator.local_instances == true)
-         b) all global instances of class C
+         a) the cached solution for the problem (if class.cache_instances == true)
+         b) all local instances of class C (if elaborator.local_instances == true)
+         c) all global instances of class C
 */
 struct class_instance_elaborator : public choice_iterator {
     std::shared_ptr<class_instance_context> m_C;
@@ -165,8 +224,15 @@ struct class_instance_elaborator : public choice_iterator {
     // This information is retrieved from the local context
     list<expr>              m_local_instances;
     // global declaration names that are class instances.
-    // This information is retrieved using #get_class_instances.
+    // This information is retrieved using #get_class_instances, and it only contains
+    // the instances whose type may be unified with m_meta_type.
     list<name>              m_instances;
+    // solution for this problem computed by a previous class-instance resolution
+    optional<expr>          m_cached;
+    // problems being solved by the ancestors of this one (only problems that can be cached are included)
+    list<class_instance_cache_key> m_goals;
+    // false if all solutions of the root problem are enumerated, then cached solutions are not used
+    bool                    m_use_cache;
     justification           m_jst;
     unsigned                m_depth;
     bool                    m_displayed_trace_header;
@@ -174,9 +240,11 @@ struct class_instance_elaborator : public choice_iterator {
     class_instance_elaborator(std::shared_ptr<class_instance_context> const & C, local_context const & ctx,
                               expr const & meta, expr const & meta_type,
                               list<expr> const & local_insts, list<name> const & instances,
+                              optional<expr> const & cached, list<class_instance_cache_key> const & goals, bool use_cache,
                               justification const & j, unsigned depth):
         choice_iterator(), m_C(C), m_ctx(ctx), m_meta(meta), m_meta_type(meta_type),
-        m_local_instances(local_insts), m_instances(instances), m_jst(j), m_depth(depth) {
+        m_local_instances(local_insts), m_instances(instances), m_cached(cached), m_goals(goals),
+        m_use_cache(use_cache), m_jst(j), m_depth(depth) {
         if (m_depth > m_C->get_max_depth()) {
             throw_class_exception("maximum class-instance resolution depth has been reached "
                                   "(the limit can be increased by setting option 'class.instance_max_depth') "
@@ -239,7 +307,7 @@ struct class_instance_elaborator : public choice_iterator {
                 expr arg;
                 if (binding_info(type).is_inst_implicit()) {
                     pair<expr, constraint> ac = mk_class_instance_elaborator(m_C, m_ctx, some_expr(binding_domain(type)),
-                                                                             g, m_depth+1);
+                                                                             g, m_depth+1, m_goals, m_use_cache);
                     arg = ac.first;
                     cs.push_back(ac.second);
                 } else {
@@ -276,6 +344,12 @@ struct class_instance_elaborator : public choice_iterator {
     }
 
     virtual optional<constraints> next() {
+        if (m_cached) {
+            expr r   = *m_cached;
+            m_cached = none_expr();
+            trace(m_meta_type, r);
+            return optional<constraints>(to_list(mk_eq_cnstr(m_meta, r, m_jst, m_C->m_relax)));
+        }
         while (!empty(m_local_instances)) {
             expr inst         = head(m_local_instances);
             m_local_instances = tail(m_local_instances);
@@ -294,21 +368,38 @@ struct class_instance_elaborator : public choice_iterator {
     }
 };
 
-constraint mk_class_instance_cnstr(std::shared_ptr<class_instance_context> const & C, local_context const & ctx, expr const & m, unsigned depth) {
+static bool contains(list<class_instance_cache_key> const & goals, class_instance_cache_key const & k) {
+    return std::any_of(goals.begin(), goals.end(), [&](class_instance_cache_key const & g) { return g == k; });
+}
+
+constraint mk_class_instance_cnstr(std::shared_ptr<class_instance_context> const & C, local_context const & ctx, expr const & m,
+                                   unsigned depth, list<class_instance_cache_key> const & goals, bool use_cache) {
     environment const & env = C->env();
     justification j         = mk_failed_to_synthesize_jst(env, m);
-    auto choice_fn = [=](expr const & meta, expr const & meta_type, substitution const &, name_generator const &) {
+    auto choice_fn = [=](expr const & meta, expr const & meta_type, substitution const & s, name_generator const &) {
         if (auto cls_name_it = is_ext_class(C->tc(), meta_type)) {
             name cls_name = *cls_name_it;
+            optional<expr> cached;
+            list<class_instance_cache_key> new_goals = goals;
+            if (C->use_cache()) {
+                if (auto k = C->mk_cache_key(ctx, substitution(s).instantiate_all(meta_type))) {
+                    if (contains(goals, *k))
+                        return lazy_list<constraints>(); // loop, an ancestor is solving the same problem
+                    new_goals = cons(*k, goals);
+                    if (use_cache)
+                        cached = C->cache().find(env, *k);
+                }
+            }
             list<expr> const & ctx_lst = ctx.get_data();
             list<expr> local_insts;
             if (C->use_local_instances())
                 local_insts = get_local_instances(C->tc(), ctx_lst, cls_name);
-            list<name>  insts = get_class_instances(env, cls_name);
-            if (empty(local_insts) && empty(insts))
+            list<name>  insts = get_class_instances(env, cls_name, meta_type);
+            if (empty(local_insts) && empty(insts) && !cached)
                 return lazy_list<constraints>(); // nothing to be done
             // we are always strict with placeholders associated with classes
-            return choose(std::make_shared<class_instance_elaborator>(C, ctx, meta, meta_type, local_insts, insts, j, depth));
+            return choose(std::make_shared<class_instance_elaborator>(C, ctx, meta, meta_type, local_insts, insts,
+                                                                      cached, new_goals, use_cache, j, depth));
         } else {
             // do nothing, type is not a class...
             return lazy_list<constraints>(constraints());
@@ -321,9 +412,10 @@ constraint mk_class_instance_cnstr(std::shared_ptr<class_instance_context> const
 }
 
 pair<expr, constraint> mk_class_instance_elaborator(std::shared_ptr<class_instance_context> const & C, local_context const & ctx,
-                                                    optional<expr> const & type, tag g, unsigned depth) {
+                                                    optional<expr> const & type, tag g, unsigned depth,
+                                                    list<class_instance_cache_key> const & goals, bool use_cache) {
     expr m       = ctx.mk_meta(C->m_ngen, type, g);
-    constraint c = mk_class_instance_cnstr(C, ctx, m, depth);
+    constraint c = mk_class_instance_cnstr(C, ctx, m, depth, goals, use_cache);
     return mk_pair(m, c);
 }
 
@@ -345,7 +437,12 @@ constraint mk_class_instance_root_cnstr(std::shared_ptr<class_instance_context>
         expr new_meta            = mj.first;
         justification new_j      = mj.second;
         unsigned depth           = 0;
-        constraint c             = mk_class_instance_cnstr(C, ctx, new_meta, depth);
+        // cached solutions are not used when all solutions are enumerated, they would be produced twice
+        bool use_cache           = !try_multiple_instances(env, *cls_name_it);
+        optional<class_instance_cache_key> root_key;
+        if (use_cache)
+            root_key = C->mk_cache_key(ctx, substitution(s).instantiate_all(meta_type));
+        constraint c             = mk_class_instance_cnstr(C, ctx, new_meta, depth, list<class_instance_cache_key>(), use_cache);
         unifier_config new_cfg(cfg);
         new_cfg.m_discard        = false;
         new_cfg.m_use_exceptions = false;
@@ -422,10 +519,14 @@ constraint mk_class_instance_root_cnstr(std::shared_ptr<class_instance_context>
                 }
             } else {
                 auto p  = seq2.pull();
-                if (!p)
+                if (!p) {
+                    C->trace_cache_stats();
                     return no_solution_fn();
-                else
+                } else {
+                    C->cache_solution(root_key, p->first.first.instantiate_all(new_meta));
+                    C->trace_cache_stats();
                     return lazy_list<constraints>(to_cnstrs_fn(p->first.first, p->first.second));
+                }
             }
         }
     };
@@ -459,7 +560,9 @@ optional<expr> mk_class_instance(environment const & env, io_state const & ios,
         return none_expr();
     expr meta       = ctx.mk_meta(C->m_ngen, some_expr(type), type.get_tag());
     unsigned depth  = 0;
-    constraint c    = mk_class_instance_cnstr(C, ctx, meta, depth);
+    auto root_key   = C->mk_cache_key(ctx, type);
+    bool use_cache  = true;
+    constraint c    = mk_class_instance_cnstr(C, ctx, meta, depth, list<class_instance_cache_key>(), use_cache);
     unifier_config new_cfg(cfg);
     new_cfg.m_discard        = true;
     new_cfg.m_use_exceptions = true;
@@ -472,8 +575,10 @@ optional<expr> mk_class_instance(environment const & env, io_state const & ios,
             lean_assert(p);
             substitution s = p->first.first;
             expr r = s.instantiate_all(meta);
-            if (!has_expr_metavar_relaxed(r))
+            if (!has_expr_metavar_relaxed(r)) {
+                C->cache_solution(root_key, r);
                 return some_expr(r);
+            }
             seq = p->second;
         }
     } catch (exception &) {
@@ -156,6 +156,25 @@ void get_tactic_expr_list_elements(expr l, buffer<expr> & r, char const * error_
     }
 }
 
+static expr * g_tactic_list_cons = nullptr;
+static expr * g_tactic_list_nil  = nullptr;
+
+static void get_tactic_list_elements(type_checker & tc, expr l, buffer<expr> & r, char const * error_msg) {
+    while (true) {
+        if (l == *g_tactic_list_nil)
+            return;
+        if (!is_app(l) || !is_app(app_fn(l)) || app_fn(app_fn(l)) != *g_tactic_list_cons) {
+            expr new_l = tc.whnf(l).first;
+            if (new_l == l)
+                throw expr_to_tactic_exception(l, error_msg);
+            l = new_l;
+            continue;
+        }
+        r.push_back(app_arg(app_fn(l)));
+        l = app_arg(l);
+    }
+}
+
 void get_tactic_id_list_elements(expr l, buffer<name> & r, char const * error_msg) {
     buffer<expr> es;
     get_tactic_expr_list_elements(l, es, error_msg);
@@ -336,6 +355,8 @@ void initialize_expr_to_tactic() {
 
     g_expr_list_cons = new expr(mk_constant(get_tactic_expr_list_cons_name()));
     g_expr_list_nil  = new expr(mk_constant(get_tactic_expr_list_nil_name()));
+    g_tactic_list_cons = new expr(mk_constant(get_tactic_tactic_list_cons_name()));
+    g_tactic_list_nil  = new expr(mk_constant(get_tactic_tactic_list_nil_name()));
 
     g_and_then_tac_fn   = new expr(Const(get_tactic_and_then_name()));
     g_or_else_tac_fn    = new expr(Const(get_tactic_or_else_name()));
@@ -381,6 +402,19 @@ void initialize_expr_to_tactic() {
     register_num_tac(get_tactic_rotate_left_name(), [](unsigned k) { return rotate_left(k); });
     register_num_tac(get_tactic_rotate_right_name(), [](unsigned k) { return rotate_right(k); });
 
+    register_tac(get_tactic_portfolio_tac_name(),
+                 [](type_checker & tc, elaborate_fn const & fn, expr const & e, pos_info_provider const * p) {
+                     buffer<expr> args;
+                     get_app_args(e, args);
+                     if (args.size() != 1)
+                         throw expr_to_tactic_exception(e, "invalid portfolio tactic, it must have one argument");
+                     buffer<expr> ts_exprs;
+                     get_tactic_list_elements(tc, args[0], ts_exprs, "invalid portfolio tactic, list of tactics expected");
+                     buffer<tactic> ts;
+                     for (expr const & t : ts_exprs)
+                         ts.push_back(expr_to_tactic(tc, fn, t, p));
+                     return portfolio(to_list(ts.begin(), ts.end()));
+                 });
     register_tac(get_tactic_fixpoint_name(),
                  [](type_checker & tc, elaborate_fn const & fn, expr const & e, pos_info_provider const *) {
                      if (!is_constant(app_fn(e)))
@@ -393,6 +427,8 @@ void initialize_expr_to_tactic() {
 void finalize_expr_to_tactic() {
     delete g_expr_list_cons;
     delete g_expr_list_nil;
+    delete g_tactic_list_cons;
+    delete g_tactic_list_nil;
     delete g_tactic_expr_type;
     delete g_tactic_expr_builtin;
     delete g_tactic_expr_list_type;
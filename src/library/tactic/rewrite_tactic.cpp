@@ -23,6 +23,7 @@ Author: Leonardo de Moura
 #include "library/util.h"
 #include "library/expr_lt.h"
 #include "library/match.h"
+#include "library/discr_tree.h"
 #include "library/projection.h"
 #include "library/local_context.h"
 #include "library/unifier.h"
@@ -1089,10 +1090,13 @@ class rewrite_fn {
     // of a hypothesis. This flag affects the equality proof built by this method.
     find_result find_target(expr const & e, expr const & pattern, expr const & orig_elem, bool is_goal) {
         find_result result;
+        // discrimination tree used to quickly discard subterms that cannot match the pattern
+        discr_tree<unsigned> pattern_tree(m_matcher_tc.get());
+        pattern_tree.insert(m_env, pattern, 0);
         for_each(e, [&](expr const & t, unsigned) {
                 if (result)
                     return false; // stop search
-                if (closed(t)) {
+                if (closed(t) && pattern_tree.may_match(m_env, t)) {
                     lean_assert(std::all_of(m_esubst.begin(), m_esubst.end(), [&](optional<expr> const & e) { return !e; }));
                     bool assigned = false;
                     bool r = match(pattern, t, m_lsubst, m_esubst, nullptr, nullptr, &m_mplugin, &assigned);
@@ -11,6 +11,7 @@ Author: Leonardo de Moura
 #include "util/sstream.h"
 #include "util/interrupt.h"
 #include "util/lazy_list_fn.h"
+#include "util/thread_pool.h"
 #include "util/list_fn.h"
 #include "kernel/instantiate.h"
 #include "kernel/type_checker.h"
@@ -181,6 +182,16 @@ tactic par(tactic const & t1, tactic const & t2, unsigned check_ms) {
         });
 }
 
+tactic portfolio(list<tactic> const & ts, unsigned max_threads, unsigned check_ms) {
+    if (max_threads == 0)
+        max_threads = hardware_concurrency();
+    return tactic([=](environment const & env, io_state const & ios, proof_state const & _s) -> proof_state_seq {
+            proof_state s = _s.update_report_failure(false);
+            return portfolio(map2<proof_state_seq>(ts, [&](tactic const & t) { return t(env, ios, s); }),
+                             max_threads, check_ms);
+        });
+}
+
 tactic repeat(tactic const & t) {
     return tactic([=](environment const & env, io_state const & ios, proof_state const & _s1) -> proof_state_seq {
             proof_state s1 = _s1.update_report_failure(false);
@@ -364,6 +375,18 @@ static int tactic_orelse(lua_State * L)         {  return push_tactic(L, orelse(
 static int tactic_append(lua_State * L)         {  return push_tactic(L, append(to_tactic(L, 1), to_tactic(L, 2))); }
 static int tactic_interleave(lua_State * L)     {  return push_tactic(L, interleave(to_tactic(L, 1), to_tactic(L, 2))); }
 static int tactic_par(lua_State * L)            {  return push_tactic(L, par(to_tactic(L, 1), to_tactic(L, 2))); }
+static int tactic_portfolio(lua_State * L) {
+    int nargs = lua_gettop(L);
+    unsigned max_threads = 0;
+    if (nargs > 0 && lua_isnumber(L, nargs)) {
+        max_threads = lua_tointeger(L, nargs);
+        nargs--;
+    }
+    buffer<tactic> ts;
+    for (int i = 1; i <= nargs; i++)
+        ts.push_back(to_tactic(L, i));
+    return push_tactic(L, portfolio(to_list(ts.begin(), ts.end()), max_threads));
+}
 static int tactic_repeat(lua_State * L)         {  return push_tactic(L, repeat(to_tactic(L, 1))); }
 static int tactic_repeat_at_most(lua_State * L) {  return push_tactic(L, repeat_at_most(to_tactic(L, 1), luaL_checkinteger(L, 2))); }
 static int tactic_take(lua_State * L)           {  return push_tactic(L, take(to_tactic(L, 1), luaL_checkinteger(L, 2))); }
@@ -470,6 +493,7 @@ void open_tactic(lua_State * L) {
     SET_GLOBAL_FUN(nary_tactic<interleave>, "Interleave");
     SET_GLOBAL_FUN(nary_tactic<append>,     "Append");
     SET_GLOBAL_FUN(nary_tactic<par>,        "Par");
+    SET_GLOBAL_FUN(tactic_portfolio,        "Portfolio");
     SET_GLOBAL_FUN(tactic_repeat,           "Repeat");
     SET_GLOBAL_FUN(tactic_repeat_at_most,   "RepeatAtMost");
     SET_GLOBAL_FUN(mk_lua_cond_tactic,      "Cond");
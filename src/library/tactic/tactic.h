@@ -9,7 +9,9 @@ Author: Leonardo de Moura
 #include <utility>
 #include <memory>
 #include <string>
+#include "util/interrupt.h"
 #include "util/lazy_list.h"
+#include "util/list.h"
 #include "library/io_state.h"
 #include "library/generic_exception.h"
 #include "library/tactic/proof_state.h"
@@ -73,10 +75,9 @@ tactic using_params(tactic const & t, options const & opts);
 
    \remark the tactic \c t is executed in a separate execution thread.
 
-   \remark \c check_ms is how often the main thread checks whether the child
-   thread finished.
+   \remark \c check_ms is how often the main thread checks whether it has been interrupted.
 */
-tactic try_for(tactic const & t, unsigned ms, unsigned check_ms = 1);
+tactic try_for(tactic const & t, unsigned ms, unsigned check_ms = g_small_sleep);
 /**
    \brief Execute both tactics and and combines their results.
    The results produced by tactic \c t1 are listed before the ones
@@ -102,11 +103,19 @@ tactic interleave(tactic const & t1, tactic const & t2);
    the elements in the output sequence is not deterministic.
    It depends on how fast \c t1 and \c t2 produce their output.
 
-   \remark \c check_ms is how often the main thread checks whether the children
-   threads finished.
+   \remark \c check_ms is how often the main thread checks whether it has been interrupted.
 */
 tactic par(tactic const & t1, tactic const & t2, unsigned check_ms);
-inline tactic par(tactic const & t1, tactic const & t2) { return par(t1, t2, 1); }
+inline tactic par(tactic const & t1, tactic const & t2) { return par(t1, t2, g_small_sleep); }
+/**
+   \brief Return a tactic that executes the tactics in \c ts in parallel, and
+   produces the results of the first one that succeeds. The other ones are interrupted.
+   At most \c max_threads tactics are executed at the same time, when \c max_threads is 0,
+   the number of hardware threads is used.
+
+   \remark \c check_ms is how often the main thread checks whether it has been interrupted.
+*/
+tactic portfolio(list<tactic> const & ts, unsigned max_threads = 0, unsigned check_ms = g_small_sleep);
 /**
    \brief Return a tactic that keeps applying \c t until it fails.
 */
@@ -18,4 +18,7 @@ namespace lean {
 expr unfold_untrusted_macros(environment const & env, expr const & e);
 
 declaration unfold_untrusted_macros(environment const & env, declaration const & d);
+
+/** \brief Return true iff \c e contains a macro with trust level greater than or equal to \c trust_lvl. */
+bool contains_untrusted_macro(unsigned trust_lvl, expr const & e);
 }
@@ -0,0 +1,658 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <vector>
+#include <string>
+#include "util/rc.h"
+#include "util/list.h"
+#include "util/interrupt.h"
+#include "util/sstream.h"
+#include "kernel/instantiate.h"
+#include "kernel/type_checker.h"
+#include "kernel/expr_maps.h"
+#include "kernel/inductive/inductive.h"
+#include "library/vm.h"
+
+namespace lean {
+/*
+   Bytecode
+   --------
+   Var i      push the i-th entry of the current environment (de Bruijn index)
+   Global i   push the value of the i-th global (definition, constructor or recursor)
+   Quote i    push the i-th quoted (neutral) term, its free variables are instantiated using the current environment
+   Closure i  push a closure for the i-th function, it captures the current environment
+   Thunk i    push a suspended computation for the i-th code block, it captures the current environment
+   App n      pop a function f, and apply it to the n values on the top of the stack
+   Ret        return the value on the top of the stack
+
+   The arguments of an application are pushed before the function.
+*/
+enum class vm_opcode : unsigned char { Var, Global, Quote, Closure, Thunk, App, Ret };
+
+struct vm_instr {
+    vm_opcode m_op;
+    unsigned  m_arg;
+    vm_instr(vm_opcode op, unsigned arg):m_op(op), m_arg(arg) {}
+};
+
+struct vm_code {
+    std::vector<vm_instr> m_instrs;
+};
+
+/** \brief Functions that can be applied to values. */
+struct vm_function {
+    enum class kind { Code, Constructor, Recursor };
+    kind       m_kind;
+    unsigned   m_arity;
+    unsigned   m_code;       // Code: index of the body
+    expr       m_source;     // Code: lambda expression, Constructor/Recursor: constant
+    unsigned   m_num_params; // Constructor/Recursor: number of inductive datatype parameters
+    unsigned   m_num_ACe;    // Recursor: number of parameters, type formers and minor premises
+    vm_function(kind k, unsigned arity, expr const & src):
+        m_kind(k), m_arity(arity), m_code(0), m_source(src), m_num_params(0), m_num_ACe(0) {}
+};
+
+enum class vm_obj_kind { Constructor, Closure, Neutral, Thunk };
+
+class vm_obj;
+class vm_obj_cell {
+    void dealloc();
+protected:
+    vm_obj_kind m_kind;
+    MK_LEAN_RC(); // Declare m_rc counter
+public:
+    vm_obj_cell(vm_obj_kind k):m_kind(k), m_rc(0) {}
+    vm_obj_kind kind() const { return m_kind; }
+};
+
+class vm_obj {
+    vm_obj_cell * m_ptr;
+    friend class vm_obj_cell;
+public:
+    vm_obj():m_ptr(nullptr) {}
+    explicit vm_obj(vm_obj_cell * c):m_ptr(c) { if (m_ptr) m_ptr->inc_ref(); }
+    vm_obj(vm_obj const & s):m_ptr(s.m_ptr) { if (m_ptr) m_ptr->inc_ref(); }
+    vm_obj(vm_obj && s):m_ptr(s.m_ptr) { s.m_ptr = nullptr; }
+    ~vm_obj() { if (m_ptr) m_ptr->dec_ref(); }
+    vm_obj & operator=(vm_obj const & s) { LEAN_COPY_REF(s); }
+    vm_obj & operator=(vm_obj && s) { LEAN_MOVE_REF(s); }
+    explicit operator bool() const { return m_ptr != nullptr; }
+    vm_obj_kind kind() const { return m_ptr->kind(); }
+    vm_obj_cell * raw() const { return m_ptr; }
+};
+
+typedef list<vm_obj> vm_env;
+
+struct vm_constructor : public vm_obj_cell {
+    vm_function const * m_fn;
+    std::vector<vm_obj> m_args; // parameters and fields
+    vm_constructor(vm_function const * fn):vm_obj_cell(vm_obj_kind::Constructor), m_fn(fn) {}
+};
+
+struct vm_closure : public vm_obj_cell {
+    vm_function const * m_fn;
+    vm_env              m_env;
+    std::vector<vm_obj> m_args; // arguments of partial applications
+    vm_closure(vm_function const * fn, vm_env const & env):vm_obj_cell(vm_obj_kind::Closure), m_fn(fn), m_env(env) {}
+};
+
+struct vm_neutral : public vm_obj_cell {
+    expr m_expr;
+    vm_neutral(expr const & e):vm_obj_cell(vm_obj_kind::Neutral), m_expr(e) {}
+};
+
+struct vm_thunk : public vm_obj_cell {
+    unsigned m_code;   // 0 if the code has not been produced yet
+    vm_env   m_env;
+    expr     m_source; // closed term, it is only used if m_code == 0
+    vm_obj   m_value;  // null if the thunk has not been evaluated yet
+    vm_thunk(unsigned code, vm_env const & env):
+        vm_obj_cell(vm_obj_kind::Thunk), m_code(code), m_env(env) {}
+    vm_thunk(expr const & src):
+        vm_obj_cell(vm_obj_kind::Thunk), m_code(0), m_source(src) {}
+};
+
+inline vm_constructor * to_constructor(vm_obj const & o) { return static_cast<vm_constructor*>(o.raw()); }
+inline vm_closure * to_closure(vm_obj const & o) { return static_cast<vm_closure*>(o.raw()); }
+inline vm_neutral * to_neutral(vm_obj const & o) { return static_cast<vm_neutral*>(o.raw()); }
+inline vm_thunk * to_thunk(vm_obj const & o) { return static_cast<vm_thunk*>(o.raw()); }
+
+static vm_obj mk_vm_neutral(expr const & e) { return vm_obj(new vm_neutral(e)); }
+
+// Long data structures (e.g., lists) are deleted without using the system stack.
+void vm_obj_cell::dealloc() {
+    buffer<vm_obj_cell*> todo;
+    todo.push_back(this);
+    auto push = [&](vm_obj & o) {
+        if (o.m_ptr && o.m_ptr->dec_ref_core())
+            todo.push_back(o.m_ptr);
+        o.m_ptr = nullptr;
+    };
+    while (!todo.empty()) {
+        vm_obj_cell * it = todo.back();
+        todo.pop_back();
+        switch (it->kind()) {
+        case vm_obj_kind::Constructor: {
+            vm_constructor * c = static_cast<vm_constructor*>(it);
+            for (vm_obj & o : c->m_args) push(o);
+            delete c;
+            break;
+        }
+        case vm_obj_kind::Closure: {
+            vm_closure * c = static_cast<vm_closure*>(it);
+            for (vm_obj & o : c->m_args) push(o);
+            delete c;
+            break;
+        }
+        case vm_obj_kind::Neutral:
+            delete static_cast<vm_neutral*>(it);
+            break;
+        case vm_obj_kind::Thunk: {
+            vm_thunk * t = static_cast<vm_thunk*>(it);
+            push(t->m_value);
+            delete t;
+            break;
+        }}
+    }
+}
+
+struct vm_fn::imp {
+    struct frame {
+        unsigned m_code;
+        unsigned m_pc;
+        vm_env   m_env;
+        unsigned m_num_extra; // number of arguments (on the stack) that must be consumed by the result
+        frame(unsigned code, vm_env const & env, unsigned num_extra):
+            m_code(code), m_pc(0), m_env(env), m_num_extra(num_extra) {}
+    };
+
+    environment                                  m_env;
+    std::function<bool(declaration const &)>    m_unfold;
+    std::unique_ptr<type_checker>                m_tc; // used to expand macros, it is created on demand
+    std::vector<vm_code>                         m_codes;
+    std::vector<std::unique_ptr<vm_function>>    m_functions;
+    std::vector<expr>                            m_quotes;
+    std::vector<vm_obj>                          m_globals;
+    expr_map<optional<unsigned>>                 m_global_idx;  // constant ==> position in m_globals
+    expr_map<vm_obj>                             m_comp_rules;  // intro rule (with the levels of the recursor) ==> rhs
+    std::vector<vm_obj>                          m_stack;
+    std::vector<frame>                           m_frames;
+    unsigned long long                           m_num_steps;
+    unsigned                                     m_code_size;
+
+    imp(environment const & env, std::function<bool(declaration const &)> const & unfold):
+        m_env(env), m_unfold(unfold), m_num_steps(0), m_code_size(0) {
+        m_codes.push_back(vm_code()); // code 0 is reserved, see vm_thunk
+    }
+
+    [[ noreturn ]] void throw_vm_exception(sstream const & strm) {
+        throw exception(strm);
+    }
+
+    // ==========================================
+    // Compiler
+
+    void emit(unsigned code, vm_opcode op, unsigned arg = 0) {
+        m_codes[code].m_instrs.push_back(vm_instr(op, arg));
+        m_code_size++;
+    }
+
+    unsigned mk_code() {
+        m_codes.push_back(vm_code());
+        return m_codes.size() - 1;
+    }
+
+    unsigned mk_function(vm_function::kind k, unsigned arity, expr const & src) {
+        m_functions.push_back(std::unique_ptr<vm_function>(new vm_function(k, arity, src)));
+        return m_functions.size() - 1;
+    }
+
+    unsigned add_quote(expr const & e) {
+        m_quotes.push_back(e);
+        return m_quotes.size() - 1;
+    }
+
+    /** \brief Create a code block for \c e. */
+    unsigned compile_code(expr const & e) {
+        unsigned code = mk_code();
+        compile(e, code);
+        emit(code, vm_opcode::Ret);
+        return code;
+    }
+
+    /** \brief Create a function for the lambda expression \c e, and return its index. */
+    unsigned compile_lambda(expr const & e) {
+        unsigned arity = 0;
+        expr it = e;
+        while (is_lambda(it)) {
+            it = binding_body(it);
+            arity++;
+        }
+        unsigned fn = mk_function(vm_function::kind::Code, arity, e);
+        unsigned code = compile_code(it);
+        m_functions[fn]->m_code = code;
+        return fn;
+    }
+
+    optional<expr> expand_macro(expr const & e) {
+        if (!m_tc)
+            m_tc.reset(new type_checker(m_env));
+        return m_tc->expand_macro(e);
+    }
+
+    void compile(expr const & e, unsigned code) {
+        check_system("vm compiler");
+        switch (e.kind()) {
+        case expr_kind::Var:
+            emit(code, vm_opcode::Var, var_idx(e));
+            break;
+        case expr_kind::Sort: case expr_kind::Pi: case expr_kind::Meta: case expr_kind::Local:
+            emit(code, vm_opcode::Quote, add_quote(e));
+            break;
+        case expr_kind::Constant:
+            if (auto idx = get_global(e))
+                emit(code, vm_opcode::Global, *idx);
+            else
+                emit(code, vm_opcode::Quote, add_quote(e));
+            break;
+        case expr_kind::Macro:
+            if (auto r = expand_macro(e))
+                compile(*r, code);
+            else
+                throw_vm_exception(sstream() << "bytecode compiler failed, macro '" << macro_def(e).get_name()
+                                   << "' cannot be expanded");
+            break;
+        case expr_kind::Lambda:
+            emit(code, vm_opcode::Closure, compile_lambda(e));
+            break;
+        case expr_kind::App: {
+            buffer<expr> args;
+            expr const & fn = get_app_args(e, args);
+            for (expr const & arg : args)
+                compile_arg(arg, code);
+            compile(fn, code);
+            emit(code, vm_opcode::App, args.size());
+            break;
+        }}
+    }
+
+    /** \brief Applications are suspended, the other arguments are cheap to evaluate. */
+    void compile_arg(expr const & e, unsigned code) {
+        if (is_app(e) || is_macro(e))
+            emit(code, vm_opcode::Thunk, compile_code(e));
+        else
+            compile(e, code);
+    }
+
+    /** \brief Return the position of the global value for the constant \c e, or none if it is neutral. */
+    optional<unsigned> get_global(expr const & e) {
+        auto it = m_global_idx.find(e);
+        if (it != m_global_idx.end())
+            return it->second;
+        optional<vm_obj> v = mk_global(e);
+        optional<unsigned> r;
+        if (v) {
+            r = optional<unsigned>(m_globals.size());
+            m_globals.push_back(*v);
+        }
+        m_global_idx.insert(mk_pair(e, r));
+        return r;
+    }
+
+    optional<vm_obj> mk_global(expr const & e) {
+        name const & n = const_name(e);
+        if (auto I = inductive::is_intro_rule(m_env, n)) {
+            auto rule = inductive::get_comp_rule_rhs(m_env, n);
+            if (!rule)
+                return optional<vm_obj>();
+            unsigned num_params = *inductive::get_num_params(m_env, *I);
+            vm_function * fn    = m_functions[mk_function(vm_function::kind::Constructor, num_params + rule->first, e)].get();
+            fn->m_num_params    = num_params;
+            if (fn->m_arity == 0)
+                return optional<vm_obj>(vm_obj(new vm_constructor(fn)));
+            else
+                return optional<vm_obj>(vm_obj(new vm_closure(fn, vm_env())));
+        } else if (auto I = inductive::is_elim_rule(m_env, n)) {
+            unsigned major_idx  = *inductive::get_elim_major_idx(m_env, n);
+            vm_function * fn    = m_functions[mk_function(vm_function::kind::Recursor, major_idx + 1, e)].get();
+            fn->m_num_params    = *inductive::get_num_params(m_env, *I);
+            fn->m_num_ACe       = major_idx - *inductive::get_num_indices(m_env, *I);
+            return optional<vm_obj>(vm_obj(new vm_closure(fn, vm_env())));
+        } else if (auto d = m_env.find(n)) {
+            if (d->is_definition() && d->get_num_univ_params() == length(const_levels(e)) && m_unfold(*d)) {
+                expr v = instantiate_value_univ_params(*d, const_levels(e));
+                return optional<vm_obj>(vm_obj(new vm_thunk(v)));
+            }
+        }
+        return optional<vm_obj>();
+    }
+
+    /** \brief Return the right-hand-side of the computational rule for recursor \c rec and intro rule \c intro */
+    optional<vm_obj> get_comp_rule(expr const & rec, name const & intro) {
+        expr key = mk_constant(intro, const_levels(rec));
+        auto it = m_comp_rules.find(key);
+        if (it != m_comp_rules.end())
+            return optional<vm_obj>(it->second);
+        auto I1 = inductive::is_intro_rule(m_env, intro);
+        auto I2 = inductive::is_elim_rule(m_env, const_name(rec));
+        if (!I1 || !I2 || *I1 != *I2)
+            return optional<vm_obj>();
+        auto rule = inductive::get_comp_rule_rhs(m_env, intro);
+        if (!rule)
+            return optional<vm_obj>();
+        declaration d = m_env.get(const_name(rec));
+        expr rhs      = instantiate_univ_params(rule->second, d.get_univ_params(), const_levels(rec));
+        vm_obj r(new vm_closure(m_functions[compile_lambda(rhs)].get(), vm_env()));
+        m_comp_rules.insert(mk_pair(key, r));
+        return optional<vm_obj>(r);
+    }
+
+    // ==========================================
+    // Read back
+
+    /** \brief Instantiate the free variables of \c e with the (read back) values in \c env. */
+    expr instantiate_env(expr const & e, vm_env const & env) {
+        unsigned n = get_free_var_range(e);
+        if (n == 0)
+            return e;
+        buffer<expr> subst;
+        for (vm_obj const & o : env) {
+            if (subst.size() == n)
+                break;
+            subst.push_back(readback(o));
+        }
+        return instantiate(e, subst.size(), subst.data());
+    }
+
+    expr readback(vm_obj const & _o) {
+        check_system("vm read back");
+        vm_obj o = force(_o);
+        switch (o.kind()) {
+        case vm_obj_kind::Neutral:
+            return to_neutral(o)->m_expr;
+        case vm_obj_kind::Constructor: {
+            vm_constructor * c = to_constructor(o);
+            buffer<expr> args;
+            for (vm_obj const & a : c->m_args)
+                args.push_back(readback(a));
+            return mk_app(c->m_fn->m_source, args);
+        }
+        case vm_obj_kind::Closure: {
+            vm_closure * c = to_closure(o);
+            expr fn = c->m_fn->m_source;
+            if (c->m_fn->m_kind == vm_function::kind::Code)
+                fn = instantiate_env(fn, c->m_env);
+            buffer<expr> args;
+            for (vm_obj const & a : c->m_args)
+                args.push_back(readback(a));
+            return mk_app(fn, args);
+        }
+        case vm_obj_kind::Thunk:
+            break;
+        }
+        lean_unreachable();
+    }
+
+    // ==========================================
+    // Interpreter
+
+    vm_obj force(vm_obj const & o) {
+        vm_obj r = o;
+        while (r.kind() == vm_obj_kind::Thunk) {
+            vm_thunk * t = to_thunk(r);
+            if (!t->m_value) {
+                if (t->m_code == 0)
+                    t->m_code = compile_code(t->m_source);
+                t->m_value = run(t->m_code, t->m_env);
+                t->m_env   = vm_env(); // the environment is not needed anymore
+            }
+            r = t->m_value;
+        }
+        return r;
+    }
+
+    vm_obj pop() {
+        vm_obj r = m_stack.back();
+        m_stack.pop_back();
+        return r;
+    }
+
+    /** \brief Move the \c n values on the top of the stack to \c args */
+    void pop_args(unsigned n, buffer<vm_obj> & args) {
+        lean_assert(m_stack.size() >= n);
+        for (unsigned i = m_stack.size() - n; i < m_stack.size(); i++)
+            args.push_back(m_stack[i]);
+        m_stack.resize(m_stack.size() - n);
+    }
+
+    vm_obj mk_neutral_app(expr const & fn, unsigned num, vm_obj const * args) {
+        buffer<expr> new_args;
+        for (unsigned i = 0; i < num; i++)
+            new_args.push_back(readback(args[i]));
+        return mk_vm_neutral(mk_app(fn, new_args));
+    }
+
+    /** \brief Apply \c f to the \c n values on the top of the stack. */
+    void invoke(vm_obj const & _f, unsigned n) {
+        vm_obj f = force(_f);
+        switch (f.kind()) {
+        case vm_obj_kind::Neutral: {
+            buffer<vm_obj> args;
+            pop_args(n, args);
+            m_stack.push_back(mk_neutral_app(to_neutral(f)->m_expr, args.size(), args.data()));
+            return;
+        }
+        case vm_obj_kind::Constructor:
+            throw_vm_exception(sstream() << "bytecode interpreter failed, constructor '"
+                               << const_name(to_constructor(f)->m_fn->m_source) << "' has been applied to too many arguments");
+        case vm_obj_kind::Closure: {
+            vm_closure * c     = to_closure(f);
+            unsigned arity     = c->m_fn->m_arity;
+            unsigned num_args  = c->m_args.size() + n;
+            if (num_args < arity) {
+                vm_closure * new_c = new vm_closure(c->m_fn, c->m_env);
+                vm_obj r(new_c);
+                new_c->m_args = c->m_args;
+                for (unsigned i = m_stack.size() - n; i < m_stack.size(); i++)
+                    new_c->m_args.push_back(m_stack[i]);
+                m_stack.resize(m_stack.size() - n);
+                m_stack.push_back(r);
+            } else {
+                // the first (arity - c->m_args.size()) values are consumed, the others are extra arguments
+                unsigned num_extra = num_args - arity;
+                unsigned num_used  = n - num_extra;
+                unsigned begin     = m_stack.size() - n;
+                buffer<vm_obj> args;
+                args.append(c->m_args.size(), c->m_args.data());
+                for (unsigned i = 0; i < num_used; i++)
+                    args.push_back(m_stack[begin + i]);
+                for (unsigned i = 0; i < num_extra; i++)
+                    m_stack[begin + i] = m_stack[begin + num_used + i];
+                m_stack.resize(begin + num_extra);
+                call(c->m_fn, c->m_env, args, num_extra);
+            }
+            return;
+        }
+        case vm_obj_kind::Thunk:
+            break;
+        }
+        lean_unreachable();
+    }
+
+    /** \brief Invoke \c fn with exactly \c fn->m_arity arguments. The extra arguments are on the top of the stack. */
+    void call(vm_function const * fn, vm_env const & env, buffer<vm_obj> const & args, unsigned num_extra) {
+        switch (fn->m_kind) {
+        case vm_function::kind::Code: {
+            vm_env new_env = env;
+            for (vm_obj const & a : args)
+                new_env = cons(a, new_env);
+            m_frames.push_back(frame(fn->m_code, new_env, num_extra));
+            return;
+        }
+        case vm_function::kind::Constructor: {
+            vm_constructor * c = new vm_constructor(fn);
+            vm_obj r(c);
+            c->m_args.assign(args.begin(), args.end());
+            if (num_extra > 0)
+                invoke(r, num_extra);
+            else
+                m_stack.push_back(r);
+            return;
+        }
+        case vm_function::kind::Recursor: {
+            vm_obj major = force(args.back());
+            if (major.kind() == vm_obj_kind::Constructor) {
+                vm_constructor * c = to_constructor(major);
+                if (auto rhs = get_comp_rule(fn->m_source, const_name(c->m_fn->m_source))) {
+                    buffer<vm_obj> extra;
+                    pop_args(num_extra, extra);
+                    m_stack.insert(m_stack.end(), args.begin(), args.begin() + fn->m_num_ACe);
+                    m_stack.insert(m_stack.end(), c->m_args.begin() + c->m_fn->m_num_params, c->m_args.end());
+                    m_stack.insert(m_stack.end(), extra.begin(), extra.end());
+                    unsigned n = fn->m_num_ACe + (c->m_args.size() - c->m_fn->m_num_params) + num_extra;
+                    invoke(*rhs, n);
+                    return;
+                }
+            }
+            // the major premise is not a constructor
+            vm_obj r = mk_neutral_app(fn->m_source, args.size(), args.data());
+            if (num_extra > 0)
+                invoke(r, num_extra);
+            else
+                m_stack.push_back(r);
+            return;
+        }}
+    }
+
+    vm_obj quote(unsigned i, vm_env const & env) {
+        expr const & e = m_quotes[i];
+        return mk_vm_neutral(instantiate_env(e, env));
+    }
+
+    /** \brief Execute the given code block using the environment \c env, and return the result. */
+    vm_obj run(unsigned code, vm_env const & env) {
+        unsigned base = m_frames.size();
+        m_frames.push_back(frame(code, env, 0));
+        while (true) {
+            m_num_steps++;
+            if ((m_num_steps & 0xFFF) == 0)
+                check_system("vm interpreter");
+            frame & fr          = m_frames.back();
+            vm_instr const & in = m_codes[fr.m_code].m_instrs[fr.m_pc++];
+            switch (in.m_op) {
+            case vm_opcode::Var: {
+                unsigned i = in.m_arg;
+                vm_env it  = fr.m_env;
+                for (; i > 0; i--)
+                    it = tail(it);
+                m_stack.push_back(head(it));
+                break;
+            }
+            case vm_opcode::Global:
+                m_stack.push_back(m_globals[in.m_arg]);
+                break;
+            case vm_opcode::Quote:
+                m_stack.push_back(quote(in.m_arg, fr.m_env));
+                break;
+            case vm_opcode::Closure:
+                m_stack.push_back(vm_obj(new vm_closure(m_functions[in.m_arg].get(), fr.m_env)));
+                break;
+            case vm_opcode::Thunk:
+                m_stack.push_back(vm_obj(new vm_thunk(in.m_arg, fr.m_env)));
+                break;
+            case vm_opcode::App: {
+                unsigned n = in.m_arg;
+                vm_obj f   = pop();
+                invoke(f, n);
+                break;
+            }
+            case vm_opcode::Ret: {
+                vm_obj r           = pop();
+                unsigned num_extra = fr.m_num_extra;
+                m_frames.pop_back();
+                if (m_frames.size() == base) {
+                    lean_assert(num_extra == 0);
+                    return r;
+                }
+                if (num_extra > 0)
+                    invoke(r, num_extra);
+                else
+                    m_stack.push_back(r);
+                break;
+            }}
+        }
+    }
+
+    expr operator()(expr const & e) {
+        unsigned code   = compile_code(e);
+        size_t stack_sz = m_stack.size();
+        try {
+            return readback(run(code, vm_env()));
+        } catch (...) {
+            m_stack.resize(stack_sz);
+            m_frames.clear();
+            throw;
+        }
+    }
+};
+
+static bool default_unfold(declaration const & d) {
+    return !d.is_theorem() && !d.is_opaque();
+}
+
+vm_fn::vm_fn(environment const & env):m_ptr(new imp(env, default_unfold)) {}
+vm_fn::vm_fn(environment const & env, std::function<bool(declaration const &)> const & unfold):m_ptr(new imp(env, unfold)) {}
+vm_fn::~vm_fn() {}
+expr vm_fn::operator()(expr const & e) { return (*m_ptr)(e); }
+unsigned long long vm_fn::get_num_steps() const { return m_ptr->m_num_steps; }
+unsigned vm_fn::get_code_size() const { return m_ptr->m_code_size; }
+
+expr vm_eval(environment const & env, expr const & e) {
+    return vm_fn(env)(e);
+}
+
+class vm_converter : public converter {
+    std::unique_ptr<converter> m_conv;
+    vm_fn                      m_vm;
+
+    static bool is_ground(expr const & e) {
+        return closed(e) && !has_local(e) && !has_metavar(e);
+    }
+
+public:
+    vm_converter(environment const & env, std::unique_ptr<converter> && conv):
+        m_conv(std::move(conv)),
+        m_vm(env, [=](declaration const & d) { return !m_conv->is_opaque(d); }) {}
+    virtual optional<module_idx> get_module_idx() const { return m_conv->get_module_idx(); }
+    virtual bool is_opaque(declaration const & d) const { return m_conv->is_opaque(d); }
+    virtual optional<declaration> is_delta(expr const & e) const { return m_conv->is_delta(e); }
+    virtual bool may_reduce_later(expr const & e, type_checker & c) { return m_conv->may_reduce_later(e, c); }
+    virtual pair<expr, constraint_seq> whnf(expr const & e, type_checker & c) { return m_conv->whnf(e, c); }
+    virtual pair<bool, constraint_seq> is_def_eq(expr const & t, expr const & s, type_checker & c, delayed_justification & j) {
+        if (is_eqp(t, s) || t == s)
+            return mk_pair(true, constraint_seq());
+        if (is_ground(t) && is_ground(s) && (is_app(t) || is_app(s))) {
+            // evaluate the application first, the other side is often a value already (e.g., fib 10 =?= 89)
+            expr const & a = is_app(t) ? t : s;
+            expr const & b = is_app(t) ? s : t;
+            try {
+                expr v = m_vm(a);
+                if (v == b || v == m_vm(b))
+                    return mk_pair(true, constraint_seq());
+            } catch (interrupted &) {
+                throw;
+            } catch (exception &) {
+                // the default procedure is used when the evaluator fails
+            }
+        }
+        return m_conv->is_def_eq(t, s, c, j);
+    }
+};
+
+std::unique_ptr<converter> mk_vm_converter(environment const & env, std::unique_ptr<converter> && conv) {
+    return std::unique_ptr<converter>(new vm_converter(env, std::move(conv)));
+}
+}
@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <memory>
+#include <functional>
+#include "kernel/environment.h"
+#include "kernel/converter.h"
+
+namespace lean {
+/**
+   \brief Evaluator for computable terms based on an abstract machine.
+
+   Terms are compiled into a compact bytecode, and executed by a stack machine with
+   environment-based closures. Arguments that are applications are evaluated lazily (call-by-need).
+   Definitions are compiled on demand, and their values are computed at most once.
+   Recursors are reduced using the computational rules of the inductive datatypes.
+
+   Types, local constants, metavariables, and constants that cannot be unfolded (e.g., axioms and theorems)
+   are "neutral" values. A neutral value applied to arguments is also neutral. Recursor applications
+   where the major premise is not a constructor are neutral too.
+
+   The result of the evaluation is "read back" as an expression that is definitionally equal to the input.
+   Data is fully evaluated, but the body of functions (i.e., closures) is not.
+
+   \remark The evaluator only unfolds the definitions accepted by the predicate provided to the constructor.
+   By default, theorems and opaque definitions are not unfolded.
+*/
+class vm_fn {
+    struct imp;
+    std::unique_ptr<imp> m_ptr;
+public:
+    vm_fn(environment const & env);
+    vm_fn(environment const & env, std::function<bool(declaration const &)> const & unfold);
+    ~vm_fn();
+
+    /**
+        \brief Evaluate \c e.
+        \remark It throws an exception if \c e contains a macro that cannot be expanded.
+    */
+    expr operator()(expr const & e);
+
+    /** \brief Return the number of bytecode instructions executed so far. */
+    unsigned long long get_num_steps() const;
+    /** \brief Return the number of bytecode instructions produced so far. */
+    unsigned get_code_size() const;
+};
+
+/** \brief Evaluate \c e using \c vm_fn */
+expr vm_eval(environment const & env, expr const & e);
+
+/**
+   \brief Create a converter that decides whether two closed terms (without local constants and metavariables)
+   are definitionally equal by evaluating them using \c vm_fn, and comparing the results.
+   All other requests, and the ones where the results are different, are delegated to \c conv.
+
+   \remark The evaluator only unfolds definitions that are not opaque with respect to \c conv.
+*/
+std::unique_ptr<converter> mk_vm_converter(environment const & env, std::unique_ptr<converter> && conv);
+}
@@ -25,6 +25,7 @@ Author: Leonardo de Moura
 #include "kernel/environment.h"
 #include "kernel/kernel_exception.h"
 #include "kernel/formatter.h"
+#include "kernel/default_converter.h"
 #include "library/standard_kernel.h"
 #include "library/hott_kernel.h"
 #include "library/module.h"
@@ -105,6 +106,8 @@ static void display_help(std::ostream & out) {
     std::cout << "  --to_axiom -X     discard proofs of all theorems after checking them, i.e.,\n";
     std::cout << "                    theorems become axioms after checking\n";
     std::cout << "  --quiet -q        do not print verbose messages\n";
+    std::cout << "  --hash-cons -a    share structurally equal expressions using a global table\n";
+    std::cout << "  --defeq-stats -T  display hit rates of the definitional equality memo\n";
 #if defined(LEAN_TRACK_MEMORY)
     std::cout << "  --memory=num -M   maximum amount of memory that should be used by Lean ";
     std::cout << "                    (in megabytes)\n";
@@ -162,6 +165,8 @@ static struct option g_long_options[] = {
     {"threads",      required_argument, 0, 'j'},
 #endif
     {"quiet",        no_argument,       0, 'q'},
+    {"hash-cons",    no_argument,       0, 'a'},
+    {"defeq-stats",  no_argument,       0, 'T'},
     {"cache",        required_argument, 0, 'c'},
     {"deps",         no_argument,       0, 'd'},
     {"flycheck",     no_argument,       0, 'F'},
@@ -175,7 +180,7 @@ static struct option g_long_options[] = {
     {0, 0, 0, 0}
 };
 
-#define OPT_STR "HRXFC:dD:qrlupgvhk:012t:012o:c:i:L:012O:012G"
+#define OPT_STR "HRXFC:dD:qaTrlupgvhk:012t:012o:c:i:L:012O:012G"
 
 #if defined(LEAN_TRACK_MEMORY)
 #define OPT_STR2 OPT_STR "M:012"
@@ -225,6 +230,8 @@ options set_config_option(options const & opts, char const * in) {
         case lean::IntOption:
         case lean::UnsignedOption:
             return opts.update(opt, atoi(val.c_str()));
+        case lean::StringOption:
+            return opts.update(opt, val.c_str());
         default:
             throw lean::exception(lean::sstream() << "invalid -D parameter, configuration option '" << opt
                                   << "' cannot be set in the command line, use set_option command");
@@ -356,6 +363,7 @@ int main(int argc, char ** argv) {
     optional<unsigned> line;
     optional<unsigned> column;
     bool show_goal = false;
+    bool defeq_stats = false;
     input_kind default_k = input_kind::Unspecified;
     while (true) {
         int c = getopt_long(argc, argv, g_opt_str, g_long_options, NULL);
@@ -431,6 +439,13 @@ int main(int argc, char ** argv) {
         case 'q':
             opts = opts.update(lean::get_verbose_opt_name(), false);
             break;
+        case 'a':
+            lean::enable_expr_hash_consing(true);
+            break;
+        case 'T':
+            defeq_stats = true;
+            lean::enable_def_eq_memo_stats(true);
+            break;
         case 'd':
             only_deps = true;
             break;
@@ -596,6 +611,8 @@ int main(int argc, char ** argv) {
         if (export_cpp && ok) {
             export_as_cpp_file(cpp_output, "olean_lib", env);
         }
+        if (defeq_stats)
+            std::cerr << lean::get_def_eq_memo_stats();
         return ok ? 0 : 1;
     } catch (lean::throwable & ex) {
         lean::display_error(diagnostic(env, ios), nullptr, ex);
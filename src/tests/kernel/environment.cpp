@@ -8,12 +8,15 @@ Author: Leonardo de Moura
 #include "util/test.h"
 #include "util/exception.h"
 #include "util/trace.h"
+#include "util/thread.h"
 #include "util/init_module.h"
 #include "util/sexpr/init_module.h"
 #include "kernel/environment.h"
 #include "kernel/type_checker.h"
 #include "kernel/abstract.h"
 #include "kernel/kernel_exception.h"
+#include "kernel/converter_cache.h"
+#include "kernel/default_converter.h"
 #include "kernel/init_module.h"
 #include "library/init_module.h"
 #include "library/print.h"
@@ -173,6 +176,217 @@ static void tst4() {
     }
 }
 
+static void tst5() {
+    environment env(LEAN_BELIEVER_TRUST_LEVEL+1);
+    unsigned num_calls = 0;
+    expr Prop = mk_Prop();
+    declaration d = mk_lazy_definition("Prop", level_param_names(), mk_Type(),
+                                       [&]() { num_calls++; return Prop; }, false, 1, 0, true);
+    lean_assert(d.is_definition());
+    lean_assert(!d.is_theorem());
+    lean_assert(d.is_value_delayed());
+    lean_assert(d.get_weight() == 1);
+    env = env.add(d);
+    lean_assert(num_calls == 0);
+    lean_assert(env.find("Prop")->get_type() == mk_Type());
+    lean_assert(num_calls == 0);
+    lean_assert(env.find("Prop")->get_value() == Prop);
+    lean_assert(env.find("Prop")->get_value() == Prop);
+    lean_assert(!d.is_value_delayed());
+    lean_assert(num_calls == 1);
+    declaration t = mk_lazy_theorem("T", level_param_names(), Prop, [&]() { num_calls++; return Prop; }, 0);
+    lean_assert(t.is_theorem());
+    lean_assert(t.get_value() == Prop);
+    lean_assert(num_calls == 2);
+}
+
+static void tst6() {
+    environment env;
+    expr Prop = mk_Prop();
+    buffer<certified_declaration> ds;
+    ds.push_back(check(env, mk_definition("A", level_param_names(), mk_Type(), Prop)));
+    ds.push_back(check(env, mk_definition("B", level_param_names(), mk_Type(), Prop)));
+    environment env2 = env.add(ds.size(), ds.data());
+    lean_assert(env2.find("A") && env2.find("B"));
+    lean_assert(!env.find("A"));
+    try {
+        // certified declarations must have distinct names
+        ds.push_back(check(env, mk_definition("A", level_param_names(), mk_Type(), Prop)));
+        env.add(ds.size(), ds.data());
+        lean_unreachable();
+    } catch (kernel_exception & ex) {
+        std::cout << "expected error: " << ex.what() << "\n";
+    }
+    try {
+        // declarations checked in env2 cannot be added to env
+        certified_declaration c = check(env2, mk_definition("C", level_param_names(), mk_Type(), Prop));
+        env.add(1, &c);
+        lean_unreachable();
+    } catch (kernel_exception & ex) {
+        std::cout << "expected error: " << ex.what() << "\n";
+    }
+}
+
+static void tst7() {
+    expr Prop = mk_Prop();
+    expr A    = mk_constant("A");
+    expr B    = mk_constant("B");
+    environment env0;
+    environment env1 = add_decl(env0, mk_definition(env0, "A", level_param_names(), mk_Type(), Prop));
+    environment env2 = add_decl(env1, mk_definition(env1, "B", level_param_names(), mk_Type(), A));
+    converter_cache & cache = env2.get_converter_cache();
+    lean_assert(&cache == &env0.get_converter_cache());
+    cache.clear();
+    {
+        type_checker tc(env1);
+        // B is not declared in env1, so the result must not be cached
+        lean_assert(tc.whnf(B).first == B);
+    }
+    lean_assert(!cache.find_whnf(env1, 0, B));
+    {
+        type_checker tc(env2);
+        lean_assert(tc.whnf(B).first == Prop);
+        lean_assert(tc.is_def_eq(B, A).first);
+    }
+    // results survive the type checker, and they can be used in descendants
+    environment env3 = add_decl(env2, mk_definition(env2, "C", level_param_names(), mk_Type(), Prop));
+    lean_assert(cache.find_whnf(env2, 0, B) && *cache.find_whnf(env2, 0, B) == Prop);
+    lean_assert(cache.find_whnf(env3, 0, B) && *cache.find_whnf(env3, 0, B) == Prop);
+    lean_assert(cache.is_def_eq(env3, 0, A, B));
+    lean_assert(cache.is_def_eq(env3, 0, B, A));
+    lean_assert(!cache.is_def_eq(env3, 1, A, B));
+    // but not in ancestors and siblings
+    environment env4 = add_decl(env1, mk_definition(env1, "B", level_param_names(), mk_Type(), mk_arrow(Prop, Prop)));
+    lean_assert(!cache.find_whnf(env4, 0, B));
+    lean_assert(!cache.is_def_eq(env4, 0, A, B));
+    {
+        type_checker tc(env4);
+        lean_assert(tc.whnf(B).first == mk_arrow(Prop, Prop));
+        lean_assert(!tc.is_def_eq(B, A).first);
+    }
+    // the entry produced in env2 was replaced
+    lean_assert(*cache.find_whnf(env4, 0, B) == mk_arrow(Prop, Prop));
+    lean_assert(!cache.find_whnf(env3, 0, B));
+    cache.clear();
+    lean_assert(cache.size() == 0);
+    bool old = enable_converter_cache(false);
+    {
+        type_checker tc(env2);
+        lean_assert(tc.whnf(B).first == Prop);
+    }
+    lean_assert(cache.size() == 0);
+    enable_converter_cache(old);
+}
+
+static void tst8() {
+    expr Prop = mk_Prop();
+    expr A    = mk_constant("A");
+    expr B    = mk_constant("B");
+    expr f    = mk_constant("f");
+    environment env0;
+    environment env1 = add_decl(env0, mk_definition(env0, "A", level_param_names(), mk_Type(), Prop));
+    environment env2 = add_decl(env1, mk_definition(env1, "B", level_param_names(), mk_Type(), mk_arrow(Prop, Prop)));
+    environment env3 = add_decl(env2, mk_constant_assumption("f", level_param_names(), mk_arrow(mk_Type(), Prop)));
+    bool old = enable_def_eq_memo_stats(true);
+    reset_def_eq_memo_stats();
+    {
+        type_checker tc(env3);
+        lean_assert(!tc.is_def_eq(mk_app(f, A), mk_app(f, B)).first);
+        // failures are remembered in both directions
+        lean_assert(!tc.is_def_eq(mk_app(f, B), mk_app(f, A)).first);
+        lean_assert(!tc.is_def_eq(A, B).first);
+        lean_assert(tc.is_def_eq(mk_app(f, A), mk_app(f, Prop)).first);
+    }
+    def_eq_memo_stats s = get_def_eq_memo_stats();
+    enable_def_eq_memo_stats(old);
+    lean_assert(!old);
+    {
+        // statistics are not collected when they are disabled
+        type_checker tc(env3);
+        lean_assert(!tc.is_def_eq(mk_app(f, A), mk_app(f, B)).first);
+    }
+    lean_assert(get_def_eq_memo_stats().m_num_queries == s.m_num_queries);
+    std::cout << s;
+    lean_assert(s.m_num_failure_hits >= 2);
+    lean_assert(s.m_num_queries > s.m_num_failure_hits);
+    equiv_manager m;
+    m.add_failure(A, B);
+    lean_assert(m.is_failure(B, A));
+    lean_assert(!m.is_failure(A, Prop));
+    m.add_equiv(A, Prop);
+    lean_assert(m.is_failure(Prop, B));
+}
+
+static void tst9() {
+    expr Prop = mk_Prop();
+    atomic<unsigned> num_calls(0);
+    declaration d1 = mk_lazy_definition("A", level_param_names(), mk_Type(),
+                                        [&]() { num_calls++; return Prop; }, false, 1, 0, true);
+    // the value of d2 forces the value of d1
+    declaration d2 = mk_lazy_definition("B", level_param_names(), mk_Type(),
+                                        [&]() { num_calls++; return d1.get_value(); }, false, 2, 0, true);
+#if defined(LEAN_MULTI_THREAD)
+    std::vector<thread> threads;
+    for (unsigned i = 0; i < 8; i++) {
+        threads.push_back(thread([&]() {
+                    lean_assert(d2.get_value() == Prop);
+                    lean_assert(d1.get_value() == Prop);
+                }));
+    }
+    for (thread & t : threads)
+        t.join();
+#else
+    lean_assert(d2.get_value() == Prop);
+    lean_assert(d1.get_value() == Prop);
+#endif
+    lean_assert(num_calls == 2);
+    lean_assert(!d1.is_value_delayed());
+    lean_assert(!d2.is_value_delayed());
+}
+
+class shared_cache_converter : public default_converter {
+public:
+    shared_cache_converter(environment const & env):default_converter(env, optional<module_idx>()) {}
+    virtual bool use_converter_cache() const { return true; }
+};
+
+class private_cache_converter : public default_converter {
+public:
+    private_cache_converter(environment const & env):default_converter(env, optional<module_idx>()) {}
+};
+
+static void tst10() {
+    expr Prop = mk_Prop();
+    expr A    = mk_constant("A");
+    environment env0;
+    environment env1 = add_decl(env0, mk_definition(env0, "A", level_param_names(), mk_Type(), Prop));
+    converter_cache & cache = env1.get_converter_cache();
+    cache.clear();
+    {
+        // subclasses do not use the shared cache unless they opt in
+        type_checker tc(env1, name_generator("test"), std::unique_ptr<converter>(new private_cache_converter(env1)));
+        lean_assert(tc.whnf(A).first == Prop);
+    }
+    lean_assert(!cache.find_whnf(env1, 0, A));
+    {
+        type_checker tc(env1, name_generator("test"), std::unique_ptr<converter>(new shared_cache_converter(env1)));
+        lean_assert(tc.whnf(A).first == Prop);
+    }
+    lean_assert(cache.find_whnf(env1, 0, A));
+    cache.clear();
+
+    // shards evict the least recently used entry
+    unsigned capacity = 2 * LEAN_CONVERTER_CACHE_SHARDS;
+    converter_cache c(capacity);
+    expr e0 = mk_constant("e0");
+    c.add_whnf(env1, 0, e0, Prop);
+    for (unsigned i = 1; i < 10 * capacity; i++) {
+        c.add_whnf(env1, 0, mk_constant(name("e").append_after(i)), Prop);
+        lean_assert(c.find_whnf(env1, 0, e0));
+        lean_assert(c.size() <= capacity);
+    }
+}
+
 namespace lean {
 class environment_id_tester {
 public:
@@ -259,6 +473,12 @@ int main() {
     tst2();
     tst3();
     tst4();
+    tst5();
+    tst6();
+    tst7();
+    tst8();
+    tst9();
+    tst10();
     environment_id_tester::tst1();
     environment_id_tester::tst2();
     finalize_library_module();
@@ -374,6 +374,62 @@ static void tst18() {
     lean_assert(!has_local(mk_app(f, a0, a0, a0, a0)));
 }
 
+static expr mk_big_term(unsigned n) {
+    expr A = Const("A");
+    expr f = Const("f");
+    expr r = A;
+    for (unsigned i = 0; i < n; i++)
+        r = mk_app(f, r, mk_pi("x", A, mk_app(f, mk_var(0), r)));
+    return r;
+}
+
+static void tst19() {
+    bool old = enable_expr_hash_consing(true);
+    {
+        expr t1 = mk_big_term(10);
+        expr t2 = mk_big_term(10);
+        lean_assert(is_eqp(t1, t2));
+        lean_assert(get_expr_hash_consing_size() > 0);
+#if defined(LEAN_MULTI_THREAD)
+        std::vector<expr> rs(8);
+        std::vector<thread> ths;
+        for (unsigned i = 0; i < rs.size(); i++)
+            ths.emplace_back([&, i]() { rs[i] = mk_big_term(10); });
+        for (thread & th : ths)
+            th.join();
+        for (expr const & r : rs)
+            lean_assert(is_eqp(r, t1));
+#endif
+    }
+    // the table does not keep expressions alive
+    expr t3 = mk_big_term(2);
+    unsigned sz = get_expr_hash_consing_size();
+    lean_assert(sz < 20);
+    enable_expr_hash_consing(old);
+    // expressions created when the table is disabled are not shared using the table
+    expr t4 = mk_big_term(2);
+    lean_assert(t3 == t4);
+    lean_assert(get_expr_hash_consing_size() == sz);
+}
+
+static void tst20() {
+    expr N = Const("N");
+    expr f = Const("f");
+    expr x = Local("x", N);
+    expr y = Local("y", mk_app(f, x));
+    expr m = mk_metavar("m", N);
+    expr e = Fun(x, mk_app(f, x, mk_app(m, Var(0))));
+    lean_assert(get_mlocal_filter(f) == 0);
+    lean_assert(get_mlocal_filter(Var(0)) == 0);
+    lean_assert(may_contain_mlocal(x, "x"));
+    lean_assert(may_contain_mlocal(y, "x")); // x occurs in the type of y
+    lean_assert(may_contain_mlocal(e, "m"));
+    lean_assert(get_mlocal_filter(e) == mk_mlocal_filter("m"));  // x was abstracted
+    lean_assert(get_mlocal_filter(mk_app(y, m)) == (get_mlocal_filter(y) | get_mlocal_filter(m)));
+    if (mk_mlocal_filter("x") != mk_mlocal_filter("m"))
+        lean_assert(!may_contain_mlocal(m, "x"));
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -400,6 +456,8 @@ int main() {
     tst16();
     tst17();
     tst18();
+    tst19();
+    tst20();
     std::cout << "sizeof(expr):            " << sizeof(expr) << "\n";
     std::cout << "sizeof(expr_cell):       " << sizeof(expr_cell) << "\n";
     std::cout << "sizeof(expr_app):        " << sizeof(expr_app) << "\n";
@@ -65,6 +65,26 @@ static void tst2() {
     lean_assert(!is_equivalent(zero, p2));
 }
 
+static void tst3() {
+    level p1 = mk_param_univ("p1");
+    level p2 = mk_param_univ("p2");
+    level l  = mk_max(mk_succ(p1), mk_max(p2, mk_succ(mk_succ(p1))));
+#ifdef LEAN_CACHE_EXPRS
+    // levels are hash-consed
+    lean_assert(is_eqp(p1, mk_param_univ("p1")));
+    lean_assert(is_eqp(l, mk_max(mk_succ(p1), mk_max(p2, mk_succ(mk_succ(p1))))));
+#endif
+    // the normal form is cached
+    level n = normalize(l);
+    lean_assert(is_eqp(normalize(l), n));
+    lean_assert(is_eqp(normalize(n), normalize(n)));
+    // the normal form is its own normal form
+    lean_assert(is_eqp(normalize(n), n));
+    lean_assert(n == mk_max(mk_succ(mk_succ(p1)), p2));
+    lean_assert(is_equivalent(l, mk_max(mk_succ(mk_succ(p1)), p2)));
+    lean_assert(is_geq(l, mk_succ(p1)));
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -73,6 +93,7 @@ int main() {
     initialize_library_module();
     tst1();
     tst2();
+    tst3();
     finalize_library_module();
     finalize_kernel_module();
     finalize_sexpr_module();
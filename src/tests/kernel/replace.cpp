@@ -7,10 +7,12 @@ Author: Leonardo de Moura
 #include "util/test.h"
 #include "util/name.h"
 #include "util/init_module.h"
+#include "util/timeit.h"
 #include "util/sexpr/init_module.h"
 #include "kernel/expr.h"
 #include "kernel/abstract.h"
 #include "kernel/instantiate.h"
+#include "kernel/free_vars.h"
 #include "kernel/expr_maps.h"
 #include "kernel/replace_fn.h"
 #include "kernel/init_module.h"
@@ -62,6 +64,63 @@ public:
     }
 };
 
+/** \brief Callback used by instantiate(e, 0, n, subst) */
+static optional<expr> instantiate_callback(unsigned n, expr const * subst, expr const & m, unsigned offset) {
+    if (offset >= get_free_var_range(m))
+        return some_expr(m);
+    if (is_var(m) && var_idx(m) >= offset) {
+        unsigned vidx = var_idx(m);
+        if (vidx < offset + n)
+            return some_expr(lift_free_vars(subst[vidx - offset], offset));
+        else
+            return some_expr(mk_var(vidx - n));
+    }
+    return none_expr();
+}
+
+static void tst3() {
+    // compare replace and replace_spine
+    expr f = Const("f");
+    expr g = Const("g");
+    expr a = Const("a");
+    expr N = Const("N");
+    buffer<expr> args;
+    for (unsigned i = 0; i < 1000; i++)
+        args.push_back(i % 3 == 0 ? mk_app(g, Var(i % 7), a) : (i % 3 == 1 ? Var(i % 5) : mk_app(g, a, a)));
+    expr e = mk_lambda("x", N, mk_app(f, args));
+    for (unsigned i = 0; i < 5; i++)
+        e = mk_app(f, e, mk_pi("y", e, mk_app(g, Var(0), Var(1))));
+    expr subst[2] = { mk_app(g, a), Var(10) };
+    auto fn = [&](expr const & m, unsigned offset) { return instantiate_callback(2, subst, m, offset); };
+    expr r1, r2;
+    {
+        timeit timer(std::cout, "replace");
+        for (unsigned i = 0; i < 100; i++)
+            r1 = replace(e, fn);
+    }
+    {
+        timeit timer(std::cout, "replace_spine");
+        for (unsigned i = 0; i < 100; i++)
+            r2 = replace_spine(e, fn);
+    }
+    lean_assert(r1 == r2);
+    lean_assert(r1 == instantiate(e, 2, subst));
+    lean_assert(replace(e, fn, false) == replace_spine(e, fn, false));
+}
+
+static void tst4() {
+    // replace_spine does not use the stack for visiting long application spines
+    expr f = Const("f");
+    expr a = Const("a");
+    expr e = f;
+    for (unsigned i = 0; i < 100000; i++)
+        e = mk_app(e, i % 2 == 0 ? Var(0) : a);
+    expr r = instantiate(e, a);
+    lean_assert(closed(r));
+    lean_assert(get_app_fn(r) == f);
+    lean_assert(abstract(r, a) != r);
+}
+
 int main() {
     save_stack_info();
     init_default_print_fn();
@@ -70,6 +129,8 @@ int main() {
     initialize_kernel_module();
     tst1();
     tst2();
+    tst3();
+    tst4();
     std::cout << "done" << "\n";
     finalize_kernel_module();
     finalize_sexpr_module();
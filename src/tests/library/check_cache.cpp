@@ -0,0 +1,158 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <fstream>
+#include "util/test.h"
+#include "util/thread.h"
+#include "util/exception.h"
+#include "util/serializer.h"
+#include "util/init_module.h"
+#include "util/sexpr/init_module.h"
+#include "kernel/init_module.h"
+#include "library/init_module.h"
+#include "library/check_cache.h"
+using namespace lean;
+
+static char const * g_fname = "check_cache_test.cache";
+
+static check_cache::key mk_key(unsigned i) {
+    std::string s = std::to_string(i);
+    return hash_check_cache_data(s.data(), s.data() + s.size());
+}
+
+static void tst1() {
+    std::remove(g_fname);
+    {
+        check_cache c(g_fname);
+        lean_assert(!c.contains(mk_key(1)));
+        c.insert(mk_key(1));
+        c.insert(mk_key(2));
+        lean_assert(c.contains(mk_key(1)));
+        c.save();
+    }
+    {
+        check_cache c(g_fname);
+        lean_assert(c.contains(mk_key(1)));
+        lean_assert(c.contains(mk_key(2)));
+        lean_assert(!c.contains(mk_key(3)));
+        c.insert(mk_key(3));
+        c.save();
+    }
+    check_cache c(g_fname);
+    lean_assert(c.contains(mk_key(1)) && c.contains(mk_key(2)) && c.contains(mk_key(3)));
+}
+
+static void tst2() {
+    // keys of modified data (or data with modified dependencies) are not in the cache
+    std::remove(g_fname);
+    std::string data1("definition a : num := 0");
+    std::string data2("definition a : num := 1");
+    check_cache::key dep1 = hash_check_cache_data(data1.data(), data1.data() + data1.size());
+    check_cache::key dep2 = hash_check_cache_data(data2.data(), data2.data() + data2.size());
+    lean_assert(dep1 != dep2);
+    std::string data3("definition b : num := a");
+    check_cache::key k = hash_check_cache_data(data3.data(), data3.data() + data3.size());
+    {
+        check_cache c(g_fname);
+        c.insert(dep1);
+        c.insert(combine_check_cache_keys(k, dep1));
+        c.save();
+    }
+    check_cache c(g_fname);
+    lean_assert(c.contains(dep1));
+    lean_assert(c.contains(combine_check_cache_keys(k, dep1)));
+    lean_assert(!c.contains(dep2));
+    lean_assert(!c.contains(combine_check_cache_keys(k, dep2)));
+}
+
+static void tst3() {
+    // concurrent writers do not lose each other's updates
+    std::remove(g_fname);
+    unsigned num_writers = 8;
+    unsigned num_keys    = 100;
+#if defined(LEAN_MULTI_THREAD)
+    std::vector<thread> writers;
+    for (unsigned i = 0; i < num_writers; i++) {
+        writers.push_back(thread([=]() {
+                    check_cache c(g_fname);
+                    for (unsigned j = 0; j < num_keys; j++) {
+                        c.insert(mk_key(i * num_keys + j));
+                        if (j % 10 == 0)
+                            c.save();
+                    }
+                    c.save();
+                }));
+    }
+    for (thread & t : writers)
+        t.join();
+#else
+    for (unsigned i = 0; i < num_writers; i++) {
+        check_cache c(g_fname);
+        for (unsigned j = 0; j < num_keys; j++)
+            c.insert(mk_key(i * num_keys + j));
+        c.save();
+    }
+#endif
+    check_cache c(g_fname);
+    for (unsigned k = 0; k < num_writers * num_keys; k++)
+        lean_assert(c.contains(mk_key(k)));
+}
+
+static void tst4() {
+    {
+        std::ofstream out(g_fname, std::ofstream::binary);
+        out << "not a cache";
+    }
+    try {
+        check_cache c(g_fname);
+        lean_unreachable();
+    } catch (exception &) {
+    }
+    std::remove(g_fname);
+    std::remove((std::string(g_fname) + ".lock").c_str());
+}
+
+static void tst5() {
+    // caches created with 64-bit keys are ignored
+    {
+        std::ofstream out(g_fname, std::ofstream::binary);
+        serializer s(out);
+        s << "leancheckcache";
+        s.write_unsigned(1);
+        s.write_uint64(1);
+    }
+    {
+        check_cache c(g_fname);
+        lean_assert(!c.contains(mk_key(1)));
+        c.insert(mk_key(1));
+        c.save();
+    }
+    check_cache c(g_fname);
+    lean_assert(c.contains(mk_key(1)));
+    std::remove(g_fname);
+    std::remove((std::string(g_fname) + ".lock").c_str());
+}
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    initialize_sexpr_module();
+    initialize_kernel_module();
+    initialize_library_module();
+    tst1();
+    tst2();
+    tst3();
+    tst4();
+    tst5();
+    finalize_library_module();
+    finalize_kernel_module();
+    finalize_sexpr_module();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include "util/test.h"
+#include "util/interrupt.h"
+#include "util/init_module.h"
+#include "util/sexpr/init_module.h"
+#include "kernel/type_checker.h"
+#include "kernel/init_module.h"
+#include "library/init_module.h"
+#include "library/definitional/checked_decls.h"
+using namespace lean;
+
+static environment add_decl(environment const & env, declaration const & d) {
+    auto cd = check(env, d, name_generator("test"));
+    return env.add(cd);
+}
+
+static environment mk_env(expr const & c2_value) {
+    expr Type = mk_Type();
+    expr A    = mk_constant("A");
+    expr P    = mk_constant("P");
+    environment env;
+    env = add_decl(env, mk_constant_assumption("A", level_param_names(), Type));
+    env = add_decl(env, mk_constant_assumption("a", level_param_names(), A));
+    env = add_decl(env, mk_constant_assumption("b", level_param_names(), A));
+    env = add_decl(env, mk_constant_assumption("P", level_param_names(), mk_arrow(A, mk_Prop())));
+    env = add_decl(env, mk_axiom("H", level_param_names(), mk_app(P, mk_constant("a"))));
+    env = add_decl(env, mk_definition(env, "c2", level_param_names(), A, c2_value));
+    env = add_decl(env, mk_definition(env, "c", level_param_names(), A, mk_constant("c2")));
+    return env;
+}
+
+static void tst1() {
+    expr P = mk_constant("P");
+    environment env1 = mk_env(mk_constant("a"));
+    environment env2 = mk_env(mk_constant("a"));
+    environment env3 = mk_env(mk_constant("b"));
+    declaration t = mk_theorem("t", level_param_names(), mk_app(P, mk_constant("c")), mk_constant("H"));
+    checked_decls s;
+    lean_assert(!s.contains(env1, t));
+    {
+        scoped_checked_decls scope(s);
+        check_aux_decl(env1, t);
+    }
+    lean_assert(s.contains(env1, t));
+    // the dependencies are structurally equal
+    lean_assert(s.contains(env2, t));
+    // t only mentions c, but c unfolds to c2, and c2 has been modified
+    lean_assert(!s.contains(env3, t));
+    s.clear();
+    lean_assert(!s.contains(env1, t));
+}
+
+static void tst2() {
+    expr P = mk_constant("P");
+    environment env1 = mk_env(mk_constant("a"));
+    environment env2 = mk_env(mk_constant("a"));
+    declaration t = mk_theorem("t", level_param_names(), mk_app(P, mk_constant("c")), mk_constant("H"));
+    checked_decls s;
+    environment env3;
+    {
+        scoped_checked_decls scope(s);
+        env3 = env1.add(check_aux_decl(env1, t));
+    }
+    // t is in env3
+    s.retain(env3);
+    lean_assert(s.contains(env2, t));
+    // t is not in env1
+    s.retain(env1);
+    lean_assert(!s.contains(env2, t));
+}
+
+#if defined(LEAN_MULTI_THREAD)
+static void tst3() {
+    environment env = mk_env(mk_constant("a"));
+    buffer<aux_decl_fn> fns;
+    for (unsigned i = 0; i < 4; i++) {
+        fns.push_back([](environment const & env) {
+                while (true)
+                    sleep_for(10);
+                return env;
+            });
+    }
+    checked_decls s;
+    // the procedures only terminate when they are interrupted
+    request_interrupt();
+    try {
+        precheck_aux_decls(env, fns, 2, s);
+        lean_unreachable();
+    } catch (interrupted &) {
+    }
+    lean_assert(!interrupt_requested());
+}
+#else
+static void tst3() {}
+#endif
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    initialize_sexpr_module();
+    initialize_kernel_module();
+    initialize_library_module();
+    tst1();
+    tst2();
+    tst3();
+    finalize_library_module();
+    finalize_kernel_module();
+    finalize_sexpr_module();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include "util/test.h"
+#include "util/init_module.h"
+#include "util/sexpr/init_module.h"
+#include "kernel/type_checker.h"
+#include "kernel/init_module.h"
+#include "library/init_module.h"
+#include "library/class_instance_cache.h"
+using namespace lean;
+
+static environment add_decl(environment const & env, declaration const & d) {
+    auto cd = check(env, d, name_generator("test"));
+    return env.add(cd);
+}
+
+static void tst1() {
+    expr Type = mk_Type();
+    expr C    = mk_constant("C");
+    expr N    = mk_constant("N");
+    expr i    = mk_constant("i");
+    environment env1;
+    env1 = add_decl(env1, mk_constant_assumption("C", level_param_names(), Type >> Type));
+    env1 = add_decl(env1, mk_constant_assumption("N", level_param_names(), Type));
+    environment env2 = add_decl(env1, mk_constant_assumption("i", level_param_names(), mk_app(C, N)));
+    environment env3 = add_decl(env2, mk_constant_assumption("a", level_param_names(), N));
+    environment env4 = add_decl(env1, mk_constant_assumption("i", level_param_names(), mk_app(C, N)));
+    class_instance_cache cache;
+    class_instance_cache_key k1(mk_app(C, N), list<expr>(), 0);
+    class_instance_cache_key k2(mk_app(C, N), list<expr>(), 1);
+    class_instance_cache_key k3(mk_app(C, N), list<expr>(), 0);
+    lean_assert(k1 == k3);
+    lean_assert(!(k1 == k2));
+    lean_assert(!cache.find(env2, k1));
+    cache.insert(env2, k1, i);
+    lean_assert(*cache.find(env2, k1) == i);
+    lean_assert(*cache.find(env3, k3) == i);
+    lean_assert(!cache.find(env3, k2));
+    // env1 is not a descendant of env2
+    lean_assert(!cache.find(env1, k1));
+    // env4 is not a descendant of env2 (e.g., the declaration was reprocessed)
+    lean_assert(!cache.find(env4, k1));
+    lean_assert(cache.get_num_hits() == 2);
+    lean_assert(cache.get_num_misses() == 4);
+}
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    initialize_sexpr_module();
+    initialize_kernel_module();
+    initialize_library_module();
+    tst1();
+    finalize_library_module();
+    finalize_kernel_module();
+    finalize_sexpr_module();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include "util/test.h"
+#include "util/init_module.h"
+#include "util/sexpr/init_module.h"
+#include "kernel/type_checker.h"
+#include "kernel/init_module.h"
+#include "library/init_module.h"
+#include "library/decl_search_index.h"
+using namespace lean;
+
+static environment add_decl(environment const & env, declaration const & d) {
+    auto cd = check(env, d, name_generator("test"));
+    return env.add(cd);
+}
+
+static environment add_cnst(environment const & env, name const & n, expr const & t) {
+    return add_decl(env, mk_constant_assumption(n, level_param_names(), t));
+}
+
+static bool contains(decl_search_index const & idx, buffer<unsigned> const & r, name const & n) {
+    for (unsigned i : r) {
+        if (idx.get_decl(i).get_name() == n)
+            return true;
+    }
+    return false;
+}
+
+static void tst1() {
+    expr Prop = mk_Prop();
+    expr A    = mk_constant("A");
+    expr B    = mk_constant("B");
+    environment env;
+    env = add_cnst(env, "A", Prop);
+    env = add_cnst(env, "B", Prop);
+    env = add_cnst(env, name({"nat", "add_comm"}), A);
+    env = add_cnst(env, name({"nat", "add_assoc"}), Prop >> A);
+    env = add_cnst(env, name({"nat", "mul_comm"}), B);
+    decl_search_index idx;
+    idx.update(env);
+    lean_assert(idx.find(name({"nat", "add_comm"})));
+    lean_assert(!idx.find("add_comm"));
+    buffer<unsigned> r;
+    idx.find_prefix("add", r);
+    idx.filter(env, r);
+    lean_assert(r.size() == 2);
+    lean_assert(contains(idx, r, name({"nat", "add_comm"})));
+    lean_assert(contains(idx, r, name({"nat", "add_assoc"})));
+    r.clear();
+    idx.find_prefix("nat.mul", r);
+    idx.filter(env, r);
+    lean_assert(r.size() == 1);
+    r.clear();
+    idx.find_fuzzy("add_comm", 1, r);
+    idx.filter(env, r);
+    lean_assert(contains(idx, r, name({"nat", "add_comm"})));
+    r.clear();
+    idx.find_conclusion(A, r);
+    idx.filter(env, r);
+    lean_assert(r.size() == 2);
+    lean_assert(contains(idx, r, name({"nat", "add_assoc"})));
+    lean_assert(!contains(idx, r, name({"nat", "mul_comm"})));
+    // declarations that are not in the environment are filtered
+    environment env2 = add_cnst(env, name({"nat", "add_zero"}), A);
+    idx.update(env2);
+    r.clear();
+    idx.find_prefix("add", r);
+    lean_assert(r.size() == 3);
+    idx.update(env);
+    idx.filter(env, r);
+    lean_assert(r.size() == 2);
+    lean_assert(!contains(idx, r, name({"nat", "add_zero"})));
+}
+
+static void tst2() {
+    expr Prop = mk_Prop();
+    expr A    = mk_constant("A");
+    environment env;
+    env = add_cnst(env, "A", Prop);
+    env = add_cnst(env, "B", Prop);
+    env = add_cnst(env, name({"nat", "add_comm"}), A);
+    decl_search_index idx;
+    idx.update(env);
+    // a declaration is renamed (e.g., the file was edited, and processed again from a snapshot)
+    environment env2 = add_cnst(env, name({"nat", "add_zero"}), A);
+    environment env3 = add_cnst(env, name({"nat", "zero_add"}), A);
+    idx.update(env2);
+    lean_assert(idx.find(name({"nat", "add_zero"})));
+    idx.update(env3);
+    lean_assert(!idx.find(name({"nat", "add_zero"})));
+    lean_assert(idx.find(name({"nat", "zero_add"})));
+    buffer<unsigned> r;
+    idx.find_prefix("add", r);
+    idx.filter(env3, r);
+    lean_assert(r.size() == 1);
+    lean_assert(contains(idx, r, name({"nat", "add_comm"})));
+    r.clear();
+    idx.find_conclusion(A, r);
+    idx.filter(env3, r);
+    lean_assert(r.size() == 2);
+    lean_assert(!contains(idx, r, name({"nat", "add_zero"})));
+    // the declaration is added again
+    idx.update(env2);
+    r.clear();
+    idx.find_prefix("add", r);
+    idx.filter(env2, r);
+    lean_assert(r.size() == 2);
+    lean_assert(contains(idx, r, name({"nat", "add_zero"})));
+    // most declarations are removed, the index is rebuilt
+    environment env4;
+    env4 = add_cnst(env4, "A", Prop);
+    idx.update(env4);
+    idx.update(env);
+    r.clear();
+    idx.find_all(r);
+    idx.filter(env, r);
+    lean_assert(r.size() == 3);
+}
+
+static void tst3() {
+    // the conclusion of a declaration whose type is a definition (e.g., transitive R) is only known after unfolding it
+    expr Prop  = mk_Prop();
+    expr P     = mk_constant("P");
+    expr trans = mk_constant("trans");
+    environment env;
+    env = add_cnst(env, "P", Prop);
+    env = add_decl(env, mk_definition(env, "trans", level_param_names(), Prop, P));
+    env = add_cnst(env, "trans_P", trans);
+    env = add_cnst(env, "P_of_P", Prop >> P);
+    decl_search_index idx;
+    idx.update(env);
+    buffer<unsigned> r;
+    idx.find_conclusion(P, r);
+    idx.filter(env, r);
+    lean_assert(contains(idx, r, "trans_P"));
+    lean_assert(contains(idx, r, "P_of_P"));
+    r.clear();
+    idx.find_conclusion(trans, r);
+    idx.filter(env, r);
+    lean_assert(contains(idx, r, "trans_P"));
+    lean_assert(contains(idx, r, "P_of_P"));
+    // Q is an axiom in env1, and a definition in env2
+    environment env1 = add_cnst(env, "Q", Prop);
+    env1 = add_cnst(env1, "Q_lemma", mk_constant("Q"));
+    environment env2 = add_decl(env, mk_definition(env, "Q", level_param_names(), Prop, P));
+    env2 = add_cnst(env2, "Q_lemma", mk_constant("Q"));
+    idx.update(env1);
+    idx.update(env2);
+    r.clear();
+    idx.find_conclusion(P, r);
+    idx.filter(env2, r);
+    lean_assert(contains(idx, r, "Q_lemma"));
+}
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    initialize_sexpr_module();
+    initialize_kernel_module();
+    initialize_library_module();
+    tst1();
+    tst2();
+    tst3();
+    finalize_library_module();
+    finalize_kernel_module();
+    finalize_sexpr_module();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include "util/test.h"
+#include "util/init_module.h"
+#include "util/sexpr/init_module.h"
+#include "kernel/type_checker.h"
+#include "kernel/abstract.h"
+#include "kernel/init_module.h"
+#include "kernel/inductive/inductive.h"
+#include "library/init_module.h"
+#include "library/reducible.h"
+#include "library/discr_tree.h"
+using namespace lean;
+
+static environment add_decl(environment const & env, declaration const & d) {
+    auto cd = check(env, d, name_generator("test"));
+    return env.add(cd);
+}
+
+static buffer<unsigned> find(discr_tree<unsigned> const & t, environment const & env, expr const & e) {
+    buffer<unsigned> r;
+    t.find(env, e, [&](unsigned v) { r.push_back(v); });
+    std::sort(r.begin(), r.end());
+    return r;
+}
+
+static bool is_eq(buffer<unsigned> const & r, std::initializer_list<unsigned> const & l) {
+    return r.size() == l.size() && std::equal(r.begin(), r.end(), l.begin());
+}
+
+static void tst1() {
+    expr Type  = mk_Type();
+    expr N     = mk_constant("N");
+    expr B     = mk_constant("B");
+    expr C     = mk_constant("C");
+    expr f     = mk_constant("f");
+    expr a     = mk_constant("a");
+    environment env;
+    env = add_decl(env, mk_constant_assumption("N", level_param_names(), Type));
+    env = add_decl(env, mk_constant_assumption("B", level_param_names(), Type));
+    env = add_decl(env, mk_constant_assumption("C", level_param_names(), Type >> Type));
+    env = add_decl(env, mk_constant_assumption("a", level_param_names(), N));
+    env = add_decl(env, mk_definition("f", level_param_names(), Type >> Type, Fun(Local("x", Type), mk_app(C, Local("x", Type)))));
+    name_generator ngen("m");
+    expr m = mk_metavar(ngen.next(), Type);
+    discr_tree<unsigned> t;
+    t.insert(env, mk_app(C, N), 1);
+    t.insert(env, mk_app(C, mk_var(0)), 2);
+    t.insert(env, mk_app(C, B), 3);
+    t.insert(env, mk_app(f, N), 4); // f is a definition, then it is a wildcard
+    t.insert(env, mk_app(C, N), 5);
+    lean_assert(is_eq(find(t, env, mk_app(C, N)), {1, 2, 4, 5}));
+    lean_assert(is_eq(find(t, env, mk_app(C, B)), {2, 3, 4}));
+    lean_assert(is_eq(find(t, env, mk_app(C, m)), {1, 2, 3, 4, 5}));
+    lean_assert(is_eq(find(t, env, mk_app(C, mk_app(f, N))), {1, 2, 3, 4, 5}));
+    lean_assert(is_eq(find(t, env, m), {1, 2, 3, 4, 5}));
+    lean_assert(is_eq(find(t, env, mk_app(C, mk_app(C, N))), {2, 4}));
+    lean_assert(is_eq(find(t, env, N), {4}));
+    lean_assert(is_eq(find(t, env, a), {1, 2, 3, 4, 5})); // a is not a type, then it is a wildcard
+    lean_assert(is_eq(find(t, env, Local("x", Type)), {4}));
+    lean_assert(t.may_match(env, mk_app(C, N)));
+    // copies are not affected by updates
+    discr_tree<unsigned> t2 = t;
+    t2.insert(env, mk_app(C, mk_app(C, N)), 6);
+    lean_assert(is_eq(find(t2, env, mk_app(C, mk_app(C, N))), {2, 4, 6}));
+    lean_assert(is_eq(find(t, env, mk_app(C, mk_app(C, N))), {2, 4}));
+    // a type checker that does not unfold f makes it rigid
+    auto tc = mk_opaque_type_checker(env, name_generator("tc"));
+    discr_tree<unsigned> t3(tc.get());
+    t3.insert(env, mk_app(f, N), 1);
+    lean_assert(!t3.may_match(env, mk_app(C, N)));
+    lean_assert(t3.may_match(env, mk_app(f, m)));
+    discr_tree<unsigned> t4;
+    t4.insert(env, mk_app(f, N), 1);
+    lean_assert(t4.may_match(env, mk_app(C, N)));
+}
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    initialize_sexpr_module();
+    initialize_kernel_module();
+    initialize_inductive_module();
+    initialize_library_module();
+    tst1();
+    finalize_library_module();
+    finalize_inductive_module();
+    finalize_kernel_module();
+    finalize_sexpr_module();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
@@ -196,6 +196,38 @@ void tst6() {
     lean_assert(counter == 5);
 }
 
+#if defined(LEAN_MULTI_THREAD)
+static void tst7() {
+    // The owner is notified as soon as the jobs terminate, check_ms is only used to check interrupts.
+    unsigned n = 0;
+    for_each(par(from(0, 1, 999), from(0, 1, 999), 1000), [&](int) { n++; });
+    lean_assert(n == 2000);
+    n = 0;
+    for_each(timeout(append(take(100, seq(1)), loop()), 100, 1000), [&](int) { n++; });
+    lean_assert(n == 100);
+    job_group g;
+    g.add([]() { while (true) { check_interrupted(); } });
+    g.add([]() {});
+    lean_assert(g.wait(1) >= 1);
+    lean_assert(g.wait_for(2, 10) == 1);
+    g.interrupt();
+    g.wait_all();
+    lean_assert(g.num_done() == 2);
+}
+#endif
+
+static void tst8() {
+    lazy_list<int> empty;
+    auto r = portfolio(list<lazy_list<int>>({empty, take(3, seq(7))}), 2).pull();
+    lean_assert(r && r->first == 7);
+    lean_assert(!portfolio(list<lazy_list<int>>({empty, empty}), 2).pull());
+    lean_assert(!portfolio(list<lazy_list<int>>(), 2).pull());
+#if defined(LEAN_MULTI_THREAD)
+    // loop() is interrupted after seq(7) succeeds, seq(7) is only started after empty fails
+    check(portfolio(list<lazy_list<int>>({empty, loop(), take(3, seq(7))}), 2), list<int>({7, 8, 9}));
+#endif
+}
+
 int main() {
     save_stack_info();
     tst1();
@@ -204,5 +236,9 @@ int main() {
     tst4();
     tst5();
     tst6();
+#if defined(LEAN_MULTI_THREAD)
+    tst7();
+#endif
+    tst8();
     return has_violations() ? 1 : 0;
 }
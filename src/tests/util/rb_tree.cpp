@@ -235,6 +235,55 @@ static void tst6() {
 #endif
 }
 
+static void check_diff(int_rb_tree const & t1, int_rb_tree const & t2, unsigned max_calls) {
+    std::vector<int> only1, only2;
+    unsigned num_calls = 0;
+    t1.for_each_diff(t2, [&](int const * v1, int const * v2) {
+            num_calls++;
+            lean_assert(v1 || v2);
+            if (!v2)
+                only1.push_back(*v1);
+            else if (!v1)
+                only2.push_back(*v2);
+            else
+                lean_assert(*v1 == *v2);
+        });
+    std::vector<int> expected1, expected2;
+    t1.for_each([&](int v) { if (!t2.contains(v)) expected1.push_back(v); });
+    t2.for_each([&](int v) { if (!t1.contains(v)) expected2.push_back(v); });
+    lean_assert(only1 == expected1);
+    lean_assert(only2 == expected2);
+    lean_assert(num_calls <= max_calls);
+}
+
+static void tst7() {
+    int_rb_tree t1;
+    for (int i = 0; i < 1000; i += 2)
+        t1.insert(i);
+    check_diff(t1, t1, 0);
+    int_rb_tree t2 = t1;
+    t2.insert(501);
+    // shared subtrees are skipped
+    check_diff(t2, t1, 64);
+    check_diff(t1, t2, 64);
+    t2.erase(100);
+    t2.erase(998);
+    t2.insert(1001);
+    check_diff(t2, t1, 256);
+    check_diff(t2, int_rb_tree(), 501);
+    check_diff(int_rb_tree(), t2, 501);
+    std::mt19937 rng;
+    int_rb_tree t3 = t1;
+    for (unsigned i = 0; i < 100; i++) {
+        int v = rng() % 2000;
+        if (rng() % 2 == 0)
+            t3.insert(v);
+        else
+            t3.erase(v);
+        check_diff(t3, t1, 1000);
+    }
+}
+
 int main() {
     tst1();
     tst2();
@@ -242,6 +291,7 @@ int main() {
     tst4();
     tst5();
     tst6();
+    tst7();
     return has_violations() ? 1 : 0;
 }
 
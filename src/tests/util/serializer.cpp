@@ -171,6 +171,49 @@ static void tst4() {
     lean_assert_eq(d5, o5);
 }
 
+static void tst5() {
+    std::ostringstream out;
+    serializer s(out);
+    name n1{"foo", "bla"};
+    name n2(n1, 10);
+    list<int> l1{1, 2, 3};
+    s << std::string("hello") << 10u << n1 << n2 << l1 << true << n2 << cons(0, l1);
+    std::string str = out.str();
+    deserializer d(str.data(), str.data() + str.size());
+    lean_assert(d.is_memory_based());
+    std::string h; unsigned u; name m1, m2, m3; list<int> new_l1, new_l2; bool b;
+    d >> h >> u >> m1 >> m2 >> new_l1 >> b >> m3 >> new_l2;
+    lean_assert(h == "hello");
+    lean_assert(u == 10);
+    lean_assert(n1 == m1);
+    lean_assert(n2 == m2);
+    lean_assert(n2 == m3);
+    lean_assert(b);
+    lean_assert_eq(l1, new_l1);
+    lean_assert(is_eqp(new_l1, tail(new_l2)));
+    lean_assert(d.get_pos() == str.data() + str.size());
+    try {
+        d.read_unsigned();
+        lean_unreachable();
+    } catch (corrupted_stream_exception &) {}
+}
+
+static void tst6() {
+    std::ostringstream out;
+    serializer s(out);
+    s << "abc" << 20u;
+    std::string str = out.str();
+    deserializer d(str.data(), str.data() + str.size());
+    d.skip(4);
+    lean_assert(d.read_unsigned() == 20);
+    // truncated string
+    deserializer d2(str.data(), str.data() + 2);
+    try {
+        d2.read_string();
+        lean_unreachable();
+    } catch (corrupted_stream_exception &) {}
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -179,6 +222,8 @@ int main() {
     tst2();
     tst3();
     tst4();
+    tst5();
+    tst6();
     finalize_util_module();
     return has_violations() ? 1 : 0;
 }
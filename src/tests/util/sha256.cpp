@@ -0,0 +1,42 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <string>
+#include "util/test.h"
+#include "util/sha256.h"
+using namespace lean;
+
+static std::string digest(std::string const & s) {
+    return mk_sha256(s.data(), s.data() + s.size()).to_string();
+}
+
+static void tst1() {
+    // test vectors from FIPS 180-4
+    lean_assert_eq(digest(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    lean_assert_eq(digest("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    lean_assert_eq(digest("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+                   "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    lean_assert_eq(digest(std::string(1000000, 'a')),
+                   "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+static void tst2() {
+    // incremental updates
+    std::string s("The quick brown fox jumps over the lazy dog");
+    for (unsigned i = 0; i <= s.size(); i++) {
+        sha256 h;
+        h.update(s.data(), i);
+        h.update(s.data() + i, s.size() - i);
+        lean_assert(h.finalize() == mk_sha256(s.data(), s.data() + s.size()));
+    }
+    lean_assert(digest(s) != digest(s + "."));
+}
+
+int main() {
+    tst1();
+    tst2();
+    return has_violations() ? 1 : 0;
+}
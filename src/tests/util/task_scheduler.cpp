@@ -0,0 +1,186 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <memory>
+#include "util/test.h"
+#include "util/task_scheduler.h"
+using namespace lean;
+
+static unsigned fib(unsigned n) { return n < 2 ? n : fib(n-1) + fib(n-2); }
+
+/** \brief Compute fib(n) creating one task per recursive call until the given threshold. */
+static void fib_task(task_scheduler & s, unsigned n, atomic<unsigned> & r) {
+    if (n < 10) {
+        r += fib(n);
+    } else {
+        s.add([&s, n, &r]() { fib_task(s, n-1, r); });
+        s.add([&s, n, &r]() { fib_task(s, n-2, r); });
+    }
+}
+
+static void tst1(unsigned num_threads) {
+    task_scheduler s(num_threads);
+    atomic<unsigned> r(0);
+    s.add([&]() { fib_task(s, 25, r); });
+    s.join();
+    lean_assert(r == fib(25));
+    lean_assert(s.done());
+}
+
+static void tst2(unsigned num_threads) {
+    task_scheduler s(num_threads);
+    atomic<unsigned> counter(0);
+    for (unsigned i = 0; i < 1000; i++) {
+        s.add([&, i]() {
+                counter++;
+                if (i == 500)
+                    throw exception("task failed");
+            });
+    }
+    try {
+        s.join();
+        lean_unreachable();
+    } catch (exception & ex) {
+        lean_assert(std::string(ex.what()) == "task failed");
+    }
+    lean_assert(counter <= 1000);
+}
+
+#if defined(LEAN_MULTI_THREAD)
+/** \brief Owner thread pushes and pops tasks, while the other threads steal them. Each task must be executed once. */
+static void tst3() {
+    unsigned const num_thieves = 4;
+    unsigned const num_tasks   = 100000;
+    work_stealing_deque q(2); // small initial size to stress resizing
+    std::unique_ptr<atomic<unsigned>[]> executed(new atomic<unsigned>[num_tasks]);
+    for (unsigned i = 0; i < num_tasks; i++)
+        executed[i] = 0;
+    atomic<bool> done(false);
+    std::vector<thread> thieves;
+    for (unsigned i = 0; i < num_thieves; i++) {
+        thieves.emplace_back([&]() {
+                while (!done) {
+                    if (scheduler_task * t = q.steal()) {
+                        (*t)();
+                        delete t;
+                    }
+                }
+            });
+    }
+    for (unsigned i = 0; i < num_tasks; i++) {
+        q.push(new scheduler_task([&, i]() { executed[i]++; }));
+        if (i % 3 == 0) {
+            if (scheduler_task * t = q.pop()) {
+                (*t)();
+                delete t;
+            }
+        }
+    }
+    while (scheduler_task * t = q.pop()) {
+        (*t)();
+        delete t;
+    }
+    done = true;
+    for (thread & th : thieves)
+        th.join();
+    for (unsigned i = 0; i < num_tasks; i++)
+        lean_assert(executed[i] == 1);
+}
+
+/**
+   \brief Scaling benchmark. It simulates the module import DAG: each module is a task that
+   depends on the modules of the previous layer, and creates one (asynchronous) type checking
+   task per declaration. We report import throughput (declarations per second) from 1 to 64 threads.
+   It is not executed by default, use the command line option \c --bench.
+*/
+struct import_bench {
+    struct module {
+        atomic<unsigned>     m_counter; // number of dependencies to be processed
+        std::vector<unsigned> m_dependents;
+    };
+    task_scheduler &                     m_scheduler;
+    std::vector<std::unique_ptr<module>> m_modules;
+    unsigned                             m_num_decls;
+    unsigned                             m_decl_cost;
+    atomic<unsigned>                     m_checked;
+
+    import_bench(task_scheduler & s, unsigned num_layers, unsigned width, unsigned num_decls, unsigned decl_cost):
+        m_scheduler(s), m_num_decls(num_decls), m_decl_cost(decl_cost), m_checked(0) {
+        for (unsigned l = 0; l < num_layers; l++) {
+            for (unsigned i = 0; i < width; i++) {
+                m_modules.push_back(std::unique_ptr<module>(new module()));
+                m_modules.back()->m_counter = l == 0 ? 0 : 2;
+                if (l > 0) {
+                    unsigned prev = (l-1)*width;
+                    m_modules[prev + i]->m_dependents.push_back(m_modules.size() - 1);
+                    m_modules[prev + (i + 1) % width]->m_dependents.push_back(m_modules.size() - 1);
+                }
+            }
+        }
+    }
+
+    void check_decl() {
+        volatile unsigned r = 0;
+        for (unsigned i = 0; i < m_decl_cost; i++)
+            r = r + i;
+        m_checked++;
+    }
+
+    void import_module(unsigned idx) {
+        for (unsigned i = 0; i < m_num_decls; i++)
+            m_scheduler.add([=]() { check_decl(); });
+        for (unsigned d : m_modules[idx]->m_dependents) {
+            if (--m_modules[d]->m_counter == 0)
+                m_scheduler.add([=]() { import_module(d); });
+        }
+    }
+
+    void operator()() {
+        for (unsigned i = 0; i < m_modules.size(); i++) {
+            if (m_modules[i]->m_counter == 0)
+                m_scheduler.add([=]() { import_module(i); });
+        }
+        m_scheduler.join();
+    }
+};
+
+static void tst4() {
+    unsigned const layers = 20, width = 16, decls = 200, cost = 2000;
+    double base = 0.0;
+    for (unsigned num_threads = 1; num_threads <= 64; num_threads *= 2) {
+        task_scheduler s(num_threads - 1); // the thread executing join is also a worker
+        import_bench b(s, layers, width, decls, cost);
+        auto start = chrono::steady_clock::now();
+        b();
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        lean_assert(b.m_checked == layers * width * decls);
+        if (num_threads == 1)
+            base = secs;
+        std::cout << "threads: " << num_threads << ", decls/sec: " << static_cast<unsigned>(b.m_checked / secs)
+                  << ", speedup: " << (base / secs) << "\n";
+    }
+}
+#endif
+
+int main(int argc, char ** argv) {
+    save_stack_info();
+    for (unsigned num_threads : {0, 1, 4, 16}) {
+        tst1(num_threads);
+        tst2(num_threads);
+    }
+#if defined(LEAN_MULTI_THREAD)
+    tst3();
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+        tst4();
+#else
+    (void)argc; (void)argv;
+#endif
+    return has_violations() ? 1 : 0;
+}
@@ -6,9 +6,11 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <utility>
+#include <vector>
 #include "util/interrupt.h"
 #include "util/lazy_list.h"
 #include "util/list.h"
+#include "util/thread_pool.h"
 
 namespace lean {
 template<typename T, typename F>
@@ -252,10 +254,10 @@ lazy_list<T> repeat_at_most(T const & v, F && f, unsigned k, char const * cname
    method in the class lazy_list. If the \c pull method timeouts, the lazy list
    is truncated.
 
-   \remark the \c method is executed in a separate execution thread.
+   \remark the \c method is executed by a thread in the pool used by \c job_group.
 
-   \remark \c check_ms is how often the main thread checks whether the child
-   thread finished.
+   \remark \c check_ms is how often the main thread checks whether it has been
+   interrupted. The main thread is notified as soon as the \c pull method terminates.
 */
 #if !defined(LEAN_MULTI_THREAD)
 template<typename T>
@@ -265,41 +267,17 @@ lazy_list<T> timeout(lazy_list<T> const & l, unsigned, unsigned) {
 #else
 template<typename T>
 lazy_list<T> timeout(lazy_list<T> const & l, unsigned ms, unsigned check_ms = g_small_sleep) {
-    if (check_ms == 0)
-        check_ms = 1;
     return mk_lazy_list<T>([=]() {
             typename lazy_list<T>::maybe_pair r;
-            atomic<bool> done(false);
-            interruptible_thread th([&]() {
-                    try {
-                        r = l.pull();
-                    } catch (...) {
-                        r = typename lazy_list<T>::maybe_pair();
-                    }
-                    done = true;
-                });
-            try {
-                auto start = chrono::steady_clock::now();
-                chrono::milliseconds d(ms);
-                chrono::milliseconds small(check_ms);
-                while (!done) {
-                    auto curr = chrono::steady_clock::now();
-                    if (chrono::duration_cast<chrono::milliseconds>(curr - start) > d)
-                        break;
-                    check_interrupted();
-                    this_thread::sleep_for(small);
-                }
-                th.request_interrupt();
-                th.join();
-                if (r)
-                    return some(mk_pair(r->first, timeout(r->second, ms, check_ms)));
-                else
-                    return r;
-            } catch (...) {
-                th.request_interrupt();
-                th.join();
-                throw;
-            }
+            job_group g;
+            g.add([&]() { r = l.pull(); });
+            g.wait_for(1, ms, check_ms);
+            g.interrupt();
+            g.wait_all();
+            if (r)
+                return some(mk_pair(r->first, timeout(r->second, ms, check_ms)));
+            else
+                return r;
         });
 }
 #endif
@@ -308,6 +286,8 @@ lazy_list<T> timeout(lazy_list<T> const & l, unsigned ms, unsigned check_ms = g_
    \brief Similar to interleave, but the heads are computed in parallel.
    Moreover, when pulling results from the lists, if one finishes before the other,
    then the other one is interrupted.
+
+   \remark \c check_ms is how often the main thread checks whether it has been interrupted.
 */
 #if !defined(LEAN_MULTI_THREAD)
 template<typename T>
@@ -320,50 +300,78 @@ lazy_list<T> par(lazy_list<T> const & l1, lazy_list<T> const & l2, unsigned chec
     return mk_lazy_list<T>([=]() {
             typename lazy_list<T>::maybe_pair r1;
             typename lazy_list<T>::maybe_pair r2;
-            atomic<bool>  done1(false);
-            atomic<bool>  done2(false);
-            interruptible_thread th1([&]() {
-                    try {
-                        r1 = l1.pull();
-                    } catch (...) {
-                        r1 = typename lazy_list<T>::maybe_pair();
-                    }
-                    done1 = true;
-                });
-            interruptible_thread th2([&]() {
-                    try {
-                        r2 = l2.pull();
-                    } catch (...) {
-                        r2 = typename lazy_list<T>::maybe_pair();
-                    }
-                    done2 = true;
-                });
-            try {
-                chrono::milliseconds small(check_ms);
-                while (!done1 && !done2) {
-                    check_interrupted();
-                    this_thread::sleep_for(small);
+            job_group g;
+            g.add([&]() { r1 = l1.pull(); });
+            g.add([&]() { r2 = l2.pull(); });
+            if (g.wait(1, check_ms) == 1 && ((g.is_done(0) && !r1) || (g.is_done(1) && !r2))) {
+                // one of the lists is empty, we must wait for the other one
+                g.wait(2, check_ms);
+            }
+            g.interrupt();
+            g.wait_all();
+            if (r1 && r2) {
+                lazy_list<T> tail(r2->first, par(r1->second, r2->second, check_ms));
+                return some(mk_pair(r1->first, tail));
+            } else if (r1) {
+                return some(mk_pair(r1->first, par(r1->second, l2, check_ms)));
+            } else if (r2) {
+                return some(mk_pair(r2->first, par(l1, r2->second, check_ms)));
+            } else {
+                return r2;
+            }
+        });
+}
+#endif
+
+/**
+   \brief Return the first lazy list in \c ls that produces a result (if there is one).
+   The heads of the lists are computed in parallel, but at most \c max_threads are
+   computed at the same time. As soon as one of them produces a result, the others are
+   interrupted. The tail of the resulting lazy list is the tail of the winner.
+
+   \remark \c check_ms is how often the main thread checks whether it has been interrupted.
+*/
+#if !defined(LEAN_MULTI_THREAD)
+template<typename T>
+lazy_list<T> portfolio(list<lazy_list<T>> const & ls, unsigned, unsigned = g_small_sleep) {
+    return mk_lazy_list<T>([=]() {
+            for (lazy_list<T> const & l : ls) {
+                if (auto r = l.pull())
+                    return r;
+                check_system("portfolio");
+            }
+            return typename lazy_list<T>::maybe_pair();
+        });
+}
+#else
+template<typename T>
+lazy_list<T> portfolio(list<lazy_list<T>> const & ls, unsigned max_threads, unsigned check_ms = g_small_sleep) {
+    if (max_threads == 0)
+        max_threads = 1;
+    return mk_lazy_list<T>([=]() {
+            std::vector<lazy_list<T>> todo(ls.begin(), ls.end());
+            std::vector<typename lazy_list<T>::maybe_pair> rs(todo.size());
+            std::vector<bool> checked(todo.size(), false);
+            unsigned num_done = 0;
+            job_group g;
+            while (true) {
+                while (g.size() < todo.size() && g.size() - num_done < max_threads) {
+                    unsigned i = g.size();
+                    g.add([&, i]() { rs[i] = todo[i].pull(); });
                 }
-                th1.request_interrupt();
-                th2.request_interrupt();
-                th1.join();
-                th2.join();
-                if (r1 && r2) {
-                    lazy_list<T> tail(r2->first, par(r1->second, r2->second));
-                    return some(mk_pair(r1->first, tail));
-                } else if (r1) {
-                    return some(mk_pair(r1->first, par(r1->second, l2)));
-                } else if (r2) {
-                    return some(mk_pair(r2->first, par(l1, r2->second)));
-                } else {
-                    return r2;
+                if (num_done == todo.size())
+                    return typename lazy_list<T>::maybe_pair();
+                num_done = g.wait(num_done + 1, check_ms);
+                for (unsigned i = 0; i < g.size(); i++) {
+                    if (!checked[i] && g.is_done(i)) {
+                        checked[i] = true;
+                        if (rs[i]) {
+                            g.interrupt();
+                            g.wait_all();
+                            return rs[i];
+                        }
+                    }
                 }
-            } catch (...) {
-                th1.request_interrupt();
-                th2.request_interrupt();
-                th1.join();
-                th2.join();
-                throw;
             }
         });
 }
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <string>
+#include <fstream>
+#include "util/mapped_file.h"
+#include "util/exception.h"
+#include "util/sstream.h"
+
+#if defined(LEAN_WINDOWS) || defined(LEAN_EMSCRIPTEN)
+#define LEAN_NO_MMAP
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace lean {
+#if defined(LEAN_NO_MMAP)
+mapped_file::mapped_file(std::string const & fname):m_data(nullptr), m_size(0) {
+    std::ifstream in(fname, std::ifstream::binary);
+    if (!in.good())
+        throw exception(sstream() << "failed to open file '" << fname << "'");
+    in.seekg(0, std::ios::end);
+    m_size = in.tellg();
+    in.seekg(0, std::ios::beg);
+    m_buffer.resize(m_size);
+    if (m_size > 0)
+        in.read(m_buffer.data(), m_size);
+    if (!in.good())
+        throw exception(sstream() << "failed to read file '" << fname << "'");
+    m_data = m_buffer.data();
+}
+
+mapped_file::~mapped_file() {}
+#else
+mapped_file::mapped_file(std::string const & fname):m_data(nullptr), m_size(0) {
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw exception(sstream() << "failed to open file '" << fname << "'");
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw exception(sstream() << "failed to access stats of file '" << fname << "'");
+    }
+    m_size = st.st_size;
+    if (m_size > 0) {
+        void * addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw exception(sstream() << "failed to map file '" << fname << "' into memory");
+        }
+        // the file is read sequentially by the deserializer
+        madvise(addr, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<char const *>(addr);
+    }
+    // the mapping remains valid after the file descriptor is closed
+    close(fd);
+}
+
+mapped_file::~mapped_file() {
+    if (m_data)
+        munmap(const_cast<char *>(m_data), m_size);
+}
+#endif
+}
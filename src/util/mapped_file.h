@@ -0,0 +1,34 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <string>
+#include <vector>
+
+namespace lean {
+/**
+   \brief Read-only view of the contents of a file.
+   On POSIX systems the file is mapped into memory using mmap, and the pages are
+   loaded on demand. On other platforms, the whole file is read into a buffer.
+
+   The file contents are accessible while the object is alive.
+*/
+class mapped_file {
+    char const *      m_data;
+    size_t            m_size;
+    std::vector<char> m_buffer; // used when memory mapping is not available
+public:
+    /** \brief Open and map the given file. Throws an exception if the file cannot be accessed. */
+    mapped_file(std::string const & fname);
+    mapped_file(mapped_file const &) = delete;
+    mapped_file & operator=(mapped_file const &) = delete;
+    ~mapped_file();
+    char const * data() const { return m_data; }
+    size_t size() const { return m_size; }
+    char const * begin() const { return m_data; }
+    char const * end() const { return m_data + m_size; }
+};
+}
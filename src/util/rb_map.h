@@ -67,6 +67,18 @@ public:
         return m_map.for_each(f_prime);
     }
 
+    /**
+        \brief Invoke <tt>f(k, v1, v2)</tt> for the keys \c k of this map and \c m that are not stored in shared nodes.
+        \c v1 (\c v2) is a pointer to the value associated with \c k in this map (\c m), or nullptr if there isn't one.
+        See rb_tree::for_each_diff.
+    */
+    template<typename F>
+    void for_each_diff(rb_map const & m, F && f) const {
+        m_map.for_each_diff(m.m_map, [&](entry const * e1, entry const * e2) {
+                f(e1 ? e1->first : e2->first, e1 ? &e1->second : nullptr, e2 ? &e2->second : nullptr);
+            });
+    }
+
     /** \brief (For debugging) Display the content of this splay map. */
     friend std::ostream & operator<<(std::ostream & out, rb_map const & m) {
         out << "{";
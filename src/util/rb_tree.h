@@ -11,6 +11,7 @@ Author: Leonardo de Moura
 #include "util/debug.h"
 #include "util/buffer.h"
 #include "util/optional.h"
+#include "util/pair.h"
 #include "util/memory_pool.h"
 
 namespace lean {
@@ -248,6 +249,41 @@ class rb_tree : public CMP {
         return optional<T>();
     }
 
+    /** \brief Item of the worklists used in #for_each_diff, the flag is true if only the value of the node must be visited. */
+    typedef pair<node_cell const *, bool> diff_item;
+
+    static void push_diff_item(buffer<diff_item> & todo, node_cell const * n) {
+        if (n)
+            todo.push_back(diff_item(n, false));
+    }
+
+    /** \brief Replace the subtree on the top of \c todo with its left subtree, value and right subtree. */
+    static void expand_diff_item(buffer<diff_item> & todo) {
+        node_cell const * n = todo.back().first;
+        todo.pop_back();
+        push_diff_item(todo, n->m_right.m_ptr);
+        todo.push_back(diff_item(n, true));
+        push_diff_item(todo, n->m_left.m_ptr);
+    }
+
+    static T const & min_value(diff_item const & i) {
+        node_cell const * n = i.first;
+        if (!i.second) {
+            while (n->m_left.m_ptr)
+                n = n->m_left.m_ptr;
+        }
+        return n->m_value;
+    }
+
+    static T const & max_value(diff_item const & i) {
+        node_cell const * n = i.first;
+        if (!i.second) {
+            while (n->m_right.m_ptr)
+                n = n->m_right.m_ptr;
+        }
+        return n->m_value;
+    }
+
     static void display(std::ostream & out, node_cell const * n) {
         if (n) {
             out << "(";
@@ -364,6 +400,74 @@ public:
     template<typename F>
     optional<T> find_if(F && f) const { return find_if(f, m_root.m_ptr); }
 
+    /**
+        \brief Invoke <tt>f(v1, v2)</tt> for the elements of this tree and \c t that are not stored in shared nodes.
+        \c v1 (\c v2) is a pointer to the element in this tree (\c t), or nullptr if the element is not in this tree (\c t).
+        The elements are visited in increasing order.
+
+        \remark Subtrees shared by both trees are skipped. So, if \c t was obtained from this tree (or vice-versa)
+        by a few insertions and deletions, the cost is proportional to the number of operations times the depth of the trees.
+        \remark \c f may be invoked with equivalent elements, when they are stored in nodes that are not shared.
+    */
+    template<typename F>
+    void for_each_diff(rb_tree const & t, F && f) const {
+        buffer<diff_item> todo1, todo2;
+        push_diff_item(todo1, m_root.m_ptr);
+        push_diff_item(todo2, t.m_root.m_ptr);
+        while (!todo1.empty() && !todo2.empty()) {
+            diff_item i1 = todo1.back();
+            diff_item i2 = todo2.back();
+            if (i1 == i2 && !i1.second) {
+                todo1.pop_back();
+                todo2.pop_back();
+                continue;
+            }
+            int c = cmp(min_value(i1), min_value(i2));
+            if (c < 0) {
+                if (i1.second) {
+                    f(&i1.first->m_value, static_cast<T const *>(nullptr));
+                    todo1.pop_back();
+                } else {
+                    expand_diff_item(todo1);
+                }
+            } else if (c > 0) {
+                if (i2.second) {
+                    f(static_cast<T const *>(nullptr), &i2.first->m_value);
+                    todo2.pop_back();
+                } else {
+                    expand_diff_item(todo2);
+                }
+            } else if (i1.second && i2.second) {
+                f(&i1.first->m_value, &i2.first->m_value);
+                todo1.pop_back();
+                todo2.pop_back();
+            } else {
+                // same minimum, expand the subtree(s) with the biggest maximum, it may contain the other one.
+                int d = (i1.second || i2.second) ? 0 : cmp(max_value(i1), max_value(i2));
+                if (!i1.second && d >= 0)
+                    expand_diff_item(todo1);
+                if (!i2.second && d <= 0)
+                    expand_diff_item(todo2);
+            }
+        }
+        while (!todo1.empty()) {
+            if (todo1.back().second) {
+                f(&todo1.back().first->m_value, static_cast<T const *>(nullptr));
+                todo1.pop_back();
+            } else {
+                expand_diff_item(todo1);
+            }
+        }
+        while (!todo2.empty()) {
+            if (todo2.back().second) {
+                f(static_cast<T const *>(nullptr), &todo2.back().first->m_value);
+                todo2.pop_back();
+            } else {
+                expand_diff_item(todo2);
+            }
+        }
+    }
+
     // For debugging purposes
     void display(std::ostream & out) const { display(out, m_root.m_ptr); }
 
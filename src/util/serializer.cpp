@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #include <string>
 #include <limits>
 #include <stdio.h>
+#include <cstring>
 #include <ios>
 #include "util/serializer.h"
 #include "util/exception.h"
@@ -58,9 +59,17 @@ void serializer_core::write_double(double d) {
 }
 
 std::string deserializer_core::read_string() {
+    if (!m_in) {
+        char const * zero = static_cast<char const *>(memchr(m_curr, 0, m_end - m_curr));
+        if (!zero)
+            throw corrupted_stream_exception();
+        std::string r(m_curr, zero);
+        m_curr = zero + 1;
+        return r;
+    }
     std::string r;
     while (true) {
-        char c = m_in.get();
+        char c = m_in->get();
         if (c == 0)
             break;
         if (c == EOF)
@@ -73,10 +82,20 @@ std::string deserializer_core::read_string() {
 unsigned deserializer_core::read_unsigned() {
     unsigned r;
     static_assert(sizeof(r) == 4, "unexpected unsigned size");
-    r  = static_cast<unsigned>(m_in.get()) << 24;
-    r |= static_cast<unsigned>(m_in.get()) << 16;
-    r |= static_cast<unsigned>(m_in.get()) << 8;
-    r |= static_cast<unsigned>(m_in.get());
+    if (!m_in) {
+        check_available(4);
+        unsigned char const * p = reinterpret_cast<unsigned char const *>(m_curr);
+        r  = static_cast<unsigned>(p[0]) << 24;
+        r |= static_cast<unsigned>(p[1]) << 16;
+        r |= static_cast<unsigned>(p[2]) << 8;
+        r |= static_cast<unsigned>(p[3]);
+        m_curr += 4;
+        return r;
+    }
+    r  = static_cast<unsigned>(m_in->get()) << 24;
+    r |= static_cast<unsigned>(m_in->get()) << 16;
+    r |= static_cast<unsigned>(m_in->get()) << 8;
+    r |= static_cast<unsigned>(m_in->get());
     return r;
 }
 
@@ -9,6 +9,7 @@ Author: Leonardo de Moura
 #include <string>
 #include <sstream>
 #include <cstring>
+#include "util/exception.h"
 #include "util/extensible_object.h"
 #include "util/list.h"
 #include "util/buffer.h"
@@ -30,6 +31,7 @@ public:
     void write_uint64(uint64 i);
     void write_int(int i);
     void write_char(char c) { m_out.put(c); }
+    void write_chars(char const * data, size_t n) { m_out.write(data, n); }
     void write_bool(bool b) { m_out.put(b ? 1 : 0); }
     void write_double(double b);
 };
@@ -45,21 +47,51 @@ inline serializer & operator<<(serializer & s, char c) { s.write_char(c); return
 inline serializer & operator<<(serializer & s, bool b) { s.write_bool(b); return s; }
 inline serializer & operator<<(serializer & s, double b) { s.write_double(b); return s; }
 
+class corrupted_stream_exception : public exception {
+public:
+    corrupted_stream_exception();
+};
+
 /**
-   \brief Low-tech serializer.
+   \brief Low-tech deserializer.
    The actual functionality is implemented using extensions.
+
+   The data can be read from a std::istream or directly from a memory
+   region [begin, end) (e.g., a memory mapped file). In the latter case,
+   no intermediate buffer is used, and the memory region must remain
+   alive while the deserializer is being used.
 */
 class deserializer_core {
-    std::istream & m_in;
+    std::istream * m_in;
+    char const *   m_curr;
+    char const *   m_end;
+    void check_available(size_t n) const {
+        if (static_cast<size_t>(m_end - m_curr) < n)
+            throw corrupted_stream_exception();
+    }
 public:
-    deserializer_core(std::istream & in):m_in(in) {}
+    deserializer_core(std::istream & in):m_in(&in), m_curr(nullptr), m_end(nullptr) {}
+    deserializer_core(char const * begin, char const * end):m_in(nullptr), m_curr(begin), m_end(end) {}
     std::string read_string();
     unsigned read_unsigned();
     uint64 read_uint64();
     int read_int();
-    char read_char() { return m_in.get(); }
-    bool read_bool() { return m_in.get() != 0; }
+    char read_char() {
+        if (m_in)
+            return m_in->get();
+        check_available(1);
+        return *(m_curr++);
+    }
+    bool read_bool() { return read_char() != 0; }
     double read_double();
+    /** \brief Return true iff the data is being read directly from a memory region. */
+    bool is_memory_based() const { return m_in == nullptr; }
+    /** \brief Return a pointer to the next byte to be read.
+        \pre is_memory_based() */
+    char const * get_pos() const { lean_assert(is_memory_based()); return m_curr; }
+    /** \brief Skip the next \c n bytes.
+        \pre is_memory_based() */
+    void skip(size_t n) { lean_assert(is_memory_based()); check_available(n); m_curr += n; }
 };
 
 typedef extensible_object<deserializer_core> deserializer;
@@ -72,11 +104,6 @@ inline deserializer & operator>>(deserializer & d, char & c) { c = d.read_char()
 inline deserializer & operator>>(deserializer & d, bool & b) { b = d.read_bool(); return d; }
 inline deserializer & operator>>(deserializer & d, double & b) { b = d.read_double(); return d; }
 
-class corrupted_stream_exception : public exception {
-public:
-    corrupted_stream_exception();
-};
-
 void initialize_serializer();
 void finalize_serializer();
 
@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <string>
+#include "util/debug.h"
+#include "util/sha256.h"
+
+namespace lean {
+static unsigned const g_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline unsigned rotr(unsigned x, unsigned n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+sha256::sha256():m_block_size(0), m_length(0) {
+    m_state[0] = 0x6a09e667; m_state[1] = 0xbb67ae85; m_state[2] = 0x3c6ef372; m_state[3] = 0xa54ff53a;
+    m_state[4] = 0x510e527f; m_state[5] = 0x9b05688c; m_state[6] = 0x1f83d9ab; m_state[7] = 0x5be0cd19;
+}
+
+void sha256::process_block(unsigned char const * block) {
+    unsigned w[64];
+    for (unsigned i = 0; i < 16; i++) {
+        w[i] =
+            (static_cast<unsigned>(block[4*i]) << 24) | (static_cast<unsigned>(block[4*i+1]) << 16) |
+            (static_cast<unsigned>(block[4*i+2]) << 8) | static_cast<unsigned>(block[4*i+3]);
+    }
+    for (unsigned i = 16; i < 64; i++) {
+        unsigned s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+        unsigned s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+    unsigned a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    unsigned e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+    for (unsigned i = 0; i < 64; i++) {
+        unsigned s1  = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        unsigned ch  = (e & f) ^ (~e & g);
+        unsigned t1  = h + s1 + ch + g_sha256_k[i] + w[i];
+        unsigned s0  = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        unsigned maj = (a & b) ^ (a & c) ^ (b & c);
+        unsigned t2  = s0 + maj;
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
+    m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+}
+
+void sha256::update(char const * data, size_t n) {
+    unsigned char const * it = reinterpret_cast<unsigned char const *>(data);
+    m_length += n;
+    while (n > 0) {
+        unsigned sz = 64 - m_block_size;
+        if (sz > n)
+            sz = n;
+        std::memcpy(m_block + m_block_size, it, sz);
+        m_block_size += sz;
+        it += sz;
+        n  -= sz;
+        if (m_block_size == 64) {
+            process_block(m_block);
+            m_block_size = 0;
+        }
+    }
+}
+
+sha256_digest sha256::finalize() {
+    uint64 num_bits = m_length * 8;
+    char pad = static_cast<char>(0x80);
+    update(&pad, 1);
+    char zero = 0;
+    while (m_block_size != 56)
+        update(&zero, 1);
+    char len[8];
+    for (unsigned i = 0; i < 8; i++)
+        len[i] = static_cast<char>((num_bits >> (56 - 8*i)) & 0xff);
+    update(len, 8);
+    lean_assert(m_block_size == 0);
+    sha256_digest r;
+    for (unsigned i = 0; i < 8; i++) {
+        r.m_data[4*i]   = static_cast<unsigned char>(m_state[i] >> 24);
+        r.m_data[4*i+1] = static_cast<unsigned char>(m_state[i] >> 16);
+        r.m_data[4*i+2] = static_cast<unsigned char>(m_state[i] >> 8);
+        r.m_data[4*i+3] = static_cast<unsigned char>(m_state[i]);
+    }
+    return r;
+}
+
+std::string sha256_digest::to_string() const {
+    static char const * g_hex = "0123456789abcdef";
+    std::string r;
+    for (unsigned char c : m_data) {
+        r += g_hex[c >> 4];
+        r += g_hex[c & 0xf];
+    }
+    return r;
+}
+
+sha256_digest mk_sha256(char const * begin, char const * end) {
+    sha256 h;
+    h.update(begin, end - begin);
+    return h.finalize();
+}
+}
@@ -0,0 +1,49 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <string>
+#include <cstring>
+#include "util/int64.h"
+
+namespace lean {
+/** \brief SHA-256 digest (FIPS 180-4). */
+struct sha256_digest {
+    unsigned char m_data[32];
+    sha256_digest() { std::memset(m_data, 0, sizeof(m_data)); }
+    /** \brief Hash code for hash tables, it is just a prefix of the digest. */
+    unsigned hash() const {
+        return
+            (static_cast<unsigned>(m_data[0]) << 24) | (static_cast<unsigned>(m_data[1]) << 16) |
+            (static_cast<unsigned>(m_data[2]) << 8)  | static_cast<unsigned>(m_data[3]);
+    }
+    friend bool operator==(sha256_digest const & d1, sha256_digest const & d2) {
+        return std::memcmp(d1.m_data, d2.m_data, sizeof(d1.m_data)) == 0;
+    }
+    friend bool operator!=(sha256_digest const & d1, sha256_digest const & d2) { return !(d1 == d2); }
+    /** \brief Return the hexadecimal representation of the digest. */
+    std::string to_string() const;
+};
+
+/** \brief Incremental SHA-256 computation. */
+class sha256 {
+    unsigned      m_state[8];
+    unsigned char m_block[64];
+    unsigned      m_block_size;
+    uint64        m_length; // number of bytes processed so far
+    void process_block(unsigned char const * block);
+public:
+    sha256();
+    void update(char const * data, size_t n);
+    void update(sha256_digest const & d) { update(reinterpret_cast<char const *>(d.m_data), sizeof(d.m_data)); }
+    /** \brief Return the digest of the data provided so far.
+        \remark This object must not be used after this method is invoked. */
+    sha256_digest finalize();
+};
+
+/** \brief Return the SHA-256 digest of the memory region <tt>[begin, end)</tt>. */
+sha256_digest mk_sha256(char const * begin, char const * end);
+}
@@ -0,0 +1,284 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <utility>
+#include "util/task_scheduler.h"
+
+namespace lean {
+#if defined(LEAN_MULTI_THREAD)
+work_stealing_deque::array::array(unsigned log_size):
+    m_log_size(log_size), m_buffer(new atomic<scheduler_task *>[static_cast<size_t>(1) << log_size]) {}
+
+work_stealing_deque::work_stealing_deque(unsigned log_initial_size):
+    m_top(0), m_bottom(0) {
+    m_arrays.push_back(std::unique_ptr<array>(new array(log_initial_size)));
+    m_array.store(m_arrays.back().get(), memory_order_relaxed);
+}
+
+work_stealing_deque::~work_stealing_deque() {
+    array * a = m_array.load(memory_order_relaxed);
+    for (int64 i = m_top.load(memory_order_relaxed); i < m_bottom.load(memory_order_relaxed); i++)
+        delete a->get(i);
+}
+
+void work_stealing_deque::push(scheduler_task * t) {
+    int64 b  = m_bottom.load(memory_order_relaxed);
+    int64 tp = m_top.load(memory_order_acquire);
+    array * a = m_array.load(memory_order_relaxed);
+    if (b - tp > a->size() - 1) {
+        // queue is full, copy elements to a bigger array
+        array * new_a = new array(a->m_log_size + 1);
+        for (int64 i = tp; i < b; i++)
+            new_a->put(i, a->get(i));
+        m_arrays.push_back(std::unique_ptr<array>(new_a));
+        m_array.store(new_a, memory_order_release);
+        a = new_a;
+    }
+    a->put(b, t);
+    // release: a thief that observes the new bottom must also observe the task
+    m_bottom.store(b + 1, memory_order_release);
+}
+
+scheduler_task * work_stealing_deque::pop() {
+    int64 b   = m_bottom.load(memory_order_relaxed) - 1;
+    array * a = m_array.load(memory_order_relaxed);
+    m_bottom.store(b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64 tp  = m_top.load(memory_order_relaxed);
+    if (tp <= b) {
+        scheduler_task * r = a->get(b);
+        if (tp == b) {
+            // last element, we must compete with thieves
+            if (!m_top.compare_exchange_strong(tp, tp + 1, memory_order_seq_cst, memory_order_relaxed))
+                r = nullptr;
+            m_bottom.store(b + 1, memory_order_relaxed);
+        }
+        return r;
+    } else {
+        // queue is empty
+        m_bottom.store(b + 1, memory_order_relaxed);
+        return nullptr;
+    }
+}
+
+scheduler_task * work_stealing_deque::steal() {
+    int64 tp = m_top.load(memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64 b  = m_bottom.load(memory_order_acquire);
+    if (tp < b) {
+        array * a = m_array.load(memory_order_acquire);
+        scheduler_task * r = a->get(tp);
+        if (!m_top.compare_exchange_strong(tp, tp + 1, memory_order_seq_cst, memory_order_relaxed))
+            return nullptr; // lost the race
+        return r;
+    }
+    return nullptr;
+}
+
+bool work_stealing_deque::empty() const {
+    return m_bottom.load(memory_order_relaxed) <= m_top.load(memory_order_relaxed);
+}
+#endif
+
+// Scheduler and worker index associated with the current thread.
+LEAN_THREAD_PTR(task_scheduler, g_scheduler);
+LEAN_THREAD_VALUE(unsigned, g_worker_idx, 0);
+
+/** \brief Auxiliary object for setting (and restoring) the scheduler associated with the current thread. */
+class scoped_worker {
+    task_scheduler * m_old_scheduler;
+    unsigned         m_old_idx;
+public:
+    scoped_worker(task_scheduler * s, unsigned idx):m_old_scheduler(g_scheduler), m_old_idx(g_worker_idx) {
+        g_scheduler  = s;
+        g_worker_idx = idx;
+    }
+    ~scoped_worker() {
+        g_scheduler  = m_old_scheduler;
+        g_worker_idx = m_old_idx;
+    }
+};
+
+task_scheduler::task_scheduler(unsigned num_threads, std::function<void()> const & init):
+    m_num_shared(0), m_num_queued(0), m_num_pending(0), m_num_idle(0),
+    m_joining(false), m_done(false), m_failed(false), m_interrupted(false) {
+#ifndef LEAN_MULTI_THREAD
+    num_threads = 0;
+#endif
+    for (unsigned i = 0; i <= num_threads; i++)
+        m_workers.push_back(std::unique_ptr<worker>(new worker(i + 1)));
+    for (unsigned i = 1; i <= num_threads; i++) {
+        m_threads.push_back(thread_ptr(new interruptible_thread([=]() {
+                        scoped_worker set(this, i);
+                        try {
+                            init();
+                            process_tasks(i);
+                        } catch (interrupted &) {
+                        } catch (throwable & ex) {
+                            set_exception(ex);
+                        } catch (...) {
+                            set_exception(exception("task scheduler thread failed for unknown reasons"));
+                        }
+                    })));
+    }
+}
+
+task_scheduler::~task_scheduler() {
+    if (!m_done) {
+        m_interrupted = true;
+        join_threads();
+    }
+    for (scheduler_task * t : m_shared_tasks)
+        delete t;
+}
+
+void task_scheduler::add(scheduler_task const & t) {
+    lean_assert(!m_done);
+    scheduler_task * new_t = new scheduler_task(t);
+    m_num_pending++;
+    if (g_scheduler == this) {
+        m_workers[g_worker_idx]->m_deque.push(new_t);
+    } else {
+        lock_guard<mutex> lk(m_shared_mutex);
+        m_shared_tasks.push_back(new_t);
+        m_num_shared++;
+    }
+    m_num_queued++;
+    if (m_num_idle > 0) {
+        lock_guard<mutex> lk(m_idle_mutex);
+        m_idle_cv.notify_one();
+    }
+}
+
+scheduler_task * task_scheduler::steal_task(unsigned widx) {
+    unsigned n = m_workers.size();
+    if (n == 1)
+        return nullptr;
+    unsigned & seed = m_workers[widx]->m_seed;
+    for (unsigned k = 0; k < 2 * n; k++) {
+        // xorshift
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        unsigned victim = seed % n;
+        if (victim == widx)
+            continue;
+        if (scheduler_task * t = m_workers[victim]->m_deque.steal())
+            return t;
+    }
+    return nullptr;
+}
+
+scheduler_task * task_scheduler::next_task(unsigned widx) {
+    scheduler_task * r = m_workers[widx]->m_deque.pop();
+    if (!r && m_num_shared > 0) {
+        lock_guard<mutex> lk(m_shared_mutex);
+        if (!m_shared_tasks.empty()) {
+            r = m_shared_tasks.front();
+            m_shared_tasks.pop_front();
+            m_num_shared--;
+        }
+    }
+    if (!r)
+        r = steal_task(widx);
+    if (r)
+        m_num_queued--;
+    return r;
+}
+
+bool task_scheduler::stop() const {
+    return m_failed || m_interrupted || (m_joining && m_num_pending == 0);
+}
+
+void task_scheduler::wakeup_all() {
+    lock_guard<mutex> lk(m_idle_mutex);
+    m_idle_cv.notify_all();
+}
+
+void task_scheduler::interrupt_workers() {
+    for (thread_ptr & th : m_threads)
+        th->request_interrupt();
+    wakeup_all();
+}
+
+void task_scheduler::set_exception(throwable const & ex) {
+    {
+        lock_guard<mutex> lk(m_shared_mutex);
+        if (m_failed)
+            return; // we only keep the first exception
+        m_exception.reset(ex.clone());
+        m_failed = true;
+    }
+    interrupt_workers();
+}
+
+void task_scheduler::execute(scheduler_task * t) {
+    std::unique_ptr<scheduler_task> t_ptr(t);
+    try {
+        (*t)();
+    } catch (interrupted &) {
+        m_interrupted = true;
+        interrupt_workers();
+    } catch (throwable & ex) {
+        set_exception(ex);
+    } catch (...) {
+        set_exception(exception("task failed for unknown reasons"));
+    }
+    if (--m_num_pending == 0 && m_joining)
+        wakeup_all();
+}
+
+void task_scheduler::wait_for_tasks() {
+    unique_lock<mutex> lk(m_idle_mutex);
+    m_num_idle++;
+    if (m_num_queued <= 0 && !stop())
+        m_idle_cv.wait_for(lk, chrono::milliseconds(g_small_sleep));
+    m_num_idle--;
+}
+
+void task_scheduler::process_tasks(unsigned widx) {
+    while (!m_failed && !m_interrupted) {
+        check_interrupted();
+        if (scheduler_task * t = next_task(widx))
+            execute(t);
+        else if (stop())
+            return;
+        else
+            wait_for_tasks();
+    }
+}
+
+void task_scheduler::join_threads() {
+    if (m_failed || m_interrupted) {
+        for (thread_ptr & th : m_threads)
+            th->request_interrupt();
+    }
+    wakeup_all();
+    for (thread_ptr & th : m_threads)
+        th->join();
+    m_done = true;
+}
+
+void task_scheduler::join() {
+    lean_assert(!m_joining);
+    m_joining = true;
+    wakeup_all();
+    try {
+        scoped_worker set(this, 0);
+        process_tasks(0);
+    } catch (interrupted &) {
+        m_interrupted = true;
+    }
+    join_threads();
+    if (m_failed)
+        m_exception->rethrow();
+    if (m_interrupted)
+        throw interrupted();
+}
+
+void task_scheduler::interrupt() {
+    m_interrupted = true;
+    interrupt_workers();
+}
+}
@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <memory>
+#include <functional>
+#include <vector>
+#include <deque>
+#include "util/debug.h"
+#include "util/thread.h"
+#include "util/interrupt.h"
+#include "util/exception.h"
+#include "util/int64.h"
+
+namespace lean {
+typedef std::function<void()> scheduler_task;
+
+#if defined(LEAN_MULTI_THREAD)
+/**
+   \brief Double ended queue for work stealing.
+   The owner thread pushes and pops tasks at the bottom, and other threads steal tasks from the top.
+   Only \c steal may be invoked by threads that are not the owner, and it does not take any lock.
+
+   The implementation is based on the paper
+   "Correct and Efficient Work-Stealing for Weak Memory Models", Le, Pop, Cohen and Zappa Nardelli, PPoPP 2013.
+*/
+class work_stealing_deque {
+    struct array {
+        unsigned                                      m_log_size;
+        std::unique_ptr<atomic<scheduler_task *>[]>   m_buffer;
+        array(unsigned log_size);
+        int64 size() const { return static_cast<int64>(1) << m_log_size; }
+        scheduler_task * get(int64 i) const { return m_buffer[i & (size() - 1)].load(memory_order_relaxed); }
+        void put(int64 i, scheduler_task * t) { m_buffer[i & (size() - 1)].store(t, memory_order_relaxed); }
+    };
+    atomic<int64>                        m_top;
+    atomic<int64>                        m_bottom;
+    atomic<array *>                      m_array;
+    // Arrays replaced when the deque grows. They are only deleted when the deque is destroyed
+    // because a concurrent thief may still be reading them.
+    std::vector<std::unique_ptr<array>>  m_arrays;
+public:
+    work_stealing_deque(unsigned log_initial_size = 8);
+    ~work_stealing_deque();
+    /** \brief Add task to the bottom of the queue. Only the owner can invoke this method. */
+    void push(scheduler_task * t);
+    /** \brief Remove task from the bottom of the queue. Only the owner can invoke this method. */
+    scheduler_task * pop();
+    /** \brief Remove task from the top of the queue. Return nullptr if the queue is empty or if
+        the steal lost a race with the owner or another thief. */
+    scheduler_task * steal();
+    bool empty() const;
+};
+#else
+class work_stealing_deque {
+    std::deque<scheduler_task *> m_tasks;
+public:
+    work_stealing_deque(unsigned = 8) {}
+    ~work_stealing_deque() { for (scheduler_task * t : m_tasks) delete t; }
+    void push(scheduler_task * t) { m_tasks.push_back(t); }
+    scheduler_task * pop() {
+        if (m_tasks.empty()) return nullptr;
+        scheduler_task * r = m_tasks.back(); m_tasks.pop_back(); return r;
+    }
+    scheduler_task * steal() {
+        if (m_tasks.empty()) return nullptr;
+        scheduler_task * r = m_tasks.front(); m_tasks.pop_front(); return r;
+    }
+    bool empty() const { return m_tasks.empty(); }
+};
+#endif
+
+/**
+   \brief Work stealing task scheduler.
+
+   Each worker has its own deque. Tasks created by a worker are pushed into its own deque,
+   and are executed in LIFO order by this worker. Idle workers steal tasks (in FIFO order)
+   from other workers. Tasks created by threads that are not workers of this scheduler
+   (e.g., the main thread before \c join is invoked) are stored in a shared queue.
+
+   The thread that invokes \c join also executes tasks until all of them have been processed.
+   Thus, a scheduler with zero worker threads executes all tasks in the thread that invokes \c join.
+
+   If a task throws an exception, the remaining tasks are discarded, the workers are interrupted,
+   and the exception is rethrown by \c join.
+*/
+class task_scheduler {
+    typedef std::unique_ptr<interruptible_thread> thread_ptr;
+    struct worker {
+        work_stealing_deque m_deque;
+        unsigned            m_seed; // used to select victims
+        worker(unsigned seed):m_seed(seed) {}
+    };
+    std::vector<std::unique_ptr<worker>> m_workers; // m_workers[0] is used by the thread executing join
+    std::vector<thread_ptr>              m_threads;
+    mutex                                m_shared_mutex;
+    std::deque<scheduler_task *>         m_shared_tasks; // tasks created by non-worker threads
+    atomic<unsigned>                     m_num_shared;  // size of m_shared_tasks
+    // Number of tasks waiting to be executed. It may be temporarily negative since
+    // it is only incremented after the task is added to a queue.
+    atomic<int>                          m_num_queued;
+    atomic<unsigned>                     m_num_pending; // number of tasks that were not finished yet
+    mutex                                m_idle_mutex;
+    condition_variable                   m_idle_cv;
+    atomic<unsigned>                     m_num_idle;
+    atomic<bool>                         m_joining;
+    atomic<bool>                         m_done;
+    atomic<bool>                         m_failed;
+    atomic<bool>                         m_interrupted;
+    std::unique_ptr<throwable>           m_exception;
+
+    scheduler_task * next_task(unsigned widx);
+    scheduler_task * steal_task(unsigned widx);
+    bool stop() const;
+    void execute(scheduler_task * t);
+    void process_tasks(unsigned widx);
+    void wait_for_tasks();
+    void wakeup_all();
+    void interrupt_workers();
+    void set_exception(throwable const & ex);
+    void join_threads();
+public:
+    /** \brief Create a scheduler with \c num_threads worker threads, each one executes \c init before processing tasks. */
+    task_scheduler(unsigned num_threads, std::function<void()> const & init);
+    task_scheduler(unsigned num_threads):task_scheduler(num_threads, [](){}) {}
+    ~task_scheduler();
+
+    /** \brief Add a new task. It can be invoked by any thread, including tasks running in this scheduler. */
+    void add(scheduler_task const & t);
+    /** \brief Execute tasks in the current thread until all tasks (including the ones created by other
+        tasks) have been processed, and terminate the worker threads.
+        \remark It can only be invoked once. */
+    void join();
+    /** \brief Interrupt all worker threads. \c join throws \c interrupted. */
+    void interrupt();
+
+    bool done() const { return m_done; }
+    unsigned get_num_threads() const { return m_threads.size(); }
+};
+}
@@ -0,0 +1,201 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include "util/thread_pool.h"
+
+namespace lean {
+#if defined(LEAN_MULTI_THREAD)
+class thread_pool {
+    struct worker {
+        std::unique_ptr<interruptible_thread> m_thread;
+        condition_variable                    m_cv;
+        job_group *                           m_group; // job assigned to this worker
+        job_group::job *                      m_job;
+        worker():m_group(nullptr), m_job(nullptr) {}
+    };
+    mutex                                m_mutex;
+    std::vector<std::unique_ptr<worker>> m_workers;
+    std::vector<worker *>                m_idle;
+    bool                                 m_shutdown;
+
+    void run(worker * w) {
+        unique_lock<mutex> lk(m_mutex);
+        while (true) {
+            while (!w->m_job && !m_shutdown)
+                w->m_cv.wait(lk);
+            if (!w->m_job)
+                return;
+            job_group * g     = w->m_group;
+            job_group::job * j = w->m_job;
+            w->m_group = nullptr;
+            w->m_job   = nullptr;
+            lk.unlock();
+            g->execute(*j, *w->m_thread);
+            lk.lock();
+            m_idle.push_back(w);
+        }
+    }
+
+public:
+    thread_pool():m_shutdown(false) {}
+
+    ~thread_pool() {
+        {
+            lock_guard<mutex> lk(m_mutex);
+            m_shutdown = true;
+            for (auto & w : m_workers)
+                w->m_cv.notify_one();
+        }
+        for (auto & w : m_workers)
+            w->m_thread->join();
+    }
+
+    void submit(job_group & g, job_group::job & j) {
+        lock_guard<mutex> lk(m_mutex);
+        if (!m_idle.empty()) {
+            worker * w = m_idle.back();
+            m_idle.pop_back();
+            w->m_group = &g;
+            w->m_job   = &j;
+            w->m_cv.notify_one();
+        } else {
+            worker * w = new worker();
+            m_workers.push_back(std::unique_ptr<worker>(w));
+            w->m_group = &g;
+            w->m_job   = &j;
+            // Remark: the new thread can only access w after we release m_mutex
+            w->m_thread.reset(new interruptible_thread([=]() { run(w); }));
+        }
+    }
+};
+
+static mutex         g_thread_pool_mutex;
+static thread_pool * g_thread_pool = nullptr;
+
+static thread_pool & get_thread_pool() {
+    lock_guard<mutex> lk(g_thread_pool_mutex);
+    if (!g_thread_pool)
+        g_thread_pool = new thread_pool();
+    return *g_thread_pool;
+}
+
+void finalize_thread_pool() {
+    thread_pool * p;
+    {
+        lock_guard<mutex> lk(g_thread_pool_mutex);
+        p = g_thread_pool;
+        g_thread_pool = nullptr;
+    }
+    delete p;
+}
+
+job_group::job_group():m_num_done(0) {}
+
+job_group::~job_group() {
+    interrupt();
+    wait_all();
+}
+
+void job_group::execute(job & j, interruptible_thread & th) {
+    bool cancelled;
+    {
+        lock_guard<mutex> lk(m_mutex);
+        cancelled = j.m_interrupted;
+        if (!cancelled) {
+            j.m_status = job_status::Running;
+            j.m_thread = &th;
+        }
+    }
+    if (!cancelled) {
+        try {
+            j.m_fn();
+        } catch (...) {
+        }
+    }
+    lock_guard<mutex> lk(m_mutex);
+    j.m_status = job_status::Done;
+    j.m_thread = nullptr;
+    m_num_done++;
+    // Interrupt requests are only sent to running jobs, so we can safely reset the flag
+    // before the thread is reused.
+    reset_interrupt();
+    // Remark: the owner may destroy this object as soon as we release m_mutex.
+    m_cv.notify_all();
+}
+
+void job_group::add(std::function<void()> const & fn) {
+    job * j = new job(fn);
+    {
+        lock_guard<mutex> lk(m_mutex);
+        m_jobs.push_back(std::unique_ptr<job>(j));
+    }
+    get_thread_pool().submit(*this, *j);
+}
+
+unsigned job_group::num_done() {
+    lock_guard<mutex> lk(m_mutex);
+    return m_num_done;
+}
+
+bool job_group::is_done(unsigned i) {
+    lock_guard<mutex> lk(m_mutex);
+    return m_jobs[i]->m_status == job_status::Done;
+}
+
+unsigned job_group::wait(unsigned k, unsigned check_ms) {
+    if (check_ms == 0)
+        check_ms = 1;
+    unique_lock<mutex> lk(m_mutex);
+    k = std::min(k, size());
+    while (m_num_done < k) {
+        m_cv.wait_for(lk, chrono::milliseconds(check_ms));
+        check_interrupted();
+    }
+    return m_num_done;
+}
+
+unsigned job_group::wait_for(unsigned k, unsigned ms, unsigned check_ms) {
+    if (check_ms == 0)
+        check_ms = 1;
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(ms);
+    unique_lock<mutex> lk(m_mutex);
+    k = std::min(k, size());
+    while (m_num_done < k) {
+        auto curr = chrono::steady_clock::now();
+        if (curr >= deadline)
+            break;
+        auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - curr) + chrono::milliseconds(1);
+        m_cv.wait_for(lk, std::min(remaining, chrono::milliseconds(check_ms)));
+        check_interrupted();
+    }
+    return m_num_done;
+}
+
+void job_group::wait_all() {
+    unique_lock<mutex> lk(m_mutex);
+    while (m_num_done < size())
+        m_cv.wait(lk);
+}
+
+void job_group::interrupt() {
+    lock_guard<mutex> lk(m_mutex);
+    for (auto & j : m_jobs) {
+        if (j->m_status == job_status::Pending)
+            j->m_interrupted = true;
+        else if (j->m_status == job_status::Running)
+            j->m_thread->request_interrupt();
+    }
+}
+
+unsigned hardware_concurrency() {
+    return std::max(thread::hardware_concurrency(), 1u);
+}
+#else
+void finalize_thread_pool() {}
+unsigned hardware_concurrency() { return 1; }
+#endif
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <memory>
+#include <vector>
+#include <functional>
+#include "util/thread.h"
+#include "util/interrupt.h"
+
+namespace lean {
+#if defined(LEAN_MULTI_THREAD)
+class thread_pool;
+/**
+   \brief Set of jobs executed by a global pool of interruptible threads.
+
+   Threads are not destroyed when a job terminates, they wait for new jobs.
+   A new thread is only created when all threads in the pool are busy.
+   Thus, a job is never delayed by other jobs, and jobs may create new job groups
+   and wait for them without producing deadlocks.
+
+   The owner of the group is notified (using a condition variable) as soon as
+   a job terminates. The \c check_ms arguments are only used to specify how often
+   the owner checks whether it has been interrupted while waiting.
+
+   \remark The destructor interrupts the jobs that have not finished, and waits for them.
+*/
+class job_group {
+    friend class thread_pool;
+    enum class job_status { Pending, Running, Done };
+    struct job {
+        std::function<void()>  m_fn;
+        job_status             m_status;
+        interruptible_thread * m_thread; // thread executing the job
+        bool                   m_interrupted;
+        job(std::function<void()> const & fn):m_fn(fn), m_status(job_status::Pending), m_thread(nullptr), m_interrupted(false) {}
+    };
+    mutex                             m_mutex;
+    condition_variable                m_cv;
+    std::vector<std::unique_ptr<job>> m_jobs;
+    unsigned                          m_num_done;
+    void execute(job & j, interruptible_thread & th);
+public:
+    job_group();
+    ~job_group();
+    /** \brief Execute \c fn in a thread of the pool. */
+    void add(std::function<void()> const & fn);
+    unsigned size() const { return m_jobs.size(); }
+    /** \brief Return the number of jobs that have terminated. */
+    unsigned num_done();
+    /** \brief Return true iff the i-th job (in the order they were added) has terminated. */
+    bool is_done(unsigned i);
+    /**
+        \brief Wait until at least \c k jobs have terminated, and return the number of terminated jobs.
+        \remark It throws \c interrupted if the current thread is interrupted while waiting.
+    */
+    unsigned wait(unsigned k, unsigned check_ms = g_small_sleep);
+    /**
+        \brief Similar to \c wait, but give up after \c ms milliseconds.
+        Then, the result may be smaller than \c k.
+    */
+    unsigned wait_for(unsigned k, unsigned ms, unsigned check_ms = g_small_sleep);
+    /** \brief Wait for all jobs in this group. */
+    void wait_all();
+    /** \brief Interrupt the jobs that have not terminated. Jobs that have not started are never executed. */
+    void interrupt();
+};
+#endif
+
+/** \brief Return the number of concurrent threads supported by the hardware (at least 1). */
+unsigned hardware_concurrency();
+
+/**
+   \brief Terminate the threads in the global pool. It should be invoked when there are no active jobs.
+   \remark The pool is created on demand.
+*/
+void finalize_thread_pool();
+}
@@ -126,6 +126,13 @@ public:
         return m_ptr ? m_ptr->m_children.find(k) : nullptr;
     }
 
+    /** \brief Apply \c f to each key and child of the root node. */
+    template<typename F>
+    void for_each_child(F && f) const {
+        if (m_ptr)
+            m_ptr->m_children.for_each(f);
+    }
+
     Val const * value() const {
         if (m_ptr && m_ptr->m_value)
             return &m_ptr->m_value.value();
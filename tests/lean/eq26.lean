@@ -0,0 +1,40 @@
+inductive color :=
+red | green | blue | cyan | magenta | yellow | black | white
+
+open color
+
+set_option eqn_compiler.trace true
+
+definition mix : color → color → color
+| mix red   green := yellow
+| mix red   blue  := magenta
+| mix green blue  := cyan
+| mix a     b     := white
+
+example : mix red green = yellow :=
+rfl
+
+example : mix green blue = cyan :=
+rfl
+
+example : mix blue red = white :=
+rfl
+
+example : mix red red = white :=
+rfl
+
+set_option eqn_compiler.max_sharing false
+
+definition mix2 : color → color → color
+| mix2 black b     := black
+| mix2 a     black := black
+| mix2 a     b     := white
+
+example : mix2 black red = black :=
+rfl
+
+example : mix2 red black = black :=
+rfl
+
+example : mix2 red red = white :=
+rfl
@@ -0,0 +1,3 @@
+theorem t1 (A : Type) (a : A) : A := a
+
+theorem t2 (A : Type) (a : A) : A := a
@@ -0,0 +1,27 @@
+import logic
+open num
+
+structure foo [class] (A : Type) :=
+(x : A)
+
+structure bar [class] (A : Type) :=
+(y : A)
+
+definition foo_of_bar [instance] (A : Type) [H : bar A] : foo A :=
+foo.mk (@bar.y A H)
+
+definition bar_num [instance] : bar num :=
+bar.mk 0
+
+-- bar_of_foo is tried before bar_num, and produces the loop foo num => bar num => foo num
+definition bar_of_foo [instance] (A : Type) [H : foo A] : bar A :=
+bar.mk (@foo.x A H)
+
+definition get (A : Type) [H : foo A] : A :=
+@foo.x A H
+
+example : get num = 0 :=
+rfl
+
+example : get num = get num :=
+rfl
@@ -0,0 +1,18 @@
+import logic
+open tactic
+
+theorem tst1 {A B : Prop} (H1 : A) (H2 : B) : A ∧ B ∧ A :=
+by portfolio [fail, repeat (apply and.intro)]; !assumption
+
+theorem tst2 {A B : Prop} (H1 : A) (H2 : B) : A ∧ B :=
+begin
+  portfolio [fail, apply and.intro, exact (and.intro H1 H2)],
+  repeat assumption
+end
+
+check tst1
+check tst2
+
+-- portfolio is not a keyword
+definition portfolio {A : Type} (a : A) : A := a
+check @portfolio
@@ -0,0 +1,19 @@
+import data.nat data.list
+open nat list
+
+definition fib : nat → nat
+| fib 0     := 1
+| fib 1     := 1
+| fib (n+2) := fib (n+1) + fib n
+
+eval [vm] fib 10
+eval [vm] length (map succ [1, 2, 3])
+eval [vm] λ x : nat, x + 2
+
+set_option elaborator.use_vm true
+
+example : fib 10 = 89 :=
+rfl
+
+example : length (map succ [1, 2, 3, 4]) = 4 :=
+rfl
@@ -0,0 +1,39 @@
+local env = environment()
+env = add_decl(env, mk_constant_assumption("A", Type))
+local A = Const("A")
+env = add_decl(env, mk_constant_assumption("a", A))
+local a = Const("a")
+env = add_decl(env, mk_definition("f", A, a, {opaque=false, weight=3}))
+env = add_decl(env, mk_definition("g", A, Const("f"), {opaque=true, weight=7}))
+env = add_decl(env, mk_constant_assumption("P", mk_arrow(A, Prop)))
+local P = Const("P")
+env = add_decl(env, mk_axiom("H1", P(a)))
+env = add_decl(env, mk_theorem("H2", P(a), Const("H1")))
+env:export("mod7_mod.olean")
+
+function check_env(env2, keep_proofs)
+   assert(env2:get("A"):is_constant_assumption())
+   assert(env2:get("a"):type() == A)
+   assert(env2:get("f"):is_definition())
+   assert(not env2:get("f"):opaque())
+   assert(env2:get("f"):weight() == 3)
+   assert(env2:get("f"):value() == a)
+   assert(env2:get("g"):opaque())
+   assert(env2:get("g"):weight() == 7)
+   assert(env2:get("g"):value() == Const("f"))
+   assert(env2:get("H1"):is_axiom())
+   if keep_proofs then
+      assert(env2:get("H2"):is_theorem())
+      assert(env2:get("H2"):value() == Const("H1"))
+   else
+      assert(env2:get("H2"):is_axiom())
+   end
+end
+
+check_env(import_modules("mod7_mod.olean", {keep_proofs=true}), true)
+check_env(import_modules("mod7_mod.olean"), false)
+check_env(import_modules("mod7_mod.olean", {num_threads=4, keep_proofs=true}), true)
+-- lazy import, the values are decoded on demand
+local ios = io_state()
+ios:set_options(options():update(name('import', 'lazy'), true))
+check_env(import_modules(environment(10000), "mod7_mod.olean", {keep_proofs=true}, ios), true)
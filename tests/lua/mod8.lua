@@ -0,0 +1,25 @@
+-- mod8_v1.olean was produced using the legacy (version 1) .olean format
+local A = Const("A")
+local a = Const("a")
+local P = Const("P")
+function check_env(env, keep_proofs)
+   assert(env:get("A"):type() == Type)
+   assert(env:get("a"):type() == A)
+   assert(env:get("f"):is_definition())
+   assert(not env:get("f"):opaque())
+   assert(env:get("f"):weight() == 3)
+   assert(env:get("f"):value() == a)
+   assert(env:get("P"):type() == mk_arrow(A, Prop))
+   assert(env:get("H1"):is_axiom())
+   assert(env:get("H1"):type() == P(a))
+   if keep_proofs then
+      assert(env:get("H2"):is_theorem())
+      assert(env:get("H2"):value() == Const("H1"))
+   else
+      assert(env:get("H2"):is_axiom())
+   end
+end
+
+check_env(import_modules("mod8_v1.olean", {keep_proofs=true}), true)
+check_env(import_modules("mod8_v1.olean"), false)
+check_env(import_modules("mod8_v1.olean", {num_threads=4, keep_proofs=true}), true)